@@ -1055,6 +1055,7 @@ static void Music_RunLoop(void) {
 		String_Format1(&path, "audio/%s", &file);
 		Platform_Log1("playing music file: %s", &file);
 
+		/* Not mapped, since the file stays open for the whole song, and could be replaced while playing */
 		res = Stream_OpenFile(&stream, &path);
 		if (res) { Logger_SysWarn2(res, "opening", &path); break; }
 
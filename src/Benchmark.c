@@ -0,0 +1,719 @@
+#include "Core.h"
+/* Standalone program for measuring the compression, decompression and hashing code on synthetic data,
+    how fast the world's blocks are accessed when meshing chunks and ticking physics, and how fast maps are saved.
+   Built with 'make bench', which links it with only the modules being measured (see the stubs below).
+   'make bench-tiled' builds it with CC_BUILD_TILEDWORLD instead, to compare the two blocks layouts.
+   Only compiled when CC_BUILD_BENCHMARK is defined.
+   Results are printed as CSV (kernel,bytes,runs,mb_per_s,ns_per_byte), with one line per kernel.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+#ifdef CC_BUILD_BENCHMARK
+#include "String.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "Deflate.h"
+#include "Bitmap.h"
+#include "BlockID.h"
+#include "Drawer2D.h"
+#include "ExtMath.h"
+#include "Funcs.h"
+#include "Logger.h"
+#include "Errors.h"
+#include "Utils.h"
+#include "World.h"
+#include "Block.h"
+#include "Constants.h"
+#include "Game.h"
+#include "Entity.h"
+#include "Picking.h"
+#include "Physics.h"
+#include "Inventory.h"
+#include "TexturePack.h"
+#include "Window.h"
+#include "Formats.h"
+#include "Server.h"
+
+#define BENCH_MAP_WIDTH  256
+#define BENCH_MAP_HEIGHT 64
+#define BENCH_MAP_LENGTH 256
+#define BENCH_MAP_SIZE   (BENCH_MAP_WIDTH * BENCH_MAP_HEIGHT * BENCH_MAP_LENGTH)
+#define BENCH_MAP_WATER  (BENCH_MAP_HEIGHT / 2)
+#define BENCH_IMAGE_SIZE 512
+#define BENCH_IMAGE_BYTES (BENCH_IMAGE_SIZE * BENCH_IMAGE_SIZE * 4)
+/* Compressed output of noisy data can end up slightly larger than the input */
+#define BENCH_OUTPUT_SIZE (BENCH_MAP_SIZE + BENCH_MAP_SIZE / 8)
+#define BENCH_NOISE_SIZE  8195
+/* Each kernel is repeated until it has run for at least this long */
+#define BENCH_MIN_MICROSECONDS (500 * 1000)
+
+#ifdef CC_BUILD_TILEDWORLD
+#define BENCH_LAYOUT "tiled"
+#else
+#define BENCH_LAYOUT "linear"
+#endif
+
+static BlockRaw* bench_map;
+static struct Bitmap bench_image;
+/* CRC32 of the map, calculated a byte at a time to check the optimised version against */
+static cc_uint32 bench_mapCrc;
+static cc_uint8* bench_output;
+static cc_uint32 bench_outputLen;
+/* Incompressible data for the deflate round trip kernel, and what it inflates back to */
+static cc_uint8 bench_noise[BENCH_NOISE_SIZE];
+static cc_uint8 bench_inflated[BENCH_NOISE_SIZE];
+
+/* Precompressed data for the decompression kernels */
+static cc_uint8* bench_deflated; static cc_uint32 bench_deflatedLen;
+static cc_uint8* bench_png;      static cc_uint32 bench_pngLen;
+static cc_uint8* bench_zip;      static cc_uint32 bench_zipLen;
+
+static struct DeflateState bench_deflate;
+static struct GZipState    bench_gzip;
+static struct ZLibState    bench_zlib;
+static struct InflateState bench_inflate;
+static struct ZipState     bench_zipState;
+static cc_uint32 bench_extracted;
+
+/* Chunk being meshed, including the blocks bordering it */
+static BlockID bench_chunk[18 * 18 * 18];
+/* Stops the compiler from optimising away the block reads in the world kernels */
+static cc_uint32 bench_worldResult;
+/* Number of bytes written by Cw_Save, before being compressed */
+static cc_uint32 bench_savedLen;
+static struct Stream* bench_saveDest;
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Stubs---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Only the measured modules and the platform backend are linked into the benchmark, */
+/*  so simpler versions of the few other functions they call are provided here instead */
+static void Bench_Warn(const cc_string* msg) { Platform_Log(msg->buffer, msg->length); }
+Logger_DoWarn Logger_WarnFunc = Bench_Warn;
+
+void Logger_SysWarn(cc_result res, const char* action) {
+	cc_string msg; char msgBuffer[256];
+	String_InitArray(msg, msgBuffer);
+	String_Format2(&msg, "Error %h when %c", &res, action);
+	Logger_WarnFunc(&msg);
+}
+
+void Logger_SysWarn2(cc_result res, const char* action, const cc_string* path) {
+	cc_string msg; char msgBuffer[256];
+	String_InitArray(msg, msgBuffer);
+	String_Format3(&msg, "Error %h when %c '%s'", &res, action, path);
+	Logger_WarnFunc(&msg);
+}
+
+void Logger_Abort2(cc_result result, const char* raw_msg) {
+	cc_string msg; char msgBuffer[256];
+	String_InitArray(msg, msgBuffer);
+	String_Format2(&msg, "ERROR: %c (%h)", raw_msg, &result);
+	Logger_WarnFunc(&msg);
+	Process_Exit(result ? result : 1);
+}
+void Logger_Abort(const char* raw_msg) { Logger_Abort2(0, raw_msg); }
+
+void SysFonts_Register(const cc_string* path) { }
+
+void Window_ShowDialog(const char* title, const char* msg) {
+	cc_string str = String_FromReadonly(msg);
+	Logger_WarnFunc(&str);
+}
+
+cc_string Game_Username;
+cc_bool Game_AllowCustomBlocks = true;
+cc_string TexturePack_Url;
+struct RayTracer Game_SelectedPos;
+struct LocalPlayer LocalPlayer_Instance;
+struct _Atlas2DData Atlas2D;
+
+float LocationUpdate_Clamp(float degrees) { return degrees; }
+void Inventory_AddDefault(BlockID block) { }
+void Server_RetrieveTexturePack(const cc_string* url) { }
+void LocalPlayer_MoveToSpawn(void) { }
+void Game_Reset(void) { World_Reset(); }
+void AABB_Make(struct AABB* result, const Vec3* pos, const Vec3* size) { }
+cc_bool AABB_Intersects(const struct AABB* bb, const struct AABB* other) { return false; }
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Test data-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Rolling hills of grass over dirt and stone with some ores, and water in the valleys, */
+/*  so that the map compresses roughly like a generated one. Always the same for every run. */
+static cc_result Bench_MakeMap(void) {
+	RNGState rnd;
+	BlockRaw block;
+	int x, y, z, height;
+
+	bench_map = (BlockRaw*)Mem_TryAlloc(BENCH_MAP_SIZE, 1);
+	if (!bench_map) return ERR_OUT_OF_MEMORY;
+	Random_Seed(&rnd, 1234567);
+
+	for (z = 0; z < BENCH_MAP_LENGTH; z++) {
+		for (x = 0; x < BENCH_MAP_WIDTH; x++) {
+			height = BENCH_MAP_WATER + (int)(Math_SinF(x * 0.05f) * 6 + Math_CosF(z * 0.07f) * 5) + Random_Next(&rnd, 2);
+
+			for (y = 0; y < BENCH_MAP_HEIGHT; y++) {
+				if (y < height - 4) {
+					block = Random_Next(&rnd, 64) ? BLOCK_STONE : BLOCK_COAL_ORE;
+				} else if (y < height) {
+					block = BLOCK_DIRT;
+				} else if (y == height) {
+					block = height < BENCH_MAP_WATER ? BLOCK_SAND : BLOCK_GRASS;
+				} else {
+					block = y <= BENCH_MAP_WATER ? BLOCK_STILL_WATER : BLOCK_AIR;
+				}
+				bench_map[(y * BENCH_MAP_LENGTH + z) * BENCH_MAP_WIDTH + x] = block;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Random bytes that can't be compressed, so every byte becomes a literal symbol */
+static void Bench_MakeNoise(void) {
+	RNGState rnd;
+	int i;
+	Random_Seed(&rnd, 1357911);
+
+	for (i = 0; i < BENCH_NOISE_SIZE; i++) {
+		bench_noise[i] = (cc_uint8)Random_Next(&rnd, 256);
+	}
+}
+
+/* Smooth gradient with some noise on top, so PNG filtering has something to do */
+static cc_result Bench_MakeImage(void) {
+	RNGState rnd;
+	int x, y, r, g, b, a;
+
+	Bitmap_TryAllocate(&bench_image, BENCH_IMAGE_SIZE, BENCH_IMAGE_SIZE);
+	if (!bench_image.scan0) return ERR_OUT_OF_MEMORY;
+	Random_Seed(&rnd, 7654321);
+
+	for (y = 0; y < BENCH_IMAGE_SIZE; y++) {
+		for (x = 0; x < BENCH_IMAGE_SIZE; x++) {
+			r = (x / 2)       + Random_Next(&rnd, 8);
+			g = (y / 2)       + Random_Next(&rnd, 8);
+			b = ((x + y) / 4) + Random_Next(&rnd, 32);
+			a = (x & 64) ? 255 : 128 + Random_Next(&rnd, 128);
+			Bitmap_GetPixel(&bench_image, x, y) = BitmapCol_Make(r & 0xFF, g & 0xFF, b & 0xFF, a);
+		}
+	}
+	return 0;
+}
+
+static cc_result Bench_OutputWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	*modified = 0;
+	if (bench_outputLen + count > BENCH_OUTPUT_SIZE) return ERR_END_OF_STREAM;
+
+	Mem_Copy(bench_output + bench_outputLen, data, count);
+	bench_outputLen += count;
+	*modified        = count;
+	return 0;
+}
+
+/* Makes a stream that writes into bench_output, discarding anything previously written */
+static void Bench_MakeOutput(struct Stream* s) {
+	Stream_Init(s);
+	s->Write        = Bench_OutputWrite;
+	bench_outputLen = 0;
+}
+
+/* Copies the data written to bench_output, so it can be used as input by a decompression kernel */
+static cc_result Bench_SaveOutput(cc_uint8** data, cc_uint32* len) {
+	*data = (cc_uint8*)Mem_TryAlloc(max(1, bench_outputLen), 1);
+	if (!(*data)) return ERR_OUT_OF_MEMORY;
+
+	Mem_Copy(*data, bench_output, bench_outputLen);
+	*len = bench_outputLen;
+	return 0;
+}
+
+static cc_result Bench_MakeZip(void) {
+	static const cc_string mapPath   = String_FromConst("map.bin");
+	static const cc_string imagePath = String_FromConst("textures/image.png");
+	static const cc_string rawPath   = String_FromConst("textures/image.raw");
+	struct ZipWriter zip;
+	struct Stream s;
+	cc_result res;
+
+	Bench_MakeOutput(&s);
+	if ((res = ZipWriter_Begin(&zip, &s, DEFLATE_LEVEL_DEFAULT))) return res;
+
+	ZipWriter_AddData(&zip, &mapPath,   bench_map, BENCH_MAP_SIZE, ZIP_METHOD_AUTO);
+	ZipWriter_AddData(&zip, &imagePath, bench_png, bench_pngLen,   ZIP_METHOD_AUTO);
+	ZipWriter_AddData(&zip, &rawPath,   bench_image.scan0, BENCH_IMAGE_BYTES, ZIP_METHOD_AUTO);
+
+	if ((res = ZipWriter_End(&zip))) return res;
+	return Bench_SaveOutput(&bench_zip, &bench_zipLen);
+}
+
+static cc_uint32 Bench_SlowCRC32(const cc_uint8* data, cc_uint32 length) {
+	cc_uint32 i, crc = 0xFFFFFFFFUL;
+	for (i = 0; i < length; i++) {
+		crc = Utils_Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFUL;
+}
+
+/* Loads the test map into the world, which rearranges the blocks when the world is tiled */
+static cc_result Bench_MakeWorld(void) {
+	BlockRaw* blocks = World_TryAllocBlocks(BENCH_MAP_SIZE);
+	if (!blocks) return ERR_OUT_OF_MEMORY;
+
+	Mem_Copy(blocks, bench_map, BENCH_MAP_SIZE);
+	World_SetNewMap(blocks, BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT, BENCH_MAP_LENGTH);
+	return World.Blocks ? 0 : ERR_OUT_OF_MEMORY;
+}
+
+/* Replaces the test map in the world with the map in the given file */
+static cc_result Bench_LoadMap(const cc_string* path) {
+	Map_LoadFrom(path);
+	/* Map_LoadFrom has already logged why the map couldn't be loaded */
+	if (!World.Blocks) return ERR_NOT_SUPPORTED;
+	return 0;
+}
+
+static cc_result Bench_MakeData(void) {
+	struct Stream s, compressor;
+	cc_result res;
+
+	bench_output = (cc_uint8*)Mem_TryAlloc(BENCH_OUTPUT_SIZE, 1);
+	if (!bench_output) return ERR_OUT_OF_MEMORY;
+	if ((res = Bench_MakeMap()))   return res;
+	if ((res = Bench_MakeImage())) return res;
+	Bench_MakeNoise();
+	bench_mapCrc = Bench_SlowCRC32(bench_map, BENCH_MAP_SIZE);
+
+	Bench_MakeOutput(&s);
+	Deflate_MakeStream(&compressor, &bench_deflate, &s);
+	if ((res = Stream_Write(&compressor, bench_map, BENCH_MAP_SIZE))) return res;
+	if ((res = compressor.Close(&compressor)))                        return res;
+	if ((res = Bench_SaveOutput(&bench_deflated, &bench_deflatedLen))) return res;
+
+	Bench_MakeOutput(&s);
+	if ((res = Png_Encode(&bench_image, &s, NULL, true)))   return res;
+	if ((res = Bench_SaveOutput(&bench_png, &bench_pngLen))) return res;
+	if ((res = Bench_MakeZip())) return res;
+	return Bench_MakeWorld();
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Kernels--------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Bench_CRC32(cc_uint32* size) {
+	cc_uint32 crc = Utils_CRC32(bench_map, BENCH_MAP_SIZE);
+	*size = BENCH_MAP_SIZE;
+	return crc == bench_mapCrc ? 0 : ERR_INVALID_ARGUMENT;
+}
+
+static cc_result Bench_DeflateLevel(cc_uint32* size, int level) {
+	struct Stream s, compressor;
+	cc_result res;
+
+	Bench_MakeOutput(&s);
+	Deflate_MakeStream(&compressor, &bench_deflate, &s);
+	Deflate_SetLevel(&bench_deflate, level);
+
+	*size = BENCH_MAP_SIZE;
+	if ((res = Stream_Write(&compressor, bench_map, BENCH_MAP_SIZE))) return res;
+	return compressor.Close(&compressor);
+}
+
+static cc_result Bench_DeflateFastest(cc_uint32* size) { return Bench_DeflateLevel(size, DEFLATE_LEVEL_FASTEST); }
+static cc_result Bench_DeflateDefault(cc_uint32* size) { return Bench_DeflateLevel(size, DEFLATE_LEVEL_DEFAULT); }
+static cc_result Bench_DeflateBest(cc_uint32* size)    { return Bench_DeflateLevel(size, DEFLATE_LEVEL_BEST); }
+
+/* Lengths where the last few literals of the final block don't fit in an almost full block */
+static const cc_uint32 bench_roundtripLens[] = { 8193, 8194, BENCH_NOISE_SIZE };
+
+/* Checks that data deflated at every level inflates back to the same data */
+static cc_result Bench_DeflateRoundtrip(cc_uint32* size) {
+	struct Stream s, compressor, src, inflater;
+	cc_uint32 len;
+	int i, level;
+	cc_result res;
+	*size = 0;
+
+	for (i = 0; i < Array_Elems(bench_roundtripLens); i++) {
+		for (level = DEFLATE_LEVEL_NONE; level <= DEFLATE_LEVEL_BEST; level++) {
+			len = bench_roundtripLens[i];
+			Bench_MakeOutput(&s);
+			Deflate_MakeStream(&compressor, &bench_deflate, &s);
+			Deflate_SetLevel(&bench_deflate, level);
+
+			if ((res = Stream_Write(&compressor, bench_noise, len))) return res;
+			if ((res = compressor.Close(&compressor)))              return res;
+
+			Stream_ReadonlyMemory(&src, bench_output, bench_outputLen);
+			Inflate_MakeStream2(&inflater, &bench_inflate, &src);
+			if ((res = Stream_Read(&inflater, bench_inflated, len))) return res;
+
+			if (!Mem_Equal(bench_noise, bench_inflated, len)) return ERR_INVALID_ARGUMENT;
+			*size += len;
+		}
+	}
+	return 0;
+}
+
+static cc_result Bench_GZip(cc_uint32* size) {
+	struct Stream s, compressor;
+	cc_result res;
+
+	Bench_MakeOutput(&s);
+	GZip_MakeStream(&compressor, &bench_gzip, &s);
+
+	*size = BENCH_MAP_SIZE;
+	if ((res = Stream_Write(&compressor, bench_map, BENCH_MAP_SIZE))) return res;
+	return compressor.Close(&compressor);
+}
+
+static cc_result Bench_GZipParallel(cc_uint32* size) {
+	struct Stream s, compressor;
+	cc_result res;
+
+	Bench_MakeOutput(&s);
+	if ((res = GZip_MakeParallelStream(&compressor, &s, DEFLATE_LEVEL_DEFAULT))) return res;
+
+	*size = BENCH_MAP_SIZE;
+	res   = Stream_Write(&compressor, bench_map, BENCH_MAP_SIZE);
+	/* Must always be closed, even when writing fails */
+	if (res) { compressor.Close(&compressor); return res; }
+	return compressor.Close(&compressor);
+}
+
+static cc_result Bench_ZLib(cc_uint32* size) {
+	struct Stream s, compressor;
+	cc_result res;
+
+	Bench_MakeOutput(&s);
+	ZLib_MakeStream(&compressor, &bench_zlib, &s);
+
+	*size = BENCH_MAP_SIZE;
+	if ((res = Stream_Write(&compressor, bench_map, BENCH_MAP_SIZE))) return res;
+	return compressor.Close(&compressor);
+}
+
+static cc_result Bench_Inflate(cc_uint32* size) {
+	struct Stream src, stream;
+	Stream_ReadonlyMemory(&src, bench_deflated, bench_deflatedLen);
+	Inflate_MakeStream2(&stream, &bench_inflate, &src);
+
+	*size = BENCH_MAP_SIZE;
+	return Stream_Read(&stream, bench_output, BENCH_MAP_SIZE);
+}
+
+static cc_result Bench_PngEncode(cc_uint32* size) {
+	struct Stream s;
+	Bench_MakeOutput(&s);
+
+	*size = BENCH_IMAGE_BYTES;
+	return Png_Encode(&bench_image, &s, NULL, true);
+}
+
+static cc_result Bench_PngDecode(cc_uint32* size) {
+	struct Bitmap bmp;
+	struct Stream s;
+	cc_result res;
+	Stream_ReadonlyMemory(&s, bench_png, bench_pngLen);
+
+	*size = BENCH_IMAGE_BYTES;
+	res   = Png_Decode(&bmp, &s);
+	Mem_Free(bmp.scan0);
+	return res;
+}
+
+static cc_bool Bench_SelectEntry(const cc_string* path) { return true; }
+static cc_result Bench_ProcessEntry(const cc_string* path, struct Stream* data, struct ZipState* state) {
+	cc_uint32 read;
+	cc_result res;
+
+	for (;;) {
+		res = data->Read(data, bench_output, BENCH_OUTPUT_SIZE, &read);
+		if (res)   return res;
+		if (!read) return 0;
+		bench_extracted += read;
+	}
+}
+
+static cc_result Bench_ZipExtractWith(cc_uint32* size, cc_result (*extract)(struct ZipState* state)) {
+	struct Stream s;
+	cc_result res;
+	Stream_ReadonlyMemory(&s, bench_zip, bench_zipLen);
+	Zip_Init(&bench_zipState, &s);
+
+	bench_zipState.SelectEntry  = Bench_SelectEntry;
+	bench_zipState.ProcessEntry = Bench_ProcessEntry;
+	bench_extracted = 0;
+
+	res   = extract(&bench_zipState);
+	*size = bench_extracted;
+	return res;
+}
+
+static cc_result Bench_ZipExtract(cc_uint32* size)  { return Bench_ZipExtractWith(size, Zip_Extract); }
+static cc_result Bench_ZipParallel(cc_uint32* size) { return Bench_ZipExtractWith(size, Zip_ExtractParallel); }
+
+#ifdef CC_BUILD_TILEDWORLD
+/* Blocks in a row are only contiguous within the same 16x16x16 tile (same as Builder_SeekTile) */
+#define Bench_SeekTile(x, y, z) if (((x) & CHUNK_MASK) == 0) index = World_Pack(x, y, z);
+#else
+#define Bench_SeekTile(x, y, z)
+#endif
+#define Bench_PackChunk(xx, yy, zz) ((((yy) + 1) * 18 + ((zz) + 1)) * 18 + ((xx) + 1))
+
+/* Reads the chunk and its bordering blocks in the same order as the builder does before meshing it */
+static void Bench_ReadChunk(int x1, int y1, int z1) {
+	int xMin = max(-1, -x1), xMax = min(17, World.Width  - x1);
+	int yMin = max(-1, -y1), yMax = min(17, World.Height - y1);
+	int zMin = max(-1, -z1), zMax = min(17, World.Length - z1);
+	int index, cIndex, xx, yy, zz;
+
+	for (yy = yMin; yy < yMax; yy++) {
+		for (zz = zMin; zz < zMax; zz++) {
+			index  = World_Pack(x1 + xMin, y1 + yy, z1 + zz);
+			cIndex = Bench_PackChunk(xMin, yy, zz);
+
+			for (xx = xMin; xx < xMax; xx++, index++, cIndex++) {
+				Bench_SeekTile(x1 + xx, y1 + yy, z1 + zz);
+				bench_chunk[cIndex] = (World.Blocks[index] | (World.Blocks2[index] << 8)) & World.IDMask;
+			}
+		}
+	}
+}
+
+/* Counts the faces of each block in the chunk that aren't hidden by a neighbouring block */
+static void Bench_CountFaces(void) {
+	int xx, yy, zz, i;
+	for (yy = 0; yy < 16; yy++) {
+		for (zz = 0; zz < 16; zz++) {
+			i = Bench_PackChunk(0, yy, zz);
+
+			for (xx = 0; xx < 16; xx++, i++) {
+				if (Blocks.Draw[bench_chunk[i]] == DRAW_GAS) continue;
+				bench_worldResult += Blocks.Draw[bench_chunk[i - 1]]   == DRAW_GAS;
+				bench_worldResult += Blocks.Draw[bench_chunk[i + 1]]   == DRAW_GAS;
+				bench_worldResult += Blocks.Draw[bench_chunk[i - 18]]  == DRAW_GAS;
+				bench_worldResult += Blocks.Draw[bench_chunk[i + 18]]  == DRAW_GAS;
+				bench_worldResult += Blocks.Draw[bench_chunk[i - 324]] == DRAW_GAS;
+				bench_worldResult += Blocks.Draw[bench_chunk[i + 324]] == DRAW_GAS;
+			}
+		}
+	}
+}
+
+static cc_result Bench_MeshWorld(cc_uint32* size) {
+	int x, y, z;
+	bench_worldResult = 0;
+
+	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
+		for (z = 0; z < World.Length; z += CHUNK_SIZE) {
+			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
+				/* Blocks outside the world are treated as air */
+				if (x == 0 || y == 0 || z == 0 || x + CHUNK_SIZE >= World.Width ||
+					y + CHUNK_SIZE >= World.Height || z + CHUNK_SIZE >= World.Length) {
+					Mem_Set(bench_chunk, 0, sizeof(bench_chunk));
+				}
+				Bench_ReadChunk(x, y, z);
+				Bench_CountFaces();
+			}
+		}
+	}
+	*size = World.Volume;
+	return 0;
+}
+
+/* Same as Physics_TickRandomBlocks, except only reads the randomly chosen blocks */
+static cc_result Bench_PhysicsRandomTick(cc_uint32* size) {
+	RNGState rnd;
+	int x, y, z, lo, hi;
+	cc_uint32 ticks = 0;
+	Random_Seed(&rnd, 1234567);
+	bench_worldResult = 0;
+
+	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
+		for (z = 0; z < World.Length; z += CHUNK_SIZE) {
+			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
+				lo = World_Pack(x, y, z);
+				hi = World_Pack(min(x + CHUNK_MAX, World.MaxX), min(y + CHUNK_MAX, World.MaxY), min(z + CHUNK_MAX, World.MaxZ));
+
+				bench_worldResult += World.Blocks[Random_Range(&rnd, lo, hi)];
+				bench_worldResult += World.Blocks[Random_Range(&rnd, lo, hi)];
+				bench_worldResult += World.Blocks[Random_Range(&rnd, lo, hi)];
+				ticks += 3;
+			}
+		}
+	}
+	*size = ticks;
+	return 0;
+}
+
+/* Finds where every column's surface is, the same way falling blocks find where to fall to */
+static cc_result Bench_PhysicsFalling(cc_uint32* size) {
+	int x, y, z;
+	cc_uint32 count = 0;
+	BlockRaw block;
+
+	for (z = 0; z < World.Length; z++) {
+		for (x = 0; x < World.Width; x++) {
+			for (y = World.MaxY; y >= 0; y--, count++) {
+				block = World.Blocks[World_Pack(x, y, z)];
+				if (block != BLOCK_AIR && (block < BLOCK_WATER || block > BLOCK_STILL_LAVA)) break;
+			}
+		}
+	}
+	*size = count;
+	return 0;
+}
+
+static cc_result Bench_DiscardWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	*modified = count; return 0;
+}
+
+static cc_result Bench_SaveWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	bench_savedLen += count;
+	return bench_saveDest->Write(bench_saveDest, data, count, modified);
+}
+
+/* Saves the world in .cw format the same way the save level menu does, but discards the compressed data */
+static cc_result Bench_SaveWith(cc_uint32* size, int level, cc_bool parallel) {
+	struct Stream raw, compressed, discard;
+	cc_result res;
+
+	Stream_Init(&discard);
+	discard.Write = Bench_DiscardWrite;
+
+	if (!parallel) {
+		GZip_MakeStream(&compressed, &bench_gzip, &discard);
+		Deflate_SetLevel(&bench_gzip.Base, level);
+	} else if ((res = GZip_MakeParallelStream(&compressed, &discard, level))) {
+		return res;
+	}
+
+	Stream_Init(&raw);
+	raw.Write      = Bench_SaveWrite;
+	bench_saveDest = &compressed;
+	bench_savedLen = 0;
+
+	res   = Cw_Save(&raw);
+	*size = bench_savedLen;
+	/* Must always be closed, even when saving fails */
+	if (res) { compressed.Close(&compressed); return res; }
+	return compressed.Close(&compressed);
+}
+
+static cc_result Bench_SaveFastest(cc_uint32* size)  { return Bench_SaveWith(size, DEFLATE_LEVEL_FASTEST, false); }
+static cc_result Bench_SaveDefault(cc_uint32* size)  { return Bench_SaveWith(size, DEFLATE_LEVEL_DEFAULT, false); }
+static cc_result Bench_SaveParallel(cc_uint32* size) { return Bench_SaveWith(size, DEFLATE_LEVEL_DEFAULT, true);  }
+
+static const struct BenchKernel {
+	const char* name;
+	/* Runs the kernel once, setting size to the number of uncompressed bytes processed */
+	cc_result (*Run)(cc_uint32* size);
+	/* Maximum number of worker threads (see Deflate_SetMaxWorkers), or 0 for one per processor */
+	/* Kernels with more workers than the number of processors are skipped */
+	int workers;
+} kernels[] = {
+	{ "crc32",           Bench_CRC32          },
+	{ "deflate_fastest", Bench_DeflateFastest },
+	{ "deflate_default", Bench_DeflateDefault },
+	{ "deflate_best",    Bench_DeflateBest    },
+	{ "deflate_roundtrip", Bench_DeflateRoundtrip },
+	{ "gzip",            Bench_GZip           },
+	{ "gzip_parallel_1",  Bench_GZipParallel, 1  },
+	{ "gzip_parallel_2",  Bench_GZipParallel, 2  },
+	{ "gzip_parallel_4",  Bench_GZipParallel, 4  },
+	{ "gzip_parallel_8",  Bench_GZipParallel, 8  },
+	{ "gzip_parallel_16", Bench_GZipParallel, 16 },
+	{ "gzip_parallel_all", Bench_GZipParallel },
+	{ "zlib",            Bench_ZLib           },
+	{ "inflate",         Bench_Inflate        },
+	{ "png_encode",      Bench_PngEncode      },
+	{ "png_decode",      Bench_PngDecode      },
+	{ "zip_extract",     Bench_ZipExtract     },
+	{ "zip_extract_parallel", Bench_ZipParallel },
+	{ "world_mesh_" BENCH_LAYOUT,            Bench_MeshWorld         },
+	{ "world_physics_tick_" BENCH_LAYOUT,    Bench_PhysicsRandomTick },
+	{ "world_physics_falling_" BENCH_LAYOUT, Bench_PhysicsFalling    },
+	{ "save_cw_fastest",  Bench_SaveFastest  },
+	{ "save_cw_default",  Bench_SaveDefault  },
+	{ "save_cw_parallel", Bench_SaveParallel },
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Main----------------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_Log(const cc_string* str) { Platform_Log(str->buffer, str->length); }
+
+/* Repeatedly runs the kernel, then prints the speed of the fastest run */
+/* (fastest run is the one least affected by other processes and CPU frequency changes) */
+static cc_result Bench_Measure(const struct BenchKernel* k) {
+	cc_string line; char lineBuffer[STRING_SIZE];
+	cc_uint64 beg, end, elapsed, total = 0, best = 0;
+	cc_uint32 size = 0;
+	float speed, nsPerByte;
+	int runs;
+	cc_result res;
+
+	/* First run warms up caches, and is not counted */
+	if ((res = k->Run(&size))) return res;
+
+	for (runs = 0; total < BENCH_MIN_MICROSECONDS; runs++) {
+		beg = Stopwatch_Measure();
+		res = k->Run(&size);
+		end = Stopwatch_Measure();
+		if (res) return res;
+
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, end);
+		total  += max(1, elapsed);
+		if (!runs || elapsed < best) best = elapsed;
+	}
+
+	/* bytes per microsecond is the same as megabytes per second */
+	speed     = size / (float)max(1, best);
+	nsPerByte = best * 1000.0f / max(1, size);
+
+	String_InitArray(line, lineBuffer);
+	String_Format4(&line, "%c,%i,%i,%f2,", k->name, &size, &runs, &speed);
+	String_Format1(&line, "%f4", &nsPerByte);
+	Bench_Log(&line);
+	return 0;
+}
+
+/* Usage: ClassiCube-bench [kernel] [map file] */
+/* With no arguments, runs all of the kernels. Otherwise, only runs kernels whose name starts with kernel. */
+/* The world and save kernels use the map file when given, instead of the generated test map. */
+int main(int argc, char** argv) {
+	cc_string filter = String_Empty;
+	cc_string name, path;
+	int i;
+	cc_result res;
+
+	Platform_Init();
+	World_Component.Init();
+	Blocks_Component.Init();
+	if (argc > 1) filter = String_FromReadonly(argv[1]);
+
+	if ((res = Bench_MakeData())) { Logger_SysWarn(res, "generating benchmark data"); return 1; }
+
+	if (argc > 2) {
+		path = String_FromReadonly(argv[2]);
+		if ((res = Bench_LoadMap(&path))) { Logger_SysWarn2(res, "loading", &path); return 1; }
+	}
+	Platform_LogConst("kernel,bytes,runs,mb_per_s,ns_per_byte");
+
+	for (i = 0; i < Array_Elems(kernels); i++) {
+		name = String_FromReadonly(kernels[i].name);
+		if (!String_CaselessStarts(&name, &filter)) continue;
+		if (kernels[i].workers > Thread_ProcessorCount()) continue;
+
+		Deflate_SetMaxWorkers(kernels[i].workers);
+		if ((res = Bench_Measure(&kernels[i]))) { Logger_SysWarn(res, kernels[i].name); return 1; }
+	}
+	return 0;
+}
+#endif
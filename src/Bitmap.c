@@ -7,6 +7,7 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Utils.h"
+#include "Funcs.h"
 
 void Bitmap_UNSAFE_CopyBlock(int srcX, int srcY, int dstX, int dstY, 
 							struct Bitmap* src, struct Bitmap* dst, int size) {
@@ -333,6 +334,20 @@ static void ComputeTransparency(struct Bitmap* bmp, BitmapCol col) {
 /* Need to store both current and prior row, per PNG specification. */
 #define PNG_BUFFER_SIZE ((PNG_MAX_DIMS * 2 * 4 + 1) * 2)
 
+static cc_result Png_DecodedClose(struct Stream* stream) {
+	Mem_Free(stream->Meta.DecodedPng.Scan0);
+	stream->Meta.DecodedPng.Scan0 = NULL;
+	return 0;
+}
+
+void Png_MakeDecodedStream(struct Stream* stream, struct Bitmap* bmp, void* data, cc_uint32 len) {
+	Stream_ReadonlyMemory(stream, data, len);
+	stream->Close = Png_DecodedClose;
+	stream->Meta.DecodedPng.Scan0  = bmp->scan0;
+	stream->Meta.DecodedPng.Width  = bmp->width;
+	stream->Meta.DecodedPng.Height = bmp->height;
+}
+
 /* TODO: Test a lot of .png files and ensure output is right */
 cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	cc_uint8 tmp[PNG_PALETTE * 3];
@@ -361,6 +376,15 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	struct Stream compStream, datStream;
 	struct ZLibHeader zlibHeader;
 
+	/* Only the first caller gets the already decoded bitmap, any others decode the data again */
+	if (stream->Close == Png_DecodedClose && stream->Meta.DecodedPng.Scan0) {
+		bmp->scan0  = (BitmapCol*)stream->Meta.DecodedPng.Scan0;
+		bmp->width  = stream->Meta.DecodedPng.Width;
+		bmp->height = stream->Meta.DecodedPng.Height;
+		stream->Meta.DecodedPng.Scan0 = NULL;
+		return 0;
+	}
+
 	bmp->width = 0; bmp->height = 0;
 	bmp->scan0 = NULL;
 
@@ -626,26 +650,66 @@ static void Png_EncodeRow(const cc_uint8* cur, const cc_uint8* prior, cc_uint8*
 	best[0] = bestFilter;
 }
 
+/* Compressed image data is buffered, then written out as a series of IDAT chunks. */
+/* That way the size of each chunk is already known when it is written, so the stream is never seeked back. */
+#define PNG_IDAT_SIZE 8192
+struct PngIDATState {
+	struct Stream* dest;
+	cc_uint32 len;
+	cc_uint8 buffer[8 + PNG_IDAT_SIZE + 4]; /* size and type, data, CRC32 */
+};
+
+static cc_result Png_FlushIDAT(struct PngIDATState* state) {
+	cc_uint8* buffer = state->buffer;
+	cc_uint32 len    = state->len;
+	if (!len) return 0;
+
+	Stream_SetU32_BE(&buffer[0], len);
+	Stream_SetU32_BE(&buffer[4], PNG_FourCC('I','D','A','T'));
+	Stream_SetU32_BE(&buffer[8 + len], Utils_CRC32(&buffer[4], len + 4));
+
+	state->len = 0;
+	return Stream_Write(state->dest, buffer, len + 12);
+}
+
+static cc_result Png_WriteIDAT(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct PngIDATState* state = (struct PngIDATState*)stream->Meta.Inflate;
+	cc_uint32 len;
+	cc_result res;
+	*modified = 0;
+
+	while (count) {
+		len = min(count, PNG_IDAT_SIZE - state->len);
+		Mem_Copy(state->buffer + 8 + state->len, data, len);
+
+		state->len += len; *modified += len;
+		data       += len; count     -= len;
+		if (state->len == PNG_IDAT_SIZE && (res = Png_FlushIDAT(state))) return res;
+	}
+	return 0;
+}
+
 static int Png_SelectRow(struct Bitmap* bmp, int y) { return y; }
 cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
 					Png_RowSelector selectRow, cc_bool alpha) {
+	return Png_EncodeLevel(bmp, stream, selectRow, alpha, DEFLATE_LEVEL_DEFAULT);
+}
+
+cc_result Png_EncodeLevel(struct Bitmap* bmp, struct Stream* stream, 
+						Png_RowSelector selectRow, cc_bool alpha, int level) {
 	cc_uint8 tmp[32];
 	/* TODO: This should be * 4 for alpha (should switch to mem_alloc though) */
 	cc_uint8 prevLine[PNG_MAX_DIMS * 3], curLine[PNG_MAX_DIMS * 3];
 	cc_uint8 bestLine[PNG_MAX_DIMS * 3 + 1];
 
 	struct ZLibState zlState;
+	struct PngIDATState idat;
 	struct Stream chunk, zlStream;
-	cc_uint32 stream_end, stream_beg;
 	int y, lineSize;
 	cc_result res;
 
-	/* stream may not start at 0 (e.g. when making default.zip) */
-	if ((res = stream->Position(stream, &stream_beg))) return res;
-
 	if (!selectRow) selectRow = Png_SelectRow;
 	if ((res = Stream_Write(stream, pngSig, PNG_SIG_SIZE))) return res;
-	Stream_WriteonlyCrc32(&chunk, stream);
 
 	/* Write header chunk */
 	Stream_SetU32_BE(&tmp[0], PNG_IHDR_SIZE);
@@ -660,14 +724,17 @@ cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream,
 		tmp[20] = 0;           /* Not using interlacing */
 	}
 	Stream_SetU32_BE(&tmp[21], Utils_CRC32(&tmp[4], 17));
+	if ((res = Stream_Write(stream, tmp, 25))) return res;
 
 	/* Write PNG body */
-	Stream_SetU32_BE(&tmp[25], 0); /* size of IDAT, filled in later */
-	if ((res = Stream_Write(stream, tmp, 29))) return res;
-	Stream_SetU32_BE(&tmp[0], PNG_FourCC('I','D','A','T'));
-	if ((res = Stream_Write(&chunk, tmp, 4))) return res;
+	Stream_Init(&chunk);
+	chunk.Meta.Inflate = &idat;
+	chunk.Write        = Png_WriteIDAT;
+	idat.dest = stream;
+	idat.len  = 0;
 
 	ZLib_MakeStream(&zlStream, &zlState, &chunk); 
+	Deflate_SetLevel(&zlState.Base, level);
 	lineSize = bmp->width * (alpha ? 4 : 3);
 	Mem_Set(prevLine, 0, lineSize);
 
@@ -684,20 +751,11 @@ cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream,
 		if ((res = Stream_Write(&zlStream, bestLine, lineSize + 1))) return res;
 	}
 	if ((res = zlStream.Close(&zlStream))) return res;
-	Stream_SetU32_BE(&tmp[0], chunk.Meta.CRC32.CRC32 ^ 0xFFFFFFFFUL);
+	if ((res = Png_FlushIDAT(&idat)))      return res;
 
 	/* Write end chunk */
-	Stream_SetU32_BE(&tmp[4],  0);
-	Stream_SetU32_BE(&tmp[8],  PNG_FourCC('I','E','N','D'));
-	Stream_SetU32_BE(&tmp[12], 0xAE426082UL); /* CRC32 of IEND */
-	if ((res = Stream_Write(stream, tmp, 16))) return res;
-
-	/* Come back to fixup size of data in data chunk */
-	/* TODO: Position instead of Length */
-	if ((res = stream->Length(stream, &stream_end)))   return res;
-	if ((res = stream->Seek(stream, stream_beg + 33))) return res;
-
-	Stream_SetU32_BE(&tmp[0], (stream_end - stream_beg) - 57);
-	if ((res = Stream_Write(stream, tmp, 4))) return res;
-	return stream->Seek(stream, stream_end);
+	Stream_SetU32_BE(&tmp[0], 0);
+	Stream_SetU32_BE(&tmp[4], PNG_FourCC('I','E','N','D'));
+	Stream_SetU32_BE(&tmp[8], 0xAE426082UL); /* CRC32 of IEND */
+	return Stream_Write(stream, tmp, 12);
 }
@@ -86,9 +86,17 @@ typedef int (*Png_RowSelector)(struct Bitmap* bmp, int row);
      https://github.com/nothings/stb/blob/master/stb_image.h
 */
 CC_API cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream);
+/* Wraps a block of memory containing PNG data that has already been decoded into the given bitmap. */
+/* Png_Decode on this stream returns that bitmap (taking ownership of its pixels) instead of decoding again. */
+/* NOTE: Close must be called afterwards, to free the bitmap if Png_Decode was never called. */
+void Png_MakeDecodedStream(struct Stream* stream, struct Bitmap* bmp, void* data, cc_uint32 len);
 /* Encodes a bitmap in PNG format. */
 /* selectRow is optional. Can be used to modify how rows are encoded. (e.g. flip image) */
 /* if alpha is non-zero, RGBA channels are saved, otherwise only RGB channels are. */
 CC_API cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
 							Png_RowSelector selectRow, cc_bool alpha);
+/* Same as Png_Encode, but compresses the image data using the given DEFLATE_LEVEL_ level. */
+/* NOTE: Png_Encode uses DEFLATE_LEVEL_DEFAULT. */
+CC_API cc_result Png_EncodeLevel(struct Bitmap* bmp, struct Stream* stream, 
+							Png_RowSelector selectRow, cc_bool alpha, int level);
 #endif
@@ -109,6 +109,11 @@ static void Physics_OnNewMapLoaded(void* obj) {
 	Tree_Blocks = World.Blocks;
 	Random_SeedFromCurrentTime(&physics_rnd);
 	Tree_Rnd = &physics_rnd;
+
+	/* Physics index World.Blocks directly, which sectioned maps don't have */
+	if (Physics.Enabled && World.Sections) {
+		Chat_AddRaw("&cPhysics are not supported on maps this large, so are disabled for this map");
+	}
 }
 
 void Physics_SetEnabled(cc_bool enabled) {
@@ -122,13 +127,13 @@ static void Physics_Activate(int index) {
 	if (activate) activate(index, block);
 }
 
-static void Physics_ActivateNeighbours(int x, int y, int z, int index) {
-	if (x > 0)          Physics_Activate(index - 1);
-	if (x < World.MaxX) Physics_Activate(index + 1);
-	if (z > 0)          Physics_Activate(index - World.Width);
-	if (z < World.MaxZ) Physics_Activate(index + World.Width);
-	if (y > 0)          Physics_Activate(index - World.OneY);
-	if (y < World.MaxY) Physics_Activate(index + World.OneY);
+static void Physics_ActivateNeighbours(int x, int y, int z) {
+	if (x > 0)          Physics_Activate(World_Pack(x - 1, y, z));
+	if (x < World.MaxX) Physics_Activate(World_Pack(x + 1, y, z));
+	if (z > 0)          Physics_Activate(World_Pack(x, y, z - 1));
+	if (z < World.MaxZ) Physics_Activate(World_Pack(x, y, z + 1));
+	if (y > 0)          Physics_Activate(World_Pack(x, y - 1, z));
+	if (y < World.MaxY) Physics_Activate(World_Pack(x, y + 1, z));
 }
 
 static cc_bool Physics_IsEdgeWater(int x, int y, int z) {
@@ -142,7 +147,7 @@ static cc_bool Physics_IsEdgeWater(int x, int y, int z) {
 void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	PhysicsHandler handler;
 	int index;
-	if (!Physics.Enabled) return;
+	if (!Physics.Enabled || !World.Blocks) return;
 
 	if (now == BLOCK_AIR && Physics_IsEdgeWater(x, y, z)) {
 		now = BLOCK_STILL_WATER;
@@ -158,7 +163,7 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 		handler = Physics.OnPlace[(BlockRaw)now];
 		if (handler) handler(index, now);
 	}
-	Physics_ActivateNeighbours(x, y, z, index);
+	Physics_ActivateNeighbours(x, y, z);
 }
 
 static void Physics_TickRandomBlocks(void) {
@@ -199,28 +204,26 @@ static void Physics_TickRandomBlocks(void) {
 
 
 static void Physics_DoFalling(int index, BlockID block) {
-	int found = -1, start = index;
+	int found = -1;
 	BlockID other;
-	int x, y, z;
+	int x, y, z, yy;
+	World_Unpack(index, x, y, z);
 
 	/* Find lowest block can fall into */
-	while (index >= World.OneY) {
-		index -= World.OneY;
-		other  = World.Blocks[index];
+	for (yy = y - 1; yy >= 0; yy--) {
+		other = World.Blocks[World_Pack(x, yy, z)];
 
 		if (other == BLOCK_AIR || (other >= BLOCK_WATER && other <= BLOCK_STILL_LAVA))
-			found = index;
+			found = yy;
 		else
 			break;
 	}
 
 	if (found == -1) return;
-	World_Unpack(found, x, y, z);
-	Game_UpdateBlock(x, y, z, block);
+	Game_UpdateBlock(x, found, z, block);
 
-	World_Unpack(start, x, y, z);
 	Game_UpdateBlock(x, y, z, BLOCK_AIR);
-	Physics_ActivateNeighbours(x, y, z, start);
+	Physics_ActivateNeighbours(x, y, z);
 }
 
 static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
@@ -246,7 +249,7 @@ static void Physics_HandleSapling(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	below = BLOCK_AIR;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World.Blocks[World_Pack(x, y - 1, z)];
 	if (below != BLOCK_GRASS) return;
 
 	height = 5 + Random_Next(&physics_rnd, 3);
@@ -288,15 +291,15 @@ static void Physics_HandleFlower(int index, BlockID block) {
 
 	if (!Lighting_IsLit(x, y, z)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
-		Physics_ActivateNeighbours(x, y, z, index);
+		Physics_ActivateNeighbours(x, y, z);
 		return;
 	}
 
 	below = BLOCK_DIRT;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World.Blocks[World_Pack(x, y - 1, z)];
 	if (!(below == BLOCK_DIRT || below == BLOCK_GRASS)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
-		Physics_ActivateNeighbours(x, y, z, index);
+		Physics_ActivateNeighbours(x, y, z);
 	}
 }
 
@@ -307,15 +310,15 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 	if (Lighting_IsLit(x, y, z)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
-		Physics_ActivateNeighbours(x, y, z, index);
+		Physics_ActivateNeighbours(x, y, z);
 		return;
 	}
 
 	below = BLOCK_STONE;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World.Blocks[World_Pack(x, y - 1, z)];
 	if (!(below == BLOCK_STONE || below == BLOCK_COBBLE)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
-		Physics_ActivateNeighbours(x, y, z, index);
+		Physics_ActivateNeighbours(x, y, z);
 	}
 }
 
@@ -338,11 +341,11 @@ static void Physics_ActivateLava(int index, BlockID block) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateLava(index - 1, x - 1, y, z);
-	if (x < World.MaxX) Physics_PropagateLava(index + 1, x + 1, y, z);
-	if (z > 0)          Physics_PropagateLava(index - World.Width, x, y, z - 1);
-	if (z < World.MaxZ) Physics_PropagateLava(index + World.Width, x, y, z + 1);
-	if (y > 0)          Physics_PropagateLava(index - World.OneY, x, y - 1, z);
+	if (x > 0)          Physics_PropagateLava(World_Pack(x - 1, y, z), x - 1, y, z);
+	if (x < World.MaxX) Physics_PropagateLava(World_Pack(x + 1, y, z), x + 1, y, z);
+	if (z > 0)          Physics_PropagateLava(World_Pack(x, y, z - 1), x, y, z - 1);
+	if (z < World.MaxZ) Physics_PropagateLava(World_Pack(x, y, z + 1), x, y, z + 1);
+	if (y > 0)          Physics_PropagateLava(World_Pack(x, y - 1, z), x, y - 1, z);
 }
 
 static void Physics_TickLava(void) {
@@ -388,11 +391,11 @@ static void Physics_ActivateWater(int index, BlockID block) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z);
-	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z);
-	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1);
-	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1);
-	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
+	if (x > 0)          Physics_PropagateWater(World_Pack(x - 1, y, z), x - 1, y,     z);
+	if (x < World.MaxX) Physics_PropagateWater(World_Pack(x + 1, y, z), x + 1, y,     z);
+	if (z > 0)          Physics_PropagateWater(World_Pack(x, y, z - 1), x,     y,     z - 1);
+	if (z < World.MaxZ) Physics_PropagateWater(World_Pack(x, y, z + 1), x,     y,     z + 1);
+	if (y > 0)          Physics_PropagateWater(World_Pack(x, y - 1, z), x,     y - 1, z);
 }
 
 static void Physics_TickWater(void) {
@@ -451,9 +454,9 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 static void Physics_HandleSlab(int index, BlockID block) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
-	if (index < World.OneY) return;
+	if (y == 0) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_SLAB) return;
+	if (World.Blocks[World_Pack(x, y - 1, z)] != BLOCK_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
 }
@@ -461,9 +464,9 @@ static void Physics_HandleSlab(int index, BlockID block) {
 static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
-	if (index < World.OneY) return;
+	if (y == 0) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_COBBLE_SLAB) return;
+	if (World.Blocks[World_Pack(x, y - 1, z)] != BLOCK_COBBLE_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
 }
@@ -483,7 +486,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 
 	World_Unpack(index, x, y, z);
 	Game_UpdateBlock(x, y, z, BLOCK_AIR);
-	Physics_ActivateNeighbours(x, y, z, index);
+	Physics_ActivateNeighbours(x, y, z);
 	
 	for (dy = -TNT_POWER; dy <= TNT_POWER; dy++) {
 		for (dz = -TNT_POWER; dz <= TNT_POWER; dz++) {
@@ -498,7 +501,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 				if (block < BLOCK_CPE_COUNT && blocksTnt[block]) continue;
 
 				Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
-				Physics_ActivateNeighbours(xx, yy, zz, index);
+				Physics_ActivateNeighbours(xx, yy, zz);
 			}
 		}
 	}
@@ -8,6 +8,7 @@ typedef void (*PhysicsHandler)(int index, BlockID block);
 
 CC_VAR extern struct Physics_ {
 	/* Whether block physics are enabled at all. */
+	/* NOTE: Physics never run on maps stored in sections (see World.Sections), even when enabled. */
 	cc_bool Enabled;
 	/* Called when block is activated by a neighbouring block change. */
 	/* e.g. trigger sand falling, water flooding */
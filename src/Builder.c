@@ -239,6 +239,13 @@ static void PrepareChunk(int x1, int y1, int z1) {
 	}
 }
 
+#ifdef CC_BUILD_TILEDWORLD
+/* Blocks in a row are only contiguous within the same 16x16x16 tile */
+#define Builder_SeekTile(x, y, z) if (((x) & CHUNK_MASK) == 0) index = World_Pack(x, y, z);
+#else
+#define Builder_SeekTile(x, y, z)
+#endif
+
 #define ReadChunkBody(get_block)\
 for (yy = -1; yy < 17; ++yy) {\
 	y = yy + y1;\
@@ -247,6 +254,7 @@ for (yy = -1; yy < 17; ++yy) {\
 		index  = World_Pack(x1 - 1, y, z1 + zz);\
 		cIndex = Builder_PackChunk(-1, yy, zz);\
 		for (xx = -1; xx < 17; ++xx, ++index, ++cIndex) {\
+			Builder_SeekTile(x1 + xx, y, z1 + zz);\
 \
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
@@ -256,6 +264,30 @@ for (yy = -1; yy < 17; ++yy) {\
 	}\
 }
 
+/* Reads a whole row of the chunk at once, instead of looking up each block's section */
+static cc_bool ReadSectionsChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+	cc_bool allAir = true, allSolid = true;
+	int cIndex;
+	BlockID block;
+	int xx, yy, zz;
+
+	for (yy = -1; yy < 17; ++yy) {
+		for (zz = -1; zz < 17; ++zz) {
+			cIndex = Builder_PackChunk(-1, yy, zz);
+			World_GetSectionsRow(x1 - 1, y1 + yy, z1 + zz, &Builder_Chunk[cIndex], EXTCHUNK_SIZE);
+
+			for (xx = -1; xx < 17; ++xx, ++cIndex) {
+				block    = Builder_Chunk[cIndex];
+				allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;
+				allSolid = allSolid && Blocks.FullOpaque[block];
+			}
+		}
+	}
+
+	*outAllAir = allAir;
+	return allSolid;
+}
+
 static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
@@ -263,6 +295,7 @@ static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, y;
+	if (World.Sections) return ReadSectionsChunkData(x1, y1, z1, outAllAir);
 
 #ifndef EXTENDED_BLOCKS
 	ReadChunkBody(blocks[index]);
@@ -297,6 +330,7 @@ for (yy = -1; yy < 17; ++yy) {\
 			x = xx + x1;\
 			if (x < 0) continue;\
 			if (x >= World.Width) break;\
+			Builder_SeekTile(x, y, z);\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
@@ -313,6 +347,12 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockID block;
 	int xx, yy, zz, x, y, z;
 
+	if (World.Sections) {
+		ReadBorderChunkBody(World_GetSectionsBlock(x, y, z));
+		*outAllAir = allAir;
+		return false;
+	}
+
 #ifndef EXTENDED_BLOCKS
 	ReadBorderChunkBody(blocks[index]);
 #else
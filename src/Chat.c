@@ -18,6 +18,7 @@
 #include "TexturePack.h"
 #include "Options.h"
 #include "Drawer2D.h"
+#include "Protocol.h"
 
 static char msgs[12][STRING_SIZE];
 cc_string Chat_Status[4]       = { String_FromArray(msgs[0]), String_FromArray(msgs[1]), String_FromArray(msgs[2]), String_FromArray(msgs[3]) };
@@ -479,6 +480,70 @@ static struct ChatCommand ClearDeniedCommand = {
 	}
 };
 
+static void PacketsCommand_Execute(const cc_string* args, int argsCount) {
+	static const cc_string defPath = String_FromConst("packets.cctrace");
+	const cc_string* path;
+	cc_result res;
+
+	if (!argsCount) {
+		if (!PacketProfiler_IsEnabled()) {
+			Chat_AddRaw("&e/client: &cPacket profiling is not started."); return;
+		}
+		Chat_AddRaw("&e/client: &fPacket types which used the most time:");
+		PacketProfiler_PrintTop(5);
+	} else if (String_CaselessEqualsConst(&args[0], "start")) {
+		PacketProfiler_SetEnabled(true);
+		Chat_AddRaw("&e/client: &fStarted packet profiling.");
+	} else if (String_CaselessEqualsConst(&args[0], "stop")) {
+		PacketProfiler_SetEnabled(false);
+		Chat_AddRaw("&e/client: &fStopped packet profiling.");
+	} else if (String_CaselessEqualsConst(&args[0], "trace")) {
+		path = argsCount > 1 ? &args[1] : &defPath;
+		res  = PacketProfiler_StartTrace(path);
+
+		if (res) { Logger_SysWarn2(res, "creating", path); return; }
+		Chat_Add1("&e/client: &fSaving received packets to &e%s", path);
+	} else {
+		Chat_Add1("&e/client: &cUnrecognised packets option &f\"%s\"&c.", &args[0]);
+	}
+}
+
+static struct ChatCommand PacketsCommand = {
+	"Packets", PacketsCommand_Execute, false,
+	{
+		"&a/client packets [start/stop]",
+		"&eRecords how long handling each type of received packet takes.",
+		"&eWith no arguments, shows which types used the most time per second.",
+		"&a/client packets trace [file]",
+		"&eAlso saves all received packets to the given file.",
+	}
+};
+
+
+/*########################################################################################################################*
+*----------------------------------------------------ReloadTextureCommand-------------------------------------------------*
+*#########################################################################################################################*/
+static void ReloadTextureCommand_Execute(const cc_string* args, int argsCount) {
+	if (!argsCount) {
+		Chat_AddRaw("&e/client reloadtexture: &cYou didn't specify a file."); return;
+	}
+
+	if (TexturePack_ExtractFile(&args[0])) {
+		Chat_Add1("&e/client reloadtexture: &fReloaded %s", &args[0]);
+	} else {
+		Chat_Add1("&e/client reloadtexture: &c\"%s\" is not in the current texture pack.", &args[0]);
+	}
+}
+
+static struct ChatCommand ReloadTextureCommand = {
+	"ReloadTexture", ReloadTextureCommand_Execute, false,
+	{
+		"&a/client reloadtexture [file]",
+		"&eReloads just the given file (e.g. terrain.png) from the current texture pack.",
+		"&eUseful when editing a texture pack, as the rest of the pack is not reloaded.",
+	}
+};
+
 
 /*########################################################################################################################*
 *-------------------------------------------------------CuboidCommand-----------------------------------------------------*
@@ -640,6 +705,8 @@ static void OnInit(void) {
 	Commands_Register(&CuboidCommand);
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
+	Commands_Register(&PacketsCommand);
+	Commands_Register(&ReloadTextureCommand);
 
 #if defined CC_BUILD_MINFILES 
 #elif defined CC_BUILD_ANDROID
@@ -130,6 +130,9 @@ typedef cc_uint16 TextureLoc;
 typedef cc_uint8 TextureLoc;
 #endif
 
+/* Stores blocks in 16x16x16 tiles instead of rows (see World_Pack) */
+/*#define CC_BUILD_TILEDWORLD*/
+
 typedef cc_uint8 BlockRaw;
 typedef cc_uint8 EntityID;
 typedef cc_uint8 Face;
@@ -6,6 +6,7 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Utils.h"
+#include "Bitmap.h"
 
 #define Header_ReadU8(value) if ((res = s->ReadU8(s, &value))) return res;
 /*########################################################################################################################*
@@ -142,7 +143,7 @@ enum INFLATE_STATE_ {
 };
 
 /* Insert next byte into the bit buffer */
-#define Inflate_GetByte(state) state->AvailIn--; state->Bits |= (cc_uint32)(*state->NextIn++) << state->NumBits; state->NumBits += 8;
+#define Inflate_GetByte(state) state->AvailIn--; state->Bits |= (cc_uint64)(*state->NextIn++) << state->NumBits; state->NumBits += 8;
 /* Retrieves bits from the bit buffer */
 #define Inflate_PeekBits(state, bits) (state->Bits & ((1UL << (bits)) - 1UL))
 /* Consumes/eats up bits from the bit buffer */
@@ -164,8 +165,10 @@ enum INFLATE_STATE_ {
 #define Inflate_NextCompressState(state) ((state->AvailIn >= INFLATE_FASTINF_IN && state->AvailOut >= INFLATE_FASTINF_OUT) ? INFLATE_STATE_FASTCOMPRESSED : INFLATE_STATE_COMPRESSED_LIT)
 /* The maximum amount of bytes that can be output is 258 */
 #define INFLATE_FASTINF_OUT 258
-/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
-#define INFLATE_FASTINF_IN 10
+/* The bit buffer is refilled by reading 8 bytes at once. (which may only use up 1 of them) */
+/* The most bits required for huffman codes and extra data is 15 + 5 + 15 + 13 = 48, and a refill guarantees 56 bits. */
+#define INFLATE_FASTINF_IN 16
+#define INFLATE_FAST_MASK ((1 << INFLATE_FAST_BITS) - 1)
 
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
@@ -296,44 +299,52 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
-/* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
-{\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.Fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
-	if (packed >= 0) {\
-		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
-		result = packed & 0x1FF;\
-	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
-	}\
-}
-
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
-	cc_uint32 i, j, codeword;
+/* Decodes a codeword longer than INFLATE_FAST_BITS, from the given bits */
+/* Returns -1 if the bits are not a valid codeword */
+static int Huffman_DecodeSlow(struct HuffmanTable* table, cc_uint64 bits, cc_uint32* len) {
+	cc_uint32 i, codeword;
 	int offset;
 
 	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
-	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
+	codeword = Huffman_ReverseBits((cc_uint32)bits & INFLATE_FAST_MASK, INFLATE_FAST_BITS);
+	bits >>= INFLATE_FAST_BITS;
 
-	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
+	for (i = INFLATE_FAST_BITS + 1; i < INFLATE_MAX_BITS; i++, bits >>= 1) {
+		codeword = (codeword << 1) | ((cc_uint32)bits & 1);
 
 		if (codeword < table->EndCodewords[i]) {
 			offset = table->FirstOffsets[i] + (codeword - table->FirstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
+			*len   = i;
 			return table->Values[offset];
 		}
 	}
+	return -1;
+}
 
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
-	return 0;
+/* Builds lookup table for decoding two literals at once, from the fast literals/lengths table */
+/* Only possible when the codewords of both literals fit within INFLATE_FAST_BITS */
+static void Inflate_BuildLitPairs(struct InflateState* s) {
+	struct HuffmanTable* table = &s->Table.Lits;
+	int i, packed, len1, len2, lit1, lit2;
+
+	for (i = 0; i < (1 << INFLATE_FAST_BITS); i++) {
+		s->LitPairs[i] = 0;
+		packed = table->Fast[i];
+		if (packed < 0) continue;
+
+		len1 = packed >> INFLATE_FAST_BITS;
+		lit1 = packed & 0x1FF;
+		if (lit1 >= 256) continue;
+
+		/* Remaining bits, with unknown upper bits zeroed */
+		packed = table->Fast[i >> len1];
+		if (packed < 0) continue;
+
+		len2 = packed >> INFLATE_FAST_BITS;
+		lit2 = packed & 0x1FF;
+		if (lit2 >= 256 || len1 + len2 > INFLATE_FAST_BITS) continue;
+		s->LitPairs[i] = lit1 | (lit2 << 8) | ((len1 + len2) << 16);
+	}
 }
 
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
@@ -389,14 +400,59 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* Reads 8 bytes of input in little endian order, which might not be aligned */
+static CC_INLINE cc_uint64 Inflate_Load64(const cc_uint8* src) {
+#if defined __GNUC__ && !defined CC_BIG_ENDIAN
+	cc_uint64 value;
+	/* memcpy compiles down to a single unaligned load */
+	__builtin_memcpy(&value, src, 8);
+	return value;
+#else
+	return (cc_uint64)src[0]         | ((cc_uint64)src[1] << 8)  | ((cc_uint64)src[2] << 16) | ((cc_uint64)src[3] << 24) |
+		  ((cc_uint64)src[4] << 32) | ((cc_uint64)src[5] << 40) | ((cc_uint64)src[6] << 48) | ((cc_uint64)src[7] << 56);
+#endif
+}
+
+#if defined __GNUC__
+#define Inflate_Copy8(dst, src) __builtin_memcpy(dst, src, 8)
+#else
+#define Inflate_Copy8(dst, src) dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; dst[4] = src[4]; dst[5] = src[5]; dst[6] = src[6]; dst[7] = src[7];
+#endif
+
+/* Decodes a huffman code using the local bit buffer in Inflate_InflateFast */
+/* NOTE: Exits the decode loop if the codeword is invalid */
+#define Inflate_FastDecode(table, result) \
+	packed = table.Fast[bitbuf & INFLATE_FAST_MASK];\
+	if (packed >= 0) {\
+		bits   = packed >> INFLATE_FAST_BITS;\
+		result = packed & 0x1FF;\
+	} else {\
+		result = Huffman_DecodeSlow(&table, bitbuf, &bits);\
+		if (result < 0) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }\
+	}\
+	bitbuf >>= bits; bitcount -= bits;
+
+/* Peeks then consumes given bits from the local bit buffer */
+#define Inflate_FastReadBits(value, count) \
+	value = (cc_uint32)bitbuf & ((1UL << (count)) - 1UL);\
+	bitbuf >>= (count); bitcount -= (count);
+
 static void Inflate_InflateFast(struct InflateState* s) {
+	/* bit buffer variables */
+	cc_uint64 bitbuf;
+	cc_uint32 bitcount;
+	cc_uint8* in;
+	cc_uint8* inEnd;
+
 	/* huffman variables */
-	cc_uint32 lit, len, dist;
-	cc_uint32 bits, lenIdx, distIdx;
-	int packed, consumedBits;
+	cc_uint32 len, dist, pair, extra;
+	cc_uint32 bits, availOut;
+	int lit, distIdx, packed;
 
 	/* window variables */
 	cc_uint8* window;
+	cc_uint8* src;
+	cc_uint8* dst;
 	cc_uint32 i, curIdx, startIdx;
 	cc_uint32 copyStart, copyLen, partLen;
 
@@ -404,52 +460,87 @@ static void Inflate_InflateFast(struct InflateState* s) {
 	curIdx = s->WindowIndex;
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
+	availOut  = s->AvailOut;
+
+	bitbuf   = s->Bits;
+	bitcount = s->NumBits;
+	in       = s->NextIn;
+	/* Input must have at least 8 bytes left for a refill */
+	inEnd    = s->NextIn + s->AvailIn - 8;
 
 #define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
-	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
-		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
+	while (availOut >= INFLATE_FASTINF_OUT && in <= inEnd && copyLen < INFLATE_FAST_COPY_MAX) {
+		/* Refill bit buffer to at least 56 bits, using only the bytes that fully fit */
+		/* Any bits above bitcount are from the next input bytes, so OR-ing them in again is harmless */
+		bitbuf   |= Inflate_Load64(in) << bitcount;
+		in       += (63 - bitcount) >> 3;
+		bitcount |= 56;
+
+		/* Common case of two short literals in a row */
+		pair = s->LitPairs[bitbuf & INFLATE_FAST_MASK];
+		if (pair) {
+			window[curIdx] = (cc_uint8)pair;
+			window[(curIdx + 1) & INFLATE_WINDOW_MASK] = (cc_uint8)(pair >> 8);
+			curIdx = (curIdx + 2) & INFLATE_WINDOW_MASK;
+			availOut -= 2; copyLen += 2;
+
+			bits = pair >> 16;
+			bitbuf >>= bits; bitcount -= bits;
+			continue;
+		}
 
-		if (lit <= 256) {
-			if (lit < 256) {
-				window[curIdx] = (cc_uint8)lit;
-				s->AvailOut--; copyLen++;
-				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+		Inflate_FastDecode(s->Table.Lits, lit);
+		if (lit < 256) {
+			window[curIdx] = (cc_uint8)lit;
+			availOut--; copyLen++;
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			continue;
+		} else if (lit == 256) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		}
+
+		lit -= 257;
+		Inflate_FastReadBits(extra, len_bits[lit]);
+		len = len_base[lit] + extra;
+
+		Inflate_FastDecode(s->TableDists, distIdx);
+		Inflate_FastReadBits(extra, dist_bits[distIdx]);
+		dist = dist_base[distIdx] + extra;
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			src = &window[startIdx]; 
+			dst = &window[curIdx];
+
+			if (dist >= 8) {
+				/* Each 8 bytes read are always before the 8 bytes written */
+				for (i = 0; i + 8 <= len; i += 8) { Inflate_Copy8((dst + i), (src + i)); }
+				for (; i < len; i++) { dst[i] = src[i]; }
+			} else if (dist == 1) {
+				/* Run of the same byte */
+				Mem_Set(dst, *src, len);
 			} else {
-				s->State = Inflate_NextBlockState(s);
-				break;
+				for (i = 0; i < len; i++) { dst[i] = src[i]; }
 			}
 		} else {
-			lenIdx = lit - 257;
-			bits = len_bits[lenIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			len  = len_base[lenIdx] + Inflate_ReadBits(s, bits);
-
-			Huffman_UNSAFE_Decode(s, s->TableDists, distIdx);
-			bits = dist_bits[distIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			dist = dist_base[distIdx] + Inflate_ReadBits(s, bits);
-	
-			/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
-			/* If start and end don't cross a boundary, can avoid masking index */
-			startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
-			if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
-				cc_uint8* src = &window[startIdx]; 
-				cc_uint8* dst = &window[curIdx];
-
-				for (i = 0; i < (len & ~0x3); i += 4) {
-					*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
-				}
-				for (; i < len; i++) { *dst++ = *src++; }
-			} else {
-				for (i = 0; i < len; i++) {
-					window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
-				}
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
 			}
-			curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
-			s->AvailOut -= len; copyLen += len;
 		}
+		curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
+		availOut -= len; copyLen += len;
 	}
 
+	/* Only keep the bits that have actually been read from input */
+	s->Bits     = bitbuf & (((cc_uint64)1 << bitcount) - 1);
+	s->NumBits  = bitcount;
+	s->AvailIn -= (cc_uint32)(in - s->NextIn);
+	s->NextIn   = in;
+	s->AvailOut = availOut;
+
 	s->WindowIndex = curIdx;
 	if (!copyLen) return;
 
@@ -497,6 +588,7 @@ void Inflate_Process(struct InflateState* s) {
 			case 1: { /* Fixed/static huffman compressed */
 				(void)Huffman_Build(&s->Table.Lits, fixed_lits,  INFLATE_MAX_LITS);
 				(void)Huffman_Build(&s->TableDists, fixed_dists, INFLATE_MAX_DISTS);
+				Inflate_BuildLitPairs(s);
 				s->State = Inflate_NextCompressState(s);
 			} break;
 
@@ -606,6 +698,7 @@ void Inflate_Process(struct InflateState* s) {
 				if (res) { Inflate_Fail(s, res); return; }
 				res = Huffman_Build(&s->TableDists, s->Buffer + s->NumLits, s->NumDists);
 				if (res) { Inflate_Fail(s, res); return; }
+				Inflate_BuildLitPairs(s);
 			}
 			break;
 		}
@@ -768,6 +861,34 @@ void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, stru
 	stream->Read = Inflate_StreamRead;
 }
 
+cc_result Inflate_ProcessSpans(struct InflateState* s, struct InflateSpan* spans, int count,
+								cc_uint8* output, cc_uint32 outputLen, cc_uint32* written) {
+	int i;
+	s->Output   = output;
+	s->AvailOut = outputLen;
+
+	/* Input already buffered in state must be used up before moving onto the spans */
+	if (s->AvailIn) {
+		Inflate_Process(s);
+		if (s->AvailIn) count = 0;
+	}
+
+	for (i = 0; i < count && s->AvailOut && s->State != INFLATE_STATE_DONE; i++) {
+		s->NextIn  = spans[i].Data;
+		s->AvailIn = spans[i].Length;
+		Inflate_Process(s);
+
+		spans[i].Data   = s->NextIn;
+		spans[i].Length = s->AvailIn;
+		/* Never leave NextIn pointing outside Input, as Inflate_StreamRead refills from there */
+		s->NextIn  = s->Input;
+		s->AvailIn = 0;
+	}
+
+	*written = outputLen - s->AvailOut;
+	return s->State == INFLATE_STATE_DONE ? s->result : 0;
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Deflate (compress)----------------------------------------------------*
@@ -786,154 +907,499 @@ static const cc_uint16 deflate_dist[31] = {
 
 /* Pushes given bits, but does not write them */
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
-/* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
-#define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
 /* Pushes given bits (reversing for huffman code), but does not write them */
 #define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
 #define Deflate_FlushBits(state) while (state->NumBits >= 8) { Deflate_WriteByte(state); }
+/* Pushes the given bits, then flushes them to output buffer */
+#define Deflate_WriteBits(state, value, bits) Deflate_PushBits(state, value, bits); Deflate_FlushBits(state);
 
 #define MIN_MATCH_LEN 3
 #define MAX_MATCH_LEN 258
+#define DEFLATE_NUM_LITS  286 /* 286 and 287 are never used */
+#define DEFLATE_NUM_DISTS 30  /* 30 and 31 are never used */
+#define DEFLATE_MAX_BITS 15
+#define DEFLATE_MAX_CODELEN_BITS 7
+/* Leaves enough room in output buffer for any single symbol, or a block header */
+#define DEFLATE_OUT_SLACK 384
+
+/* Parameters used to find matches, from fastest to best compression */
+static const struct DeflateLevel {
+	cc_uint16 maxChain;  /* Max number of previous matches to check */
+	cc_uint16 niceLen;   /* Stop searching once a match is at least this long */
+	cc_uint16 insertLen; /* Every position within matches up to this long is added to hash chains */
+	cc_bool lazy;        /* Whether to check for a longer match starting at the next byte */
+} deflate_levels[DEFLATE_LEVEL_BEST + 1] = {
+	{    0,   0,   0, false }, /* only stored or literals */
+	{    1,   8,   4, false },
+	{    2,  16,   8, false },
+	{    4,  32,  16, false },
+	{    4,  16,  16, true  },
+	{    8,  32,  32, true  },
+	{    8, 128,  32, true  },
+	{   32, 128, 128, true  },
+	{  128, 258, 258, true  },
+	{ 1024, 258, 258, true  }
+};
 
+#define DEFLATE_WINDOW_MASK (DEFLATE_BUFFER_SIZE - 1)
+/* Stream positions are rebased before they can overflow */
+#define DEFLATE_REBASE_LIMIT 0x40000000UL
+
+#if defined __GNUC__ && !defined CC_BIG_ENDIAN
+/* Compares 8 bytes at a time, using the lowest differing bit to find the first differing byte */
+static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
+	cc_uint64 x, y;
+	int i = 0;
+
+	for (; i + 8 <= maxLen; i += 8) {
+		/* memcpy compiles down to a single unaligned load */
+		__builtin_memcpy(&x, a + i, 8);
+		__builtin_memcpy(&y, b + i, 8);
+		if (x != y) return i + (__builtin_ctzll(x ^ y) >> 3);
+	}
+	while (i < maxLen && a[i] == b[i]) i++;
+	return i;
+}
+#else
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 	int i = 0;
 	while (i < maxLen && *a == *b) { i++; a++; b++; }
 	return i;
 }
+#endif
 
-/* Hashes 3 bytes of data */
+/* Hashes 3 bytes of data, using the top bits of a multiplicative (Fibonacci) hash */
 static cc_uint32 Deflate_Hash(cc_uint8* src) {
-	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
+	cc_uint32 value = src[0] | (src[1] << 8) | (src[2] << 16);
+	value *= 0x9E3779B1UL; /* unsigned long might be 64 bits */
+	return value >> (32 - DEFLATE_HASH_BITS);
 }
 
-/* Writes a literal to state->Output */
-static void Deflate_Lit(struct DeflateState* state, int lit) {
-	Deflate_PushLit(state, lit);
-	Deflate_FlushBits(state);
+/* Adds the given position to the front of its hash chain */
+static void Deflate_Insert(struct DeflateState* state, cc_uint8* src) {
+	cc_uint32 hash = Deflate_Hash(src);
+	cc_uint32 pos  = state->WindowBase + (cc_uint32)(src - state->Input);
+
+	state->Prev[pos & DEFLATE_WINDOW_MASK] = state->Head[hash];
+	state->Head[hash] = pos;
 }
 
-/* Writes a length-distance pair to state->Output */
-static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
+/* Returns the index of the length symbol for the given match length */
+static int Deflate_LenIndex(int len) {
 	int j;
-	/* TODO: Do we actually need the if (len_bits[j]) ????????? does writing 0 bits matter??? */
-
 	for (j = 0; len >= deflate_len[j + 1]; j++);
-	Deflate_PushLit(state, j + 257);
-	if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
-	Deflate_FlushBits(state);
+	return j;
+}
 
+/* Returns the index of the distance symbol for the given match distance */
+static int Deflate_DistIndex(int dist) {
+	int j;
 	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
-	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
-	Deflate_FlushBits(state);
+	return j;
+}
+
+/* Records a literal in the current block's symbols */
+static void Deflate_Lit(struct DeflateState* state, int lit) {
+	cc_uint8* sym = &state->Symbols[state->NumSymbols * 3];
+	sym[0] = 0; sym[1] = 0; sym[2] = lit;
+
+	state->LitsFreqs[lit]++;
+	state->NumSymbols++;
+}
+
+/* Records a length-distance pair in the current block's symbols */
+static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
+	cc_uint8* sym = &state->Symbols[state->NumSymbols * 3];
+	sym[0] = (cc_uint8)dist; sym[1] = (cc_uint8)(dist >> 8); sym[2] = len - MIN_MATCH_LEN;
+
+	state->LitsFreqs[Deflate_LenIndex(len) + 257]++;
+	state->DistsFreqs[Deflate_DistIndex(dist)]++;
+	state->NumSymbols++;
 }
 
 /* Moves "current block" to "previous block", adjusting state if needed. */
 static void Deflate_MoveBlock(struct DeflateState* state) {
+	cc_uint32 base;
 	int i;
 	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
 	state->InputPosition = DEFLATE_BLOCK_SIZE;
 
-	/* adjust hash table offsets, removing offsets that are no longer in data at all */
+	/* Hash chains store stream positions, so only the window base needs to move */
+	/* (positions at or before the window base are treated as end of chain) */
+	state->WindowBase += DEFLATE_BLOCK_SIZE;
+	if (state->WindowBase < DEFLATE_REBASE_LIMIT) return;
+	base = state->WindowBase;
+
+	/* Very rarely, rebase positions so they don't overflow */
 	for (i = 0; i < Array_Elems(state->Head); i++) {
-		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
+		state->Head[i] = state->Head[i] <= base ? 0 : (state->Head[i] - base);
 	}
 	for (i = 0; i < Array_Elems(state->Prev); i++) {
-		state->Prev[i] = state->Prev[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Prev[i] - DEFLATE_BLOCK_SIZE);
+		state->Prev[i] = state->Prev[i] <= base ? 0 : (state->Prev[i] - base);
+	}
+	state->WindowBase = 0;
+}
+
+/* Writes all the data in Output buffer to the destination stream */
+static cc_result Deflate_FlushOutput(struct DeflateState* state) {
+	cc_result res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+
+/* Computes canonical huffman codewords (bit reversed, ready for writing) from codeword lengths */
+static void Deflate_MakeCodes(const cc_uint8* lens, int count, cc_uint16* codewords) {
+	int bl_count[INFLATE_MAX_BITS], next[INFLATE_MAX_BITS];
+	int i, code;
+
+	for (i = 0; i < INFLATE_MAX_BITS; i++) bl_count[i] = 0;
+	for (i = 0; i < count; i++) bl_count[lens[i]]++;
+	bl_count[0] = 0;
+
+	code = 0;
+	for (i = 1; i < INFLATE_MAX_BITS; i++) {
+		code    = (code + bl_count[i - 1]) << 1;
+		next[i] = code;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!lens[i]) continue;
+		codewords[i] = Huffman_ReverseBits(next[lens[i]]++, lens[i]);
+	}
+}
+
+/* Computes huffman codeword lengths (no longer than maxBits) for the given symbol frequencies */
+static void Deflate_BuildLengths(const cc_uint32* freqs, int count, int maxBits, cc_uint8* lens) {
+	cc_uint16 syms[INFLATE_MAX_LITS];
+	cc_uint32 weights[INFLATE_MAX_LITS * 2];
+	cc_uint16 parents[INFLATE_MAX_LITS * 2];
+	int numCodes[DEFLATE_MAX_BITS + 1];
+	int i, j, n, len, total;
+	int leaf, node, next, pick;
+
+	/* Sort used symbols by frequency, least frequent first */
+	Mem_Set(lens, 0, count);
+	for (i = 0, n = 0; i < count; i++) {
+		if (!freqs[i]) continue;
+		for (j = n; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) { syms[j] = syms[j - 1]; }
+		syms[j] = i; n++;
+	}
+
+	/* A code must have at least two codewords */
+	if (n < 2) {
+		lens[0] = 1; lens[1] = 1;
+		if (n == 1 && syms[0] > 1) { lens[0] = 0; lens[syms[0]] = 1; }
+		return;
+	}
+
+	/* Build the huffman tree from leaves (in sorted order) and internal nodes (created in increasing weight order) */
+	for (i = 0; i < n; i++) weights[i] = freqs[syms[i]];
+	leaf = 0; node = n;
+
+	for (next = n; next < 2 * n - 1; next++) {
+		weights[next] = 0;
+		for (j = 0; j < 2; j++) {
+			if (leaf < n && (node >= next || weights[leaf] <= weights[node])) {
+				pick = leaf++;
+			} else {
+				pick = node++;
+			}
+			parents[pick]  = next;
+			weights[next] += weights[pick];
+		}
+	}
+
+	/* Each node is one level deeper than its parent, with the root (last node) at depth 0 */
+	weights[2 * n - 2] = 0;
+	for (i = 2 * n - 3; i >= 0; i--) { weights[i] = weights[parents[i]] + 1; }
+
+	for (i = 0; i <= maxBits; i++) numCodes[i] = 0;
+	for (i = 0; i < n; i++) { numCodes[min((int)weights[i], maxBits)]++; }
+
+	/* Codewords longer than maxBits were shortened, so now too many codewords for the available codespace */
+	/* Fix this by removing a maxBits codeword, and making a shorter codeword one bit longer (giving two codewords) */
+	total = 0;
+	for (i = maxBits; i > 0; i--) { total += numCodes[i] << (maxBits - i); }
+
+	while (total != (1 << maxBits)) {
+		numCodes[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numCodes[i]) continue;
+			numCodes[i]--; numCodes[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Least frequent symbols get the longest codewords */
+	for (len = maxBits, i = 0; len > 0; len--) {
+		for (j = numCodes[len]; j > 0; j--) { lens[syms[i++]] = len; }
+	}
+}
+
+/* Run length encodes the combined literal and distance codeword lengths, as described in the DEFLATE spec */
+static int Deflate_EncodeLens(const cc_uint8* lens, int count, cc_uint8* syms, cc_uint8* extra) {
+	int i, run, n = 0, len;
+
+	for (i = 0; i < count; i += run) {
+		len = lens[i];
+		for (run = 1; i + run < count && lens[i + run] == len; run++) { }
+
+		if (len == 0 && run >= 11) {
+			run = min(run, 138);
+			syms[n] = 18; extra[n] = run - 11; n++;
+		} else if (len == 0 && run >= 3) {
+			run = min(run, 10);
+			syms[n] = 17; extra[n] = run - 3;  n++;
+		} else if (len && run >= 4) {
+			/* Codeword length itself, then repeat it */
+			run = min(run, 7);
+			syms[n] = len; extra[n] = 0;       n++;
+			syms[n] = 16;  extra[n] = run - 4; n++;
+		} else {
+			run = 1;
+			syms[n] = len; extra[n] = 0; n++;
+		}
+	}
+	return n;
+}
+static const cc_uint8 codelens_extra[INFLATE_MAX_CODELENS] = { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 2,3,7 };
+
+/* Returns the number of bits needed to encode the current block's symbols using the given codeword lengths */
+static cc_uint32 Deflate_SymbolsCost(struct DeflateState* state, const cc_uint8* litsLens, const cc_uint8* distsLens) {
+	cc_uint32 bits = 0;
+	int i;
+
+	for (i = 0; i < DEFLATE_NUM_LITS; i++) {
+		bits += state->LitsFreqs[i] * litsLens[i];
+	}
+	for (i = 257; i < DEFLATE_NUM_LITS; i++) {
+		bits += state->LitsFreqs[i] * len_bits[i - 257];
+	}
+	for (i = 0; i < DEFLATE_NUM_DISTS; i++) {
+		bits += state->DistsFreqs[i] * (distsLens[i] + dist_bits[i]);
+	}
+	return bits;
+}
+
+/* Writes the current block's symbols using the given huffman codes */
+static cc_result Deflate_WriteSymbols(struct DeflateState* state, const cc_uint16* litsCodes, const cc_uint8* litsLens,
+									const cc_uint16* distsCodes, const cc_uint8* distsLens) {
+	cc_uint8* sym = state->Symbols;
+	int i, j, len, dist;
+	cc_result res;
+
+	for (i = 0; i < state->NumSymbols; i++, sym += 3) {
+		dist = sym[0] | (sym[1] << 8);
+
+		if (!dist) {
+			Deflate_WriteBits(state, litsCodes[sym[2]], litsLens[sym[2]]);
+		} else {
+			len = sym[2] + MIN_MATCH_LEN;
+			j   = Deflate_LenIndex(len);
+			Deflate_WriteBits(state, litsCodes[j + 257], litsLens[j + 257]);
+			Deflate_WriteBits(state, len - deflate_len[j], len_bits[j]);
+
+			j   = Deflate_DistIndex(dist);
+			Deflate_WriteBits(state, distsCodes[j], distsLens[j]);
+			Deflate_WriteBits(state, dist - deflate_dist[j], dist_bits[j]);
+		}
+
+		if (state->AvailOut >= DEFLATE_OUT_SLACK) continue;
+		if ((res = Deflate_FlushOutput(state))) return res;
+	}
+
+	/* End of block symbol */
+	Deflate_WriteBits(state, litsCodes[256], litsLens[256]);
+	return 0;
+}
+
+static cc_result Deflate_WriteStored(struct DeflateState* state, const cc_uint8* data, int len, cc_bool final) {
+	int count;
+	cc_result res;
+
+	Deflate_WriteBits(state, final, 3); /* block type STORED */
+	if (state->NumBits) {
+		Deflate_WriteBits(state, 0, 8 - state->NumBits);
+	}
+	Deflate_WriteBits(state, len,            16);
+	Deflate_WriteBits(state, len ^ 0xFFFF,   16);
+
+	while (len > 0) {
+		if (!state->AvailOut && (res = Deflate_FlushOutput(state))) return res;
+		count = min(len, (int)state->AvailOut);
+
+		Mem_Copy(state->NextOut, data, count);
+		state->NextOut  += count; state->AvailOut -= count;
+		data += count; len -= count;
+	}
+	return 0;
+}
+
+/* Writes the symbols recorded for the current block, using whichever block type is smallest */
+static cc_result Deflate_WriteBlock(struct DeflateState* state, const cc_uint8* data, int len, cc_bool final) {
+	cc_uint8 litsLens[DEFLATE_NUM_LITS], distsLens[DEFLATE_NUM_DISTS];
+	cc_uint8 lens[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS];
+	cc_uint16 litsCodes[DEFLATE_NUM_LITS], distsCodes[DEFLATE_NUM_DISTS];
+
+	cc_uint8 rleSyms[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS], rleExtra[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS];
+	cc_uint32 codeLensFreqs[INFLATE_MAX_CODELENS];
+	cc_uint8  codeLensLens[INFLATE_MAX_CODELENS];
+	cc_uint16 codeLensCodes[INFLATE_MAX_CODELENS];
+
+	cc_uint32 dynamicBits, fixedBits, storedBits;
+	int numLits, numDists, numCodeLens, numRle, i, sym;
+	cc_result res;
+
+	if (state->AvailOut < DEFLATE_OUT_SLACK && (res = Deflate_FlushOutput(state))) return res;
+	state->LitsFreqs[256]++; /* end of block symbol */
+
+	Deflate_BuildLengths(state->LitsFreqs,  DEFLATE_NUM_LITS,  DEFLATE_MAX_BITS, litsLens);
+	Deflate_BuildLengths(state->DistsFreqs, DEFLATE_NUM_DISTS, DEFLATE_MAX_BITS, distsLens);
+	for (numLits  = DEFLATE_NUM_LITS;  numLits  > 257 && !litsLens[numLits - 1];   numLits--)  { }
+	for (numDists = DEFLATE_NUM_DISTS; numDists > 1   && !distsLens[numDists - 1]; numDists--) { }
+
+	/* Literal and distance codeword lengths are written as one sequence */
+	Mem_Copy(lens,           litsLens,  numLits);
+	Mem_Copy(lens + numLits, distsLens, numDists);
+	numRle = Deflate_EncodeLens(lens, numLits + numDists, rleSyms, rleExtra);
+
+	Mem_Set(codeLensFreqs, 0, sizeof(codeLensFreqs));
+	for (i = 0; i < numRle; i++) codeLensFreqs[rleSyms[i]]++;
+	Deflate_BuildLengths(codeLensFreqs, INFLATE_MAX_CODELENS, DEFLATE_MAX_CODELEN_BITS, codeLensLens);
+	for (numCodeLens = INFLATE_MAX_CODELENS; numCodeLens > 4 && !codeLensLens[codelens_order[numCodeLens - 1]]; numCodeLens--) { }
+
+	dynamicBits = 3 + 5 + 5 + 4 + 3 * numCodeLens + Deflate_SymbolsCost(state, litsLens, distsLens);
+	for (i = 0; i < numRle; i++) {
+		dynamicBits += codeLensLens[rleSyms[i]] + codelens_extra[rleSyms[i]];
+	}
+	fixedBits  = 3 + Deflate_SymbolsCost(state, fixed_lits, fixed_dists);
+	storedBits = 3 + 7 + 32 + len * 8;
+
+	if (storedBits <= fixedBits && storedBits <= dynamicBits) {
+		res = Deflate_WriteStored(state, data, len, final);
+	} else if (fixedBits <= dynamicBits) {
+		Deflate_WriteBits(state, final | (1 << 1), 3); /* block type FIXED */
+		res = Deflate_WriteSymbols(state, state->FixedLitsCodes, fixed_lits, state->FixedDistsCodes, fixed_dists);
+	} else {
+		Deflate_MakeCodes(litsLens,     DEFLATE_NUM_LITS,     litsCodes);
+		Deflate_MakeCodes(distsLens,    DEFLATE_NUM_DISTS,    distsCodes);
+		Deflate_MakeCodes(codeLensLens, INFLATE_MAX_CODELENS, codeLensCodes);
+
+		Deflate_WriteBits(state, final | (2 << 1), 3); /* block type DYNAMIC */
+		Deflate_WriteBits(state, numLits  - 257, 5);
+		Deflate_WriteBits(state, numDists - 1,   5);
+		Deflate_WriteBits(state, numCodeLens - 4, 4);
+
+		for (i = 0; i < numCodeLens; i++) {
+			Deflate_WriteBits(state, codeLensLens[codelens_order[i]], 3);
+		}
+		for (i = 0; i < numRle; i++) {
+			if (state->AvailOut < DEFLATE_OUT_SLACK && (res = Deflate_FlushOutput(state))) return res;
+			sym = rleSyms[i];
+			Deflate_WriteBits(state, codeLensCodes[sym], codeLensLens[sym]);
+			Deflate_WriteBits(state, rleExtra[i], codelens_extra[sym]);
+		}
+		res = Deflate_WriteSymbols(state, litsCodes, litsLens, distsCodes, distsLens);
 	}
+
+	Mem_Set(state->LitsFreqs,  0, sizeof(state->LitsFreqs));
+	Mem_Set(state->DistsFreqs, 0, sizeof(state->DistsFreqs));
+	state->NumSymbols = 0;
+	return res;
 }
 
+
 /* Compresses current block of data */
-static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
-	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
-	int bestPos, pos, nextPos;
-	cc_uint16 oldHead;
+static cc_result Deflate_FlushBlock(struct DeflateState* state, int len, cc_bool final) {
+	const struct DeflateLevel* level = &deflate_levels[state->Level];
+	int bestLen, maxLen, matchLen, depth, i;
+	cc_uint32 base, bestPos, pos, nextPos;
 	cc_uint8* input;
 	cc_uint8* cur;
+	cc_uint8* blockBeg;
 	cc_result res;
 
-	if (!state->WroteHeader) {
-		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
-	}
-
 	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
 	https://github.com/nothings/stb/blob/master/stb_image_write.h */
-	input = state->Input;
-	cur   = input + DEFLATE_BLOCK_SIZE;
+	input    = state->Input;
+	base     = state->WindowBase;
+	cur      = input + DEFLATE_BLOCK_SIZE;
+	blockBeg = cur;
 
 	/* Compress current block of data */
 	/* Use > instead of >=, because also try match at one byte after current */
 	while (len > MIN_MATCH_LEN) {
-		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
-
+		maxLen  = min(len, MAX_MATCH_LEN);
 		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
 		bestPos = 0;
 
 		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
-		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
-			pos = state->Prev[pos];
+		/* Only explore up to maxChain previous matches, to avoid slow performance */
+		pos = state->Head[Deflate_Hash(cur)];
+		for (depth = 0; pos > base && depth < level->maxChain; depth++) {
+			matchLen = Deflate_MatchLen(&input[pos - base], cur, maxLen);
+			if (matchLen > bestLen) { 
+				bestLen = matchLen; bestPos = pos; 
+				if (matchLen >= level->niceLen) break;
+			}
+			pos = state->Prev[pos & DEFLATE_WINDOW_MASK];
 		}
 
 		/* Insert this entry into the hash chain */
-		pos = (int)(cur - input);
-		oldHead = state->Head[hash];
-		state->Head[hash] = pos;
-		state->Prev[pos]  = oldHead;
+		Deflate_Insert(state, cur);
+		pos = base + (cc_uint32)(cur - input);
 
 		/* Lazy evaluation: Find longest match starting at next byte */
 		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
-			nextHash = Deflate_Hash(cur + 1);
-			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
+		if (bestPos && level->lazy && bestLen < level->niceLen) {
+			nextPos = state->Head[Deflate_Hash(cur + 1)];
+			maxLen  = min(len - 1, MAX_MATCH_LEN);
 
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
+			for (depth = 0; nextPos > base && depth < level->maxChain; depth++) {
+				matchLen = Deflate_MatchLen(&input[nextPos - base], cur + 1, maxLen);
 				if (matchLen > bestLen) { bestPos = 0; break; }
-				nextPos = state->Prev[nextPos];
+				nextPos = state->Prev[nextPos & DEFLATE_WINDOW_MASK];
 			}
 		}
 
 		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
+			Deflate_LenDist(state, bestLen, (int)(pos - bestPos));
+
+			/* Positions within short matches are also added to hash chains, so later data can match them */
+			if (bestLen <= level->insertLen) {
+				for (i = 1; i < bestLen && len - i > MIN_MATCH_LEN; i++) { Deflate_Insert(state, cur + i); }
+			}
 			len -= bestLen; cur += bestLen;
 		} else {
 			Deflate_Lit(state, *cur);
 			len--; cur++;
 		}
 
-		/* leave room for a few bytes and literals at end */
-		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
+		if (state->NumSymbols < DEFLATE_MAX_SYMBOLS) continue;
+		if ((res = Deflate_WriteBlock(state, blockBeg, (int)(cur - blockBeg), false))) return res;
+		blockBeg = cur;
 	}
 
 	/* literals for last few bytes */
 	while (len > 0) {
+		/* Current block can still fill up while adding these */
+		if (state->NumSymbols == DEFLATE_MAX_SYMBOLS) {
+			if ((res = Deflate_WriteBlock(state, blockBeg, (int)(cur - blockBeg), false))) return res;
+			blockBeg = cur;
+		}
 		Deflate_Lit(state, *cur);
 		len--; cur++;
 	}
 
-	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-	state->NextOut  = state->Output;
-	state->AvailOut = DEFLATE_OUT_SIZE;
-
+	if ((res = Deflate_WriteBlock(state, blockBeg, (int)(cur - blockBeg), final))) return res;
 	Deflate_MoveBlock(state);
-	return res;
+	return 0;
 }
 
 /* Adds data to buffered output data, flushing if needed */
@@ -958,7 +1424,7 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 		data += len;
 
 		if (state->InputPosition == DEFLATE_BUFFER_SIZE) {
-			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE);
+			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE, false);
 			if (res) return res;
 		}
 	}
@@ -971,13 +1437,9 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	cc_result res;
 
 	state = (struct DeflateState*)stream->Meta.Inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE, true);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
-
 	/* In case last byte still has a few extra bits */
 	if (state->NumBits) {
 		while (state->NumBits < 8) { Deflate_PushBits(state, 0, 1); }
@@ -987,26 +1449,6 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
-
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.EndCodewords[i]) continue;
-		count = table.EndCodewords[i] - table.FirstCodewords[i];
-
-		for (j = 0; j < count; j++) {
-			offset   = table.Values[table.FirstOffsets[i] + j];
-			codeword = table.FirstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
-	}
-}
-
 void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
 	Stream_Init(stream);
 	stream->Meta.Inflate = state;
@@ -1015,17 +1457,27 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 
 	/* First half of buffer is "previous block" */
 	state->InputPosition = DEFLATE_BLOCK_SIZE;
+	state->WindowBase    = 0;
 	state->Bits    = 0;
 	state->NumBits = 0;
 
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
-	state->WroteHeader = false;
+	state->Level    = DEFLATE_LEVEL_DEFAULT;
+	state->NumSymbols = 0;
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+	Mem_Set(state->LitsFreqs,  0, sizeof(state->LitsFreqs));
+	Mem_Set(state->DistsFreqs, 0, sizeof(state->DistsFreqs));
+
+	Deflate_MakeCodes(fixed_lits,  INFLATE_MAX_LITS,  state->FixedLitsCodes);
+	Deflate_MakeCodes(fixed_dists, INFLATE_MAX_DISTS, state->FixedDistsCodes);
+}
+
+void Deflate_SetLevel(struct DeflateState* state, int level) {
+	state->Level = max(0, min(level, DEFLATE_LEVEL_BEST));
 }
 
 
@@ -1045,15 +1497,8 @@ static cc_result GZip_StreamClose(struct Stream* stream) {
 
 static cc_result GZip_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct GZipState* state = (struct GZipState*)stream->Meta.Inflate;
-	cc_uint32 i, crc32 = state->Crc32;
 	state->Size += count;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
-	}
-
-	state->Crc32 = crc32;
+	state->Crc32 = Utils_CRC32Update(state->Crc32, data, count);
 	return Deflate_StreamWrite(stream, data, count, modified);
 }
 
@@ -1077,84 +1522,521 @@ void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stre
 
 
 /*########################################################################################################################*
-*-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
+*-------------------------------------------------------Worker pool-------------------------------------------------------*
 *#########################################################################################################################*/
-static cc_result ZLib_StreamClose(struct Stream* stream) {
-	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
-	cc_uint8 data[4];
-	cc_result res;
+/* Worker threads shared by all the parallel compression and decompression below, so that any number */
+/*  of them can be in progress at once. The threads are started when the pool is first acquired, */
+/*  and stopped again once everything that acquired the pool has released it. */
+#define WORKERS_MAX 16
+enum WorkerTaskStatus { WORKER_TASK_FREE, WORKER_TASK_QUEUED, WORKER_TASK_BUSY, WORKER_TASK_DONE };
+
+struct WorkerTask;
+/* Runs the task on a worker thread. deflate is that worker's DeflateState (see Workers_GetDeflate) */
+typedef void (*WorkerTask_Run)(struct WorkerTask* task, struct DeflateState** deflate);
+
+/* A unit of work to be run on one of the worker threads */
+struct WorkerTask {
+	WorkerTask_Run Run;
+	void* doneWaitable; /* Signalled after the task has been run */
+	struct WorkerTask* next;
+	int status; /* See WorkerTaskStatus */
+};
 
-	if ((res = Deflate_StreamClose(stream))) return res;	
-	Stream_SetU32_BE(&data[0], state->Adler32);
-	return Stream_Write(state->Base.Dest, data, sizeof(data));
+static void* workers_lifeMutex; /* Held while the worker threads are being started or stopped */
+static void* workers_mutex;     /* Protects the queue and the status of all tasks */
+static int workers_refs, workers_count, workers_nextID;
+static int workers_max; /* See Deflate_SetMaxWorkers */
+static cc_bool workers_stopping;
+static struct WorkerTask* workers_head;
+static struct WorkerTask* workers_tail;
+
+static void* workers_threads[WORKERS_MAX];
+static void* workers_waitables[WORKERS_MAX];
+static struct DeflateState* workers_deflate[WORKERS_MAX];
+
+/* Returns the worker's DeflateState, allocating it if this is the first task to need one */
+/* NOTE: Returns NULL when out of memory */
+static struct DeflateState* Workers_GetDeflate(struct DeflateState** deflate) {
+	if (!*deflate) *deflate = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	return *deflate;
 }
 
-static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
-	cc_uint32 i, adler32 = state->Adler32;
-	cc_uint32 s1 = adler32 & 0xFFFF, s2 = (adler32 >> 16) & 0xFFFF;
+static void Workers_Main(void) {
+	struct WorkerTask* task;
+	cc_bool stopping;
+	int id;
 
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		#define ADLER32_BASE 65521
-		s1 = (s1 + data[i]) % ADLER32_BASE;
-		s2 = (s2 + s1)      % ADLER32_BASE;
+	Mutex_Lock(workers_mutex);
+	{
+		id = workers_nextID++;
 	}
+	Mutex_Unlock(workers_mutex);
 
-	state->Adler32 = (s2 << 16) | s1;
-	return Deflate_StreamWrite(stream, data, count, modified);
-}
+	for (;;) {
+		Mutex_Lock(workers_mutex);
+		{
+			task = workers_head;
+			if (task) {
+				workers_head = task->next;
+				if (!workers_head) workers_tail = NULL;
+				task->status = WORKER_TASK_BUSY;
+			}
+			stopping = workers_stopping;
+		}
+		Mutex_Unlock(workers_mutex);
 
-static cc_result ZLib_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	static cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
-	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
-	cc_result res;
+		if (!task) {
+			if (stopping) return;
+			Waitable_Wait(workers_waitables[id]);
+			continue;
+		}
+		task->Run(task, &workers_deflate[id]);
 
-	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
-	stream->Write = ZLib_StreamWrite;
-	return ZLib_StreamWrite(stream, data, count, modified);
+		/* Signalled while still locked, as the task (and its waitable) may be freed once it is done */
+		Mutex_Lock(workers_mutex);
+		{
+			task->status = WORKER_TASK_DONE;
+			Waitable_Signal(task->doneWaitable);
+		}
+		Mutex_Unlock(workers_mutex);
+	}
 }
 
-void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
-	Deflate_MakeStream(stream, &state->Base, underlying);
-	state->Adler32 = 1;
-	stream->Write = ZLib_StreamWriteFirst;
-	stream->Close = ZLib_StreamClose;
+static void Workers_WakeAll(void) {
+	int i;
+	for (i = 0; i < workers_count; i++) { Waitable_Signal(workers_waitables[i]); }
 }
 
+/* Starts the worker threads if they aren't already running, returning the number of workers */
+/* NOTE: The pool is lazily created, so must not be first used from multiple threads at once */
+static int Workers_Acquire(void) {
+	int i, count;
+	if (!workers_lifeMutex) {
+		workers_lifeMutex = Mutex_Create();
+		workers_mutex     = Mutex_Create();
+	}
 
-/*########################################################################################################################*
-*--------------------------------------------------------ZipEntry---------------------------------------------------------*
-*#########################################################################################################################*/
-#define ZIP_MAXNAMELEN 512
-static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry* entry) {
-	struct Stream* stream = state->input;
-	cc_uint8 header[26];
-	cc_uint32 compressedSize, uncompressedSize;
-	int method, pathLen, extraLen;
-
-	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
-	struct Stream portion, compStream;
-	struct InflateState inflate;
-	cc_result res;
-	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	Mutex_Lock(workers_lifeMutex);
+	if (!workers_refs++) {
+		/* Detected up front, rather than by all the workers at once */
+		Utils_HasHardwareCRC32();
+		workers_stopping = false;
+		workers_nextID   = 0;
+		workers_count    = min(Thread_ProcessorCount(), WORKERS_MAX);
+		if (workers_max) workers_count = min(workers_count, workers_max);
+
+		for (i = 0; i < workers_count; i++) { workers_waitables[i] = Waitable_Create(); }
+		for (i = 0; i < workers_count; i++) { workers_threads[i]   = Thread_Start(Workers_Main); }
+	}
+	count = workers_count;
+	Mutex_Unlock(workers_lifeMutex);
+	return count;
+}
 
-	method           = Stream_GetU16_LE(&header[4]);
-	compressedSize   = Stream_GetU32_LE(&header[14]);
-	uncompressedSize = Stream_GetU32_LE(&header[18]);
+/* Stops the worker threads, if nothing else is still using them */
+/* NOTE: Every task queued by the caller must have been waited on beforehand */
+static void Workers_Release(void) {
+	int i;
+	Mutex_Lock(workers_lifeMutex);
+	if (!--workers_refs) {
+		Mutex_Lock(workers_mutex);
+		{
+			workers_stopping = true;
+		}
+		Mutex_Unlock(workers_mutex);
+		Workers_WakeAll();
 
-	/* Some .zip files don't set these in local file header */
-	if (!compressedSize)   compressedSize   = entry->CompressedSize;
-	if (!uncompressedSize) uncompressedSize = entry->UncompressedSize;
+		/* Worker IDs don't match thread order, so every worker must have stopped before freeing */
+		for (i = 0; i < workers_count; i++) { Thread_Join(workers_threads[i]); }
 
-	pathLen  = Stream_GetU16_LE(&header[22]);
-	extraLen = Stream_GetU16_LE(&header[24]);
-	if (pathLen > ZIP_MAXNAMELEN) return ZIP_ERR_FILENAME_LEN;
+		for (i = 0; i < workers_count; i++) {
+			Waitable_Free(workers_waitables[i]);
+			Mem_Free(workers_deflate[i]);
+			workers_deflate[i] = NULL;
+		}
+		workers_count = 0;
+	}
+	Mutex_Unlock(workers_lifeMutex);
+}
 
-	/* NOTE: ZIP spec says path uses code page 437 for encoding */
-	path = String_Init(pathBuffer, pathLen, pathLen);	
-	if ((res = Stream_Read(stream, (cc_uint8*)pathBuffer, pathLen))) return res;
-	state->_curEntry = entry;
+/* Queues the task to be run by the next available worker */
+static void Workers_Queue(struct WorkerTask* task) {
+	Mutex_Lock(workers_mutex);
+	{
+		task->status = WORKER_TASK_QUEUED;
+		task->next   = NULL;
+
+		if (workers_tail) workers_tail->next = task;
+		else workers_head = task;
+		workers_tail = task;
+	}
+	Mutex_Unlock(workers_mutex);
+	Workers_WakeAll();
+}
+
+/* Waits until the task has been run, if it was queued */
+static void Workers_Wait(struct WorkerTask* task) {
+	int status;
+
+	for (;;) {
+		Mutex_Lock(workers_mutex);
+		{
+			status = task->status;
+		}
+		Mutex_Unlock(workers_mutex);
+
+		if (status == WORKER_TASK_FREE || status == WORKER_TASK_DONE) return;
+		Waitable_Wait(task->doneWaitable);
+	}
+}
+
+void Deflate_SetMaxWorkers(int count) { workers_max = count; }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Parallel GZip (compress)------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_WEB
+#define PGZIP_DICT_SIZE DEFLATE_BLOCK_SIZE
+#define PGZIP_OUTPUT_SIZE (DEFLATE_SEGMENT_SIZE + 4096)
+
+struct PGZipSegment {
+	struct WorkerTask task;
+	cc_uint8* data;   /* Dictionary (tail of previous segment), followed by this segment's input */
+	cc_uint8* output; /* Compressed data, ending with a sync flush (or the final block) */
+	int dictLen, len, level;
+	cc_uint32 outputLen, crc32;
+	cc_bool final;
+	cc_result res;
+};
+
+struct PGZipState {
+	struct PGZipSegment* segments;
+	int numSegments;
+	int cur;     /* Segment being filled by the stream */
+	int oldest;  /* Oldest segment that has not been written to the underlying stream yet */
+	int pending; /* Number of segments queued, but not written to the underlying stream yet */
+	cc_bool wroteHeader;
+	cc_uint32 crc32, size;
+	cc_result res; /* First error that occurred, after which nothing more is written */
+	struct Stream* dest;
+	void* doneWaitable;
+};
+
+static cc_result PGZip_WriteOutput(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct PGZipSegment* seg = (struct PGZipSegment*)s->Meta.Inflate;
+	*modified = 0;
+	if (seg->outputLen + count > PGZIP_OUTPUT_SIZE) return ERR_END_OF_STREAM;
+
+	Mem_Copy(seg->output + seg->outputLen, data, count);
+	seg->outputLen += count;
+	*modified       = count;
+	return 0;
+}
+
+/* Compresses the remaining input, then byte aligns output with an empty stored block. */
+/* This way the next segment's output can be appended directly after. */
+static cc_result PGZip_SyncFlush(struct DeflateState* state) {
+	cc_result res = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE, false);
+	if (res) return res;
+
+	if (state->AvailOut < DEFLATE_OUT_SLACK && (res = Deflate_FlushOutput(state))) return res;
+	if ((res = Deflate_WriteStored(state, NULL, 0, false))) return res;
+	return Deflate_FlushOutput(state);
+}
+
+/* Compresses a segment independently, primed with the tail of the previous segment */
+static void PGZip_Compress(struct WorkerTask* task, struct DeflateState** deflate) {
+	struct PGZipSegment* seg   = (struct PGZipSegment*)task;
+	struct DeflateState* state = Workers_GetDeflate(deflate);
+	struct Stream output, stream;
+	cc_uint8* input = seg->data + PGZIP_DICT_SIZE;
+	int i;
+	cc_result res;
+
+	seg->crc32 = Utils_CRC32(input, seg->len);
+	if (!state) { seg->res = ERR_OUT_OF_MEMORY; return; }
+
+	Stream_Init(&output);
+	output.Meta.Inflate = seg;
+	output.Write        = PGZip_WriteOutput;
+	seg->outputLen      = 0;
+
+	Deflate_MakeStream(&stream, state, &output);
+	Deflate_SetLevel(state, seg->level);
+
+	/* Dictionary is the "previous block", so the start of this segment can reference it */
+	Mem_Copy(state->Input, seg->data, PGZIP_DICT_SIZE);
+	for (i = PGZIP_DICT_SIZE - seg->dictLen; i < PGZIP_DICT_SIZE - (MIN_MATCH_LEN - 1); i++) {
+		Deflate_Insert(state, &state->Input[i]);
+	}
+
+	res = Stream_Write(&stream, input, seg->len);
+	if (!res) res = seg->final ? stream.Close(&stream) : PGZip_SyncFlush(state);
+	seg->res = res;
+}
+
+static void PGZip_Queue(struct PGZipState* pg, struct PGZipSegment* seg, cc_bool final) {
+	seg->final = final;
+	pg->pending++;
+	Workers_Queue(&seg->task);
+}
+
+/* Waits for the oldest queued segment to be compressed, then writes it to the underlying stream */
+static cc_result PGZip_WriteOldest(struct PGZipState* pg) {
+	static cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	struct PGZipSegment* seg = &pg->segments[pg->oldest];
+	cc_result res;
+
+	Workers_Wait(&seg->task);
+	seg->task.status = WORKER_TASK_FREE;
+	pg->oldest = (pg->oldest + 1) % pg->numSegments;
+	pg->pending--;
+	if (seg->res) return seg->res;
+
+	if (!pg->wroteHeader) {
+		if ((res = Stream_Write(pg->dest, header, sizeof(header)))) return res;
+		pg->wroteHeader = true;
+	}
+
+	pg->crc32 = Utils_CRC32Combine(pg->crc32, seg->crc32, seg->len);
+	pg->size += seg->len;
+	return Stream_Write(pg->dest, seg->output, seg->outputLen);
+}
+
+/* Queues the current segment, then starts filling the next one */
+static cc_result PGZip_NextSegment(struct PGZipState* pg) {
+	struct PGZipSegment* prev = &pg->segments[pg->cur];
+	struct PGZipSegment* seg;
+	cc_result res;
+	PGZip_Queue(pg, prev, false);
+
+	pg->cur = (pg->cur + 1) % pg->numSegments;
+	seg     = &pg->segments[pg->cur];
+	if (pg->pending == pg->numSegments && (res = PGZip_WriteOldest(pg))) return res;
+
+	/* previous segment is only read from (by both this thread and a worker) while it is queued */
+	seg->dictLen = min(prev->len, PGZIP_DICT_SIZE);
+	seg->len     = 0;
+	Mem_Copy(seg->data + PGZIP_DICT_SIZE - seg->dictLen, prev->data + PGZIP_DICT_SIZE + prev->len - seg->dictLen, seg->dictLen);
+	return 0;
+}
+
+static cc_result PGZip_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 total, cc_uint32* modified) {
+	struct PGZipState* pg = (struct PGZipState*)stream->Meta.Inflate;
+	struct PGZipSegment* seg;
+	cc_uint32 len;
+	cc_result res;
+	*modified = 0;
+	if (pg->res) return pg->res;
+
+	while (total > 0) {
+		seg = &pg->segments[pg->cur];
+		len = min(total, (cc_uint32)(DEFLATE_SEGMENT_SIZE - seg->len));
+
+		Mem_Copy(seg->data + PGZIP_DICT_SIZE + seg->len, data, len);
+		seg->len  += len;
+		*modified += len;
+		data += len; total -= len;
+
+		if (seg->len < DEFLATE_SEGMENT_SIZE) continue;
+		if ((res = PGZip_NextSegment(pg))) { pg->res = res; return res; }
+	}
+	return 0;
+}
+
+/* Waits for any segments still being compressed, then frees all buffers */
+static void PGZip_Free(struct PGZipState* pg) {
+	int i;
+	if (pg->segments) {
+		for (i = 0; i < pg->numSegments; i++) { Workers_Wait(&pg->segments[i].task); }
+
+		for (i = 0; i < pg->numSegments; i++) {
+			Mem_Free(pg->segments[i].data);
+			Mem_Free(pg->segments[i].output);
+		}
+		Mem_Free(pg->segments);
+	}
+
+	if (pg->doneWaitable) Waitable_Free(pg->doneWaitable);
+	Mem_Free(pg);
+	Workers_Release();
+}
+
+static cc_result PGZip_StreamClose(struct Stream* stream) {
+	struct PGZipState* pg = (struct PGZipState*)stream->Meta.Inflate;
+	cc_uint8 data[8];
+	cc_result res;
+	if (!pg) return 0;
+	res = pg->res;
+
+	/* Empty stream still needs a final block */
+	if (!res) PGZip_Queue(pg, &pg->segments[pg->cur], true);
+	while (!res && pg->pending) { res = PGZip_WriteOldest(pg); }
+
+	Stream_SetU32_LE(&data[0], pg->crc32);
+	Stream_SetU32_LE(&data[4], pg->size);
+	if (!res) res = Stream_Write(pg->dest, data, sizeof(data));
+
+	/* Always wait for any still busy segments to finish */
+	PGZip_Free(pg);
+	stream->Meta.Inflate = NULL;
+	return res;
+}
+
+static cc_result PGZip_Alloc(struct PGZipState* pg, int workers, int level) {
+	struct PGZipSegment* seg;
+	int i;
+
+	pg->doneWaitable = Waitable_Create();
+	pg->segments     = (struct PGZipSegment*)Mem_TryAllocCleared(workers * 2, sizeof(struct PGZipSegment));
+	if (!pg->segments) return ERR_OUT_OF_MEMORY;
+	pg->numSegments = workers * 2;
+
+	for (i = 0; i < pg->numSegments; i++) {
+		seg = &pg->segments[i];
+		seg->task.Run          = PGZip_Compress;
+		seg->task.doneWaitable = pg->doneWaitable;
+		seg->level = level;
+
+		seg->data   = (cc_uint8*)Mem_TryAlloc(PGZIP_DICT_SIZE + DEFLATE_SEGMENT_SIZE, 1);
+		seg->output = (cc_uint8*)Mem_TryAlloc(PGZIP_OUTPUT_SIZE, 1);
+		if (!seg->data || !seg->output) return ERR_OUT_OF_MEMORY;
+	}
+	return 0;
+}
+
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	struct PGZipState* pg;
+	int workers;
+	cc_result res;
+
+	pg = (struct PGZipState*)Mem_TryAllocCleared(1, sizeof(struct PGZipState));
+	if (!pg) return ERR_OUT_OF_MEMORY;
+	workers = Workers_Acquire();
+
+	level = max(0, min(level, DEFLATE_LEVEL_BEST));
+	if ((res = PGZip_Alloc(pg, workers, level))) { PGZip_Free(pg); return res; }
+	pg->dest = underlying;
+
+	Stream_Init(stream);
+	stream->Meta.Inflate = pg;
+	stream->Write = PGZip_StreamWrite;
+	stream->Close = PGZip_StreamClose;
+	return 0;
+}
+#else
+/* Thread_Start runs the thread function synchronously */
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	return ERR_NOT_SUPPORTED;
+}
+#endif
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result ZLib_StreamClose(struct Stream* stream) {
+	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
+	cc_uint8 data[4];
+	cc_result res;
+
+	if ((res = Deflate_StreamClose(stream))) return res;	
+	Stream_SetU32_BE(&data[0], state->Adler32);
+	return Stream_Write(state->Base.Dest, data, sizeof(data));
+}
+
+static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
+	cc_uint32 i, adler32 = state->Adler32;
+	cc_uint32 s1 = adler32 & 0xFFFF, s2 = (adler32 >> 16) & 0xFFFF;
+
+	/* TODO: Optimise this calculation */
+	for (i = 0; i < count; i++) {
+		#define ADLER32_BASE 65521
+		s1 = (s1 + data[i]) % ADLER32_BASE;
+		s2 = (s2 + s1)      % ADLER32_BASE;
+	}
+
+	state->Adler32 = (s2 << 16) | s1;
+	return Deflate_StreamWrite(stream, data, count, modified);
+}
+
+static cc_result ZLib_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	static cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
+	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
+	cc_result res;
+
+	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
+	stream->Write = ZLib_StreamWrite;
+	return ZLib_StreamWrite(stream, data, count, modified);
+}
+
+void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
+	Deflate_MakeStream(stream, &state->Base, underlying);
+	state->Adler32 = 1;
+	stream->Write = ZLib_StreamWriteFirst;
+	stream->Close = ZLib_StreamClose;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------ZipEntry---------------------------------------------------------*
+*#########################################################################################################################*/
+#define ZIP_MAXNAMELEN 512
+enum ZipSig {
+	ZIP_SIG_ENDOFCENTRALDIR = 0x06054b50,
+	ZIP_SIG_CENTRALDIR      = 0x02014b50,
+	ZIP_SIG_LOCALFILEHEADER = 0x04034b50,
+	ZIP_SIG_DATADESCRIPTOR  = 0x08074b50
+};
+
+/* Seeks to and reads the local file header of an entry, up to and including its path */
+static cc_result Zip_ReadLocalHeader(struct Stream* stream, struct ZipEntry* entry, cc_string* path, int* method,
+									cc_uint32* compressedSize, cc_uint32* uncompressedSize, int* extraLen) {
+	cc_uint8 header[26];
+	cc_uint32 sig = 0;
+	int pathLen;
+	cc_result res;
+
+	res = stream->Seek(stream, entry->LocalHeaderOffset);
+	if (res) return ZIP_ERR_SEEK_LOCAL_DIR;
+
+	if ((res = Stream_ReadU32_LE(stream, &sig))) return res;
+	if (sig != ZIP_SIG_LOCALFILEHEADER) return ZIP_ERR_INVALID_LOCAL_DIR;
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+
+	*method           = Stream_GetU16_LE(&header[4]);
+	*compressedSize   = Stream_GetU32_LE(&header[14]);
+	*uncompressedSize = Stream_GetU32_LE(&header[18]);
+
+	/* Some .zip files don't set these in local file header */
+	if (!(*compressedSize))   *compressedSize   = entry->CompressedSize;
+	if (!(*uncompressedSize)) *uncompressedSize = entry->UncompressedSize;
+
+	pathLen   = Stream_GetU16_LE(&header[22]);
+	*extraLen = Stream_GetU16_LE(&header[24]);
+	if (pathLen > ZIP_MAXNAMELEN) return ZIP_ERR_FILENAME_LEN;
+
+	/* NOTE: ZIP spec says path uses code page 437 for encoding */
+	path->length = pathLen;
+	return Stream_Read(stream, (cc_uint8*)path->buffer, pathLen);
+}
+
+static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry* entry) {
+	struct Stream* stream = state->input;
+	cc_uint32 compressedSize, uncompressedSize;
+	int method, extraLen;
+
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+	struct Stream portion, compStream;
+	struct InflateState inflate;
+	cc_result res;
+
+	path = String_Init(pathBuffer, 0, ZIP_MAXNAMELEN);
+	res  = Zip_ReadLocalHeader(stream, entry, &path, &method, &compressedSize, &uncompressedSize, &extraLen);
+	if (res) return res;
+	state->_curEntry = entry;
 
 	if (!state->SelectEntry(&path)) return 0;
 	/* local file may have extra data before actual data (e.g. ZIP64) */
@@ -1174,27 +2056,35 @@ static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry
 	return 0;
 }
 
-static cc_result Zip_ReadCentralDirectory(struct ZipState* state) {
-	struct Stream* stream = state->input;
-	struct ZipEntry* entry;
-	cc_uint8 header[42];
-
-	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+/* Reads a central directory entry header and its path, then skips over the rest of the entry */
+/* NOTE: path must have been initialised with a capacity of at most ZIP_MAXNAMELEN */
+static cc_result Zip_ReadCentralHeader(struct Stream* stream, cc_uint8* header, cc_string* path) {
 	int pathLen, extraLen, commentLen;
 	cc_result res;
-	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if ((res = Stream_Read(stream, header, 42))) return res;
 
 	pathLen = Stream_GetU16_LE(&header[24]);
-	if (pathLen > ZIP_MAXNAMELEN) return ZIP_ERR_FILENAME_LEN;
+	if (pathLen > path->capacity) return ZIP_ERR_FILENAME_LEN;
 
 	/* NOTE: ZIP spec says path uses code page 437 for encoding */
-	path = String_Init(pathBuffer, pathLen, pathLen);
-	if ((res = Stream_Read(stream, (cc_uint8*)pathBuffer, pathLen))) return res;
+	path->length = pathLen;
+	if ((res = Stream_Read(stream, (cc_uint8*)path->buffer, pathLen))) return res;
 
 	/* skip data following central directory entry header */
 	extraLen   = Stream_GetU16_LE(&header[26]);
 	commentLen = Stream_GetU16_LE(&header[28]);
-	if ((res = stream->Skip(stream, extraLen + commentLen))) return res;
+	return stream->Skip(stream, extraLen + commentLen);
+}
+
+static cc_result Zip_ReadCentralDirectory(struct ZipState* state) {
+	struct ZipEntry* entry;
+	cc_uint8 header[42];
+
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+	cc_result res;
+
+	path = String_Init(pathBuffer, 0, ZIP_MAXNAMELEN);
+	if ((res = Zip_ReadCentralHeader(state->input, header, &path))) return res;
 
 	if (!state->SelectEntry(&path)) return 0;
 	if (state->_usedEntries >= ZIP_MAX_ENTRIES) return ZIP_ERR_TOO_MANY_ENTRIES;
@@ -1207,24 +2097,36 @@ static cc_result Zip_ReadCentralDirectory(struct ZipState* state) {
 	return 0;
 }
 
-static cc_result Zip_ReadEndOfCentralDirectory(struct ZipState* state) {
-	struct Stream* stream = state->input;
+/* Finds and reads the end of central directory record, which is at the end of the archive */
+static cc_result Zip_ReadEndOfCentralDirectory(struct Stream* stream, int* totalEntries, 
+												cc_uint32* centralDirBeg, cc_uint32* centralDirSize) {
+	cc_uint32 stream_len;
+	cc_uint32 sig = 0;
 	cc_uint8 header[18];
+	int i, count;
 
 	cc_result res;
+	if ((res = stream->Length(stream, &stream_len))) return res;
+
+	/* At -22 for nearly all zips, but try a bit further back in case of comment */
+	count = min(257, stream_len);
+	for (i = 22; i < count; i++) {
+		res = stream->Seek(stream, stream_len - i);
+		if (res) return ZIP_ERR_SEEK_END_OF_CENTRAL_DIR;
+
+		if ((res = Stream_ReadU32_LE(stream, &sig))) return res;
+		if (sig == ZIP_SIG_ENDOFCENTRALDIR) break;
+	}
+
+	if (sig != ZIP_SIG_ENDOFCENTRALDIR) return ZIP_ERR_NO_END_OF_CENTRAL_DIR;
 	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
 
-	state->_totalEntries  = Stream_GetU16_LE(&header[6]);
-	state->_centralDirBeg = Stream_GetU32_LE(&header[12]);
+	*totalEntries   = Stream_GetU16_LE(&header[6]);
+	*centralDirSize = Stream_GetU32_LE(&header[8]);
+	*centralDirBeg  = Stream_GetU32_LE(&header[12]);
 	return 0;
 }
 
-enum ZipSig {
-	ZIP_SIG_ENDOFCENTRALDIR = 0x06054b50,
-	ZIP_SIG_CENTRALDIR      = 0x02014b50,
-	ZIP_SIG_LOCALFILEHEADER = 0x04034b50
-};
-
 static cc_result Zip_DefaultProcessor(const cc_string* path, struct Stream* data, struct ZipState* s) { return 0; }
 static cc_bool Zip_DefaultSelector(const cc_string* path) { return true; }
 void Zip_Init(struct ZipState* state, struct Stream* input) {
@@ -1234,27 +2136,14 @@ void Zip_Init(struct ZipState* state, struct Stream* input) {
 	state->SelectEntry  = Zip_DefaultSelector;
 }
 
-cc_result Zip_Extract(struct ZipState* state) {
+/* Finds the central directory, then reads all of its entries */
+static cc_result Zip_ReadDirectory(struct ZipState* state) {
 	struct Stream* stream = state->input;
-	cc_uint32 stream_len;
-	cc_uint32 sig = 0;
-	int i, count;
-
-	cc_result res;
-	if ((res = stream->Length(stream, &stream_len))) return res;
-
-	/* At -22 for nearly all zips, but try a bit further back in case of comment */
-	count = min(257, stream_len);
-	for (i = 22; i < count; i++) {
-		res = stream->Seek(stream, stream_len - i);
-		if (res) return ZIP_ERR_SEEK_END_OF_CENTRAL_DIR;
-
-		if ((res = Stream_ReadU32_LE(stream, &sig))) return res;
-		if (sig == ZIP_SIG_ENDOFCENTRALDIR) break;
-	}
+	cc_uint32 sig, centralDirSize;
+	int i;
 
-	if (sig != ZIP_SIG_ENDOFCENTRALDIR) return ZIP_ERR_NO_END_OF_CENTRAL_DIR;
-	res = Zip_ReadEndOfCentralDirectory(state);
+	cc_result res = Zip_ReadEndOfCentralDirectory(stream, &state->_totalEntries,
+												&state->_centralDirBeg, &centralDirSize);
 	if (res) return res;
 
 	res = stream->Seek(stream, state->_centralDirBeg);
@@ -1274,18 +2163,844 @@ cc_result Zip_Extract(struct ZipState* state) {
 			return ZIP_ERR_INVALID_CENTRAL_DIR;
 		}
 	}
+	return 0;
+}
 
-	/* Now read the local file header entries */
-	for (i = 0; i < state->_usedEntries; i++) {
-		struct ZipEntry* entry = &state->entries[i];
-		res = stream->Seek(stream, entry->LocalHeaderOffset);
-		if (res) return ZIP_ERR_SEEK_LOCAL_DIR;
-
-		if ((res = Stream_ReadU32_LE(stream, &sig))) return res;
-		if (sig != ZIP_SIG_LOCALFILEHEADER) return ZIP_ERR_INVALID_LOCAL_DIR;
+/* Reads the local file header entries, processing each entry in turn */
+static cc_result Zip_ExtractEntries(struct ZipState* state) {
+	int i;
+	cc_result res;
 
-		res = Zip_ReadLocalFileHeader(state, entry);
+	for (i = 0; i < state->_usedEntries; i++) {
+		res = Zip_ReadLocalFileHeader(state, &state->entries[i]);
 		if (res) return res;
 	}
 	return 0;
 }
+
+cc_result Zip_Extract(struct ZipState* state) {
+	cc_result res = Zip_ReadDirectory(state);
+	if (res) return res;
+	return Zip_ExtractEntries(state);
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------ZipIndex---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Hashes the filename part of the path, ignoring case */
+static int ZipIndex_Hash(const cc_string* path) {
+	cc_string name = *path;
+	cc_uint32 hash = 0;
+	int i;
+	char c;
+	Utils_UNSAFE_GetFilename(&name);
+
+	for (i = 0; i < name.length; i++) {
+		c = name.buffer[i]; Char_MakeLower(c);
+		hash = hash * 31 + (cc_uint8)c;
+	}
+	return (int)(hash & (ZIPINDEX_BUCKETS - 1));
+}
+
+void ZipIndex_Free(struct ZipIndex* index) {
+	Mem_Free(index->entries);
+	Mem_Free(index->paths);
+	index->entries = NULL;
+	index->paths   = NULL;
+	index->count   = 0;
+}
+
+static cc_result ZipIndex_ReadEntries(struct ZipIndex* index, struct Stream* input, int total) {
+	struct ZipIndexEntry* e;
+	cc_uint32 sig, pathsLen = 0;
+	cc_uint8 header[42];
+	cc_string path;
+	int i, hash;
+	cc_result res;
+
+	for (i = 0; i < ZIPINDEX_BUCKETS; i++) { index->buckets[i] = -1; }
+
+	for (i = 0; i < total; i++) {
+		if ((res = Stream_ReadU32_LE(input, &sig))) return res;
+		if (sig == ZIP_SIG_ENDOFCENTRALDIR) break;
+		if (sig != ZIP_SIG_CENTRALDIR) return ZIP_ERR_INVALID_CENTRAL_DIR;
+
+		/* paths are always smaller than the central directory they are stored in */
+		path = String_Init(index->paths + pathsLen, 0, min(ZIP_MAXNAMELEN, index->centralDirSize - pathsLen));
+		if ((res = Zip_ReadCentralHeader(input, header, &path))) return res;
+
+		e = &index->entries[index->count];
+		e->method     = Stream_GetU16_LE(&header[6]);
+		e->pathOffset = pathsLen;
+		e->pathLength = path.length;
+		pathsLen     += path.length;
+
+		e->entry.CRC32             = Stream_GetU32_LE(&header[12]);
+		e->entry.CompressedSize    = Stream_GetU32_LE(&header[16]);
+		e->entry.UncompressedSize  = Stream_GetU32_LE(&header[20]);
+		e->entry.LocalHeaderOffset = Stream_GetU32_LE(&header[38]);
+
+		/* Later entries are found first, same as how they overwrite earlier ones with Zip_Extract */
+		hash    = ZipIndex_Hash(&path);
+		e->next = index->buckets[hash];
+		index->buckets[hash] = index->count++;
+	}
+	return 0;
+}
+
+cc_result ZipIndex_Load(struct ZipIndex* index, struct Stream* input) {
+	cc_uint32 length, centralDirBeg, centralDirSize;
+	int total;
+	cc_result res;
+
+	if ((res = input->Length(input, &length))) return res;
+	res = Zip_ReadEndOfCentralDirectory(input, &total, &centralDirBeg, &centralDirSize);
+	if (res) return res;
+
+	/* Archive almost certainly hasn't changed since the index was last loaded */
+	if (index->entries && index->length == length && index->total == total
+		&& index->centralDirBeg == centralDirBeg && index->centralDirSize == centralDirSize) return 0;
+
+	ZipIndex_Free(index);
+	index->length = length;
+	index->total  = total;
+	index->centralDirBeg  = centralDirBeg;
+	index->centralDirSize = centralDirSize;
+
+	if ((res = input->Seek(input, centralDirBeg))) return ZIP_ERR_SEEK_CENTRAL_DIR;
+	index->entries = (struct ZipIndexEntry*)Mem_TryAlloc(max(1, total), sizeof(struct ZipIndexEntry));
+	index->paths   = (char*)Mem_TryAlloc(max(1, centralDirSize), 1);
+	if (!index->entries || !index->paths) { ZipIndex_Free(index); return ERR_OUT_OF_MEMORY; }
+
+	res = ZipIndex_ReadEntries(index, input, total);
+	if (res) ZipIndex_Free(index);
+	return res;
+}
+
+cc_string ZipIndex_UNSAFE_GetPath(struct ZipIndex* index, struct ZipIndexEntry* e) {
+	return String_Init(index->paths + e->pathOffset, e->pathLength, e->pathLength);
+}
+
+struct ZipIndexEntry* ZipIndex_Find(struct ZipIndex* index, const cc_string* filename) {
+	struct ZipIndexEntry* e;
+	cc_string name;
+	int i;
+	if (!index->entries) return NULL;
+
+	for (i = index->buckets[ZipIndex_Hash(filename)]; i >= 0; i = e->next) {
+		e    = &index->entries[i];
+		name = ZipIndex_UNSAFE_GetPath(index, e);
+		Utils_UNSAFE_GetFilename(&name);
+		if (String_CaselessEquals(&name, filename)) return e;
+	}
+	return NULL;
+}
+
+cc_result ZipIndex_Open(struct ZipIndexEntry* e, struct Stream* input, struct Stream* stream,
+						struct Stream* portion, struct InflateState* inflate) {
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+	cc_uint32 compressedSize, uncompressedSize;
+	int method, extraLen;
+	cc_result res;
+
+	path = String_Init(pathBuffer, 0, ZIP_MAXNAMELEN);
+	res  = Zip_ReadLocalHeader(input, &e->entry, &path, &method, &compressedSize, &uncompressedSize, &extraLen);
+	if (res) return res;
+	/* local file may have extra data before actual data (e.g. ZIP64) */
+	if ((res = input->Skip(input, extraLen))) return res;
+
+	if (method == 0) {
+		Stream_ReadonlyPortion(stream, input, uncompressedSize);
+	} else if (method == 8) {
+		Stream_ReadonlyPortion(portion, input, compressedSize);
+		Inflate_MakeStream2(stream, inflate, portion);
+	} else {
+		return ERR_NOT_SUPPORTED;
+	}
+	return 0;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Parallel Zip (extract)--------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_WEB
+struct PZipEntry {
+	struct WorkerTask task;
+	struct ZipEntry* entry;
+	cc_uint8* raw;  /* Entry data as stored in the .zip archive */
+	cc_uint8* data; /* Decompressed entry data (same as raw for uncompressed entries) */
+	cc_uint32 rawLen, len;
+	int method;
+	cc_bool selected, decompressed;
+	struct Bitmap bmp;  /* Decoded image, if the entry data is a .png file */
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+};
+
+/* Decompresses the entry data, then decodes it too if it is a .png file */
+static void PZip_Decode(struct WorkerTask* task, struct DeflateState** deflate) {
+	struct PZipEntry* e = (struct PZipEntry*)task;
+	struct InflateState inflate;
+	struct Stream src, stream;
+
+	if (e->method == 8) {
+		/* Leave it to PZip_ProcessEntry to decompress as a stream instead */
+		if (!e->len || !(e->data = (cc_uint8*)Mem_TryAlloc(e->len, 1))) return;
+
+		Stream_ReadonlyMemory(&src, e->raw, e->rawLen);
+		Inflate_MakeStream2(&stream, &inflate, &src);
+		if (Stream_Read(&stream, e->data, e->len)) return;
+	} else {
+		e->data = e->raw;
+	}
+	e->decompressed = true;
+	if (!Png_Detect(e->data, e->len)) return;
+
+	/* If this fails, ProcessEntry will just decode the data again and report the error itself */
+	Stream_ReadonlyMemory(&src, e->data, e->len);
+	if (!Png_Decode(&e->bmp, &src)) return;
+	Mem_Free(e->bmp.scan0);
+	e->bmp.scan0 = NULL;
+}
+
+/* Reads the raw data of an entry into memory, then queues it to be decoded by a worker */
+static cc_result PZip_Queue(struct ZipState* state, struct PZipEntry* e, struct ZipEntry* entry) {
+	struct Stream* stream = state->input;
+	cc_uint32 compressedSize;
+	int extraLen;
+	cc_result res;
+
+	e->entry = entry;
+	e->path  = String_Init(e->pathBuffer, 0, ZIP_MAXNAMELEN);
+	res = Zip_ReadLocalHeader(stream, entry, &e->path, &e->method, &compressedSize, &e->len, &extraLen);
+	if (res) return res;
+
+	e->selected = state->SelectEntry(&e->path);
+	if (!e->selected || (e->method != 0 && e->method != 8)) return 0;
+
+	/* local file may have extra data before actual data (e.g. ZIP64) */
+	if ((res = stream->Skip(stream, extraLen))) return res;
+	e->rawLen = e->method == 0 ? e->len : compressedSize;
+
+	e->raw = (cc_uint8*)Mem_TryAlloc(e->rawLen, 1);
+	if (!e->raw && e->rawLen) return ERR_OUT_OF_MEMORY;
+	if ((res = Stream_Read(stream, e->raw, e->rawLen))) return res;
+
+	Workers_Queue(&e->task);
+	return 0;
+}
+
+/* Waits for the entry to be decoded, then passes it to ProcessEntry */
+static cc_result PZip_ProcessEntry(struct ZipState* state, struct PZipEntry* e) {
+	struct InflateState inflate;
+	struct Stream src, stream;
+	cc_result res;
+
+	Workers_Wait(&e->task);
+	state->_curEntry = e->entry;
+	if (!e->selected) return 0;
+
+	if (e->method != 0 && e->method != 8) {
+		Platform_Log1("Unsupported.zip entry compression method: %i", &e->method);
+		return 0;
+	} else if (!e->decompressed) {
+		Stream_ReadonlyMemory(&src, e->raw, e->rawLen);
+		Inflate_MakeStream2(&stream, &inflate, &src);
+		return state->ProcessEntry(&e->path, &stream, state);
+	} else if (!e->bmp.scan0) {
+		Stream_ReadonlyMemory(&stream, e->data, e->len);
+		return state->ProcessEntry(&e->path, &stream, state);
+	}
+
+	/* bitmap is now owned by the stream */
+	Png_MakeDecodedStream(&stream, &e->bmp, e->data, e->len);
+	e->bmp.scan0 = NULL;
+	res = state->ProcessEntry(&e->path, &stream, state);
+	stream.Close(&stream);
+	return res;
+}
+
+/* Waits for the entry to be decoded if it was queued, then frees its data */
+static void PZip_FreeEntry(struct PZipEntry* e) {
+	Workers_Wait(&e->task);
+	e->task.status = WORKER_TASK_FREE;
+
+	if (e->data != e->raw) Mem_Free(e->data);
+	Mem_Free(e->raw);
+	Mem_Free(e->bmp.scan0);
+
+	e->raw  = NULL; e->data = NULL;
+	e->bmp.scan0    = NULL;
+	e->decompressed = false;
+}
+
+cc_result Zip_ExtractParallel(struct ZipState* state) {
+	struct PZipEntry* entries;
+	void* doneWaitable;
+	int i, next, count;
+	cc_result res;
+
+	/* Not worth the overhead on single core systems */
+	if (Thread_ProcessorCount() <= 1) return Zip_Extract(state);
+	if ((res = Zip_ReadDirectory(state))) return res;
+
+	count   = Workers_Acquire() * 2;
+	entries = (struct PZipEntry*)Mem_TryAllocCleared(count, sizeof(struct PZipEntry));
+	if (!entries) { Workers_Release(); return Zip_ExtractEntries(state); }
+
+	doneWaitable = Waitable_Create();
+	for (i = 0; i < count; i++) {
+		entries[i].task.Run          = PZip_Decode;
+		entries[i].task.doneWaitable = doneWaitable;
+	}
+
+	/* Entries are read ahead and decoded by the workers, but still processed in order */
+	for (i = 0, next = 0, res = 0; !res && i < state->_usedEntries; i++) {
+		for (; !res && next < state->_usedEntries && next - i < count; next++) {
+			res = PZip_Queue(state, &entries[next % count], &state->entries[next]);
+		}
+		if (res) break;
+
+		res = PZip_ProcessEntry(state, &entries[i % count]);
+		PZip_FreeEntry(&entries[i % count]);
+	}
+
+	/* Always wait for any entries still being decoded */
+	for (i = 0; i < count; i++) { PZip_FreeEntry(&entries[i]); }
+	Workers_Release();
+	Waitable_Free(doneWaitable);
+	Mem_Free(entries);
+	return res;
+}
+#else
+/* Thread_Start runs the thread function synchronously */
+cc_result Zip_ExtractParallel(struct ZipState* state) { return Zip_Extract(state); }
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------ZipWriter--------------------------------------------------------*
+*#########################################################################################################################*/
+/* CRC32 and sizes of the entry are stored in a data descriptor after its data, instead of in its local header */
+#define ZIP_FLAG_DATADESCRIPTOR 0x08
+
+struct ZipWriterEntry {
+	struct ZipEntry entry;
+	int method, flags;
+	cc_uint32 pathOffset, pathLength;
+};
+
+/* An entry whose data has been added, but not written to the archive yet */
+struct ZipWriterJob {
+	struct WorkerTask task;
+	cc_uint8* data;   /* Uncompressed entry data */
+	cc_uint8* output; /* Compressed entry data */
+	cc_uint32 len, outputLen, outputCapacity, crc32;
+	int entry;        /* Index into the writer's entries */
+	int method, level;
+	cc_bool ownsData;
+};
+
+struct ZipWriterState {
+	/* Used for the entry being written through a stream, or compressing when there aren't any workers */
+	struct DeflateState deflate;
+	/* State for writing the data of the current entry through a stream */
+	struct Stream stream, compressor, output;
+	cc_uint32 crc32, len, dataBeg;
+	/* Data of the current entry when it is stored, since its local header must be written first */
+	cc_uint8* stored;
+	cc_uint32 storedCapacity;
+
+	struct ZipWriterJob* jobs;
+	int numJobs, numWorkers, level;
+	int cur;     /* Job the next added entry is stored in */
+	int oldest;  /* Oldest job that has not been written to the archive yet */
+	int pending; /* Number of jobs that have not been written to the archive yet */
+	void* doneWaitable;
+};
+
+/* Already compressed data barely gets any smaller, so isn't worth spending time compressing again */
+static int ZipWriter_ChooseMethod(struct ZipWriter* w, const cc_string* path, int method) {
+	static const cc_string png = String_FromConst(".png"), ogg = String_FromConst(".ogg");
+	static const cc_string zip = String_FromConst(".zip"), jpg = String_FromConst(".jpg");
+	if (w->_state->level == DEFLATE_LEVEL_NONE) return ZIP_METHOD_STORE;
+	if (method != ZIP_METHOD_AUTO) return method;
+
+	if (String_CaselessEnds(path, &png) || String_CaselessEnds(path, &ogg)) return ZIP_METHOD_STORE;
+	if (String_CaselessEnds(path, &zip) || String_CaselessEnds(path, &jpg)) return ZIP_METHOD_STORE;
+	return ZIP_METHOD_DEFLATE;
+}
+
+/* Records the first error that occurs, after which nothing more is written to the archive */
+static cc_result ZipWriter_Fail(struct ZipWriter* w, cc_result res) {
+	if (!w->res) w->res = res;
+	return res;
+}
+
+static cc_result ZipWriter_Write(struct ZipWriter* w, const cc_uint8* data, cc_uint32 len) {
+	cc_result res = Stream_Write(w->dest, data, len);
+	if (res) return ZipWriter_Fail(w, res);
+
+	w->offset += len;
+	return 0;
+}
+
+static cc_result ZipWriter_AppendEntry(struct ZipWriter* w, const cc_string* path, int method, int flags) {
+	struct ZipWriterEntry* e;
+	void* mem;
+	if (path->length > ZIP_MAXNAMELEN) return ZIP_ERR_FILENAME_LEN;
+	if (w->count >= 0xFFFF)            return ZIP_ERR_TOO_MANY_ENTRIES;
+
+	if (w->count == w->capacity) {
+		mem = Mem_TryRealloc(w->entries, w->capacity * 2, sizeof(struct ZipWriterEntry));
+		if (!mem) return ERR_OUT_OF_MEMORY;
+		w->entries   = (struct ZipWriterEntry*)mem;
+		w->capacity *= 2;
+	}
+	while (w->pathsLen + path->length > w->pathsCapacity) {
+		mem = Mem_TryRealloc(w->paths, w->pathsCapacity * 2, 1);
+		if (!mem) return ERR_OUT_OF_MEMORY;
+		w->paths          = (char*)mem;
+		w->pathsCapacity *= 2;
+	}
+
+	e = &w->entries[w->count++];
+	Mem_Set(&e->entry, 0, sizeof(e->entry));
+	e->method     = method;
+	e->flags      = flags;
+	e->pathOffset = w->pathsLen;
+	e->pathLength = path->length;
+
+	Mem_Copy(w->paths + w->pathsLen, path->buffer, path->length);
+	w->pathsLen += path->length;
+	return 0;
+}
+
+static cc_result ZipWriter_LocalHeader(struct ZipWriter* w, struct ZipWriterEntry* e) {
+	cc_uint8 header[30 + ZIP_MAXNAMELEN];
+	e->entry.LocalHeaderOffset = w->offset;
+
+	Stream_SetU32_LE(header + 0,  ZIP_SIG_LOCALFILEHEADER);
+	Stream_SetU16_LE(header + 4,  20);            /* version needed */
+	Stream_SetU16_LE(header + 6,  e->flags);      /* bitflags */
+	Stream_SetU16_LE(header + 8,  e->method);     /* compression method */
+	Stream_SetU16_LE(header + 10, w->modTime);    /* last modified */
+	Stream_SetU16_LE(header + 12, w->modDate);    /* last modified */
+
+	Stream_SetU32_LE(header + 14, e->entry.CRC32);
+	Stream_SetU32_LE(header + 18, e->entry.CompressedSize);
+	Stream_SetU32_LE(header + 22, e->entry.UncompressedSize);
+
+	Stream_SetU16_LE(header + 26, e->pathLength); /* name length */
+	Stream_SetU16_LE(header + 28, 0);             /* extra field length */
+
+	Mem_Copy(header + 30, w->paths + e->pathOffset, e->pathLength);
+	return ZipWriter_Write(w, header, 30 + e->pathLength);
+}
+
+static cc_result ZipWriter_CentralHeader(struct ZipWriter* w, struct ZipWriterEntry* e) {
+	cc_uint8 header[46 + ZIP_MAXNAMELEN];
+
+	Stream_SetU32_LE(header + 0,  ZIP_SIG_CENTRALDIR);
+	Stream_SetU16_LE(header + 4,  20);            /* version */
+	Stream_SetU16_LE(header + 6,  20);            /* version needed */
+	Stream_SetU16_LE(header + 8,  e->flags);      /* bitflags */
+	Stream_SetU16_LE(header + 10, e->method);     /* compression method */
+	Stream_SetU16_LE(header + 12, w->modTime);    /* last modified */
+	Stream_SetU16_LE(header + 14, w->modDate);    /* last modified */
+
+	Stream_SetU32_LE(header + 16, e->entry.CRC32);
+	Stream_SetU32_LE(header + 20, e->entry.CompressedSize);
+	Stream_SetU32_LE(header + 24, e->entry.UncompressedSize);
+
+	Stream_SetU16_LE(header + 28, e->pathLength); /* name length */
+	Stream_SetU16_LE(header + 30, 0);             /* extra field length */
+	Stream_SetU16_LE(header + 32, 0);             /* file comment length */
+	Stream_SetU16_LE(header + 34, 0);             /* disk number */
+	Stream_SetU16_LE(header + 36, 0);             /* internal attributes */
+	Stream_SetU32_LE(header + 38, 0);             /* external attributes */
+	Stream_SetU32_LE(header + 42, e->entry.LocalHeaderOffset);
+
+	Mem_Copy(header + 46, w->paths + e->pathOffset, e->pathLength);
+	return ZipWriter_Write(w, header, 46 + e->pathLength);
+}
+
+static cc_result ZipWriter_EndOfCentralDir(struct ZipWriter* w, cc_uint32 centralDirBeg) {
+	cc_uint8 header[22];
+
+	Stream_SetU32_LE(header + 0,  ZIP_SIG_ENDOFCENTRALDIR);
+	Stream_SetU16_LE(header + 4,  0);        /* disk number */
+	Stream_SetU16_LE(header + 6,  0);        /* disk number of start */
+	Stream_SetU16_LE(header + 8,  w->count); /* disk entries */
+	Stream_SetU16_LE(header + 10, w->count); /* total entries */
+	Stream_SetU32_LE(header + 12, w->offset - centralDirBeg); /* central dir size */
+	Stream_SetU32_LE(header + 16, centralDirBeg);             /* central dir start */
+	Stream_SetU16_LE(header + 20, 0);        /* comment length */
+	return ZipWriter_Write(w, header, 22);
+}
+
+static cc_result ZipWriter_WriteOutput(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct ZipWriterJob* job = (struct ZipWriterJob*)s->Meta.Inflate;
+	*modified = 0;
+	/* Not worth storing compressed if it ends up larger than the original data */
+	if (job->outputLen + count > job->len) return ERR_END_OF_STREAM;
+
+	Mem_Copy(job->output + job->outputLen, data, count);
+	job->outputLen += count;
+	*modified       = count;
+	return 0;
+}
+
+/* Calculates CRC32 of the entry data, then compresses it if needed */
+static void ZipWriter_Compress(struct ZipWriterJob* job, struct DeflateState* state) {
+	struct Stream output, stream;
+	cc_result res;
+	job->crc32 = Utils_CRC32(job->data, job->len);
+	if (job->method != ZIP_METHOD_DEFLATE) return;
+
+	if (job->outputCapacity < job->len) {
+		Mem_Free(job->output);
+		job->output = (cc_uint8*)Mem_TryAlloc(job->len, 1);
+		job->outputCapacity = job->output ? job->len : 0;
+	}
+	/* Entry is just stored instead when out of memory, or when compressed data ends up larger */
+	if (!job->output || !state) { job->method = ZIP_METHOD_STORE; return; }
+
+	Stream_Init(&output);
+	output.Meta.Inflate = job;
+	output.Write        = ZipWriter_WriteOutput;
+	job->outputLen      = 0;
+
+	Deflate_MakeStream(&stream, state, &output);
+	Deflate_SetLevel(state, job->level);
+
+	res = Stream_Write(&stream, job->data, job->len);
+	if (!res) res = stream.Close(&stream);
+	if (res) job->method = ZIP_METHOD_STORE;
+}
+
+static void ZipWriter_RunJob(struct WorkerTask* task, struct DeflateState** deflate) {
+	struct ZipWriterJob* job = (struct ZipWriterJob*)task;
+	ZipWriter_Compress(job, job->method == ZIP_METHOD_DEFLATE ? Workers_GetDeflate(deflate) : NULL);
+}
+
+/* Waits for the oldest job to be compressed, then writes its entry to the archive */
+static cc_result ZipWriter_WriteOldest(struct ZipWriter* w) {
+	struct ZipWriterState* state = w->_state;
+	struct ZipWriterJob* job     = &state->jobs[state->oldest];
+	struct ZipWriterEntry* e;
+	const cc_uint8* data;
+	cc_result res;
+
+	if (state->numWorkers) Workers_Wait(&job->task);
+	job->task.status = WORKER_TASK_FREE;
+
+	e = &w->entries[job->entry];
+	e->method = job->method;
+	e->entry.CRC32            = job->crc32;
+	e->entry.UncompressedSize = job->len;
+	e->entry.CompressedSize   = job->method == ZIP_METHOD_DEFLATE ? job->outputLen : job->len;
+	data = job->method == ZIP_METHOD_DEFLATE ? job->output : job->data;
+
+	res = ZipWriter_LocalHeader(w, e);
+	if (!res) res = ZipWriter_Write(w, data, e->entry.CompressedSize);
+
+	if (job->ownsData) Mem_Free(job->data);
+	job->data     = NULL;
+	job->ownsData = false;
+
+	state->pending--;
+	state->oldest = (state->oldest + 1) % state->numJobs;
+	return res;
+}
+
+static cc_result ZipWriter_Flush(struct ZipWriter* w) {
+	cc_result res;
+	while (w->_state->pending) {
+		if ((res = ZipWriter_WriteOldest(w))) return res;
+	}
+	return 0;
+}
+
+/* Stores the entry data in the next free job, then compresses it on a worker thread */
+/* (or straight away on this thread when there aren't any workers) */
+static cc_result ZipWriter_Queue(struct ZipWriter* w, const cc_string* path, cc_uint8* data, cc_uint32 len,
+								int method, cc_bool ownsData) {
+	struct ZipWriterState* state = w->_state;
+	struct ZipWriterJob* job;
+	cc_uint8* copy;
+	cc_result res;
+
+	method = ZipWriter_ChooseMethod(w, path, method);
+	if ((res = ZipWriter_AppendEntry(w, path, method, 0))) goto failed;
+	if (state->pending == state->numJobs && (res = ZipWriter_WriteOldest(w))) goto failed;
+
+	/* Data only needs to stay around until this function returns when there aren't any workers */
+	if (!ownsData && state->numWorkers) {
+		copy = (cc_uint8*)Mem_TryAlloc(max(1, len), 1);
+		if (!copy) { res = ERR_OUT_OF_MEMORY; goto failed; }
+
+		Mem_Copy(copy, data, len);
+		data = copy; ownsData = true;
+	}
+
+	job = &state->jobs[state->cur];
+	job->data     = data;
+	job->len      = len;
+	job->ownsData = ownsData;
+	job->entry    = w->count - 1;
+	job->method   = method;
+	state->cur = (state->cur + 1) % state->numJobs;
+	state->pending++;
+
+	if (!state->numWorkers) {
+		ZipWriter_Compress(job, &state->deflate);
+		return ZipWriter_Fail(w, ZipWriter_WriteOldest(w));
+	}
+	Workers_Queue(&job->task);
+	return 0;
+
+failed:
+	if (ownsData) Mem_Free(data);
+	return ZipWriter_Fail(w, res);
+}
+
+cc_result ZipWriter_AddData(struct ZipWriter* w, const cc_string* path, const void* data, cc_uint32 len, int method) {
+	if (w->res) return w->res;
+	return ZipWriter_Queue(w, path, (cc_uint8*)data, len, method, false);
+}
+
+cc_result ZipWriter_AddStream(struct ZipWriter* w, const cc_string* path, struct Stream* src, int method) {
+	cc_uint32 len = 0, capacity = 8192, read;
+	cc_uint8* data;
+	void* mem;
+	cc_result res;
+
+	if (w->res) return w->res;
+	data = (cc_uint8*)Mem_TryAlloc(capacity, 1);
+	if (!data) return ZipWriter_Fail(w, ERR_OUT_OF_MEMORY);
+
+	for (;;) {
+		if (len == capacity) {
+			mem = Mem_TryRealloc(data, capacity * 2, 1);
+			if (!mem) { Mem_Free(data); return ZipWriter_Fail(w, ERR_OUT_OF_MEMORY); }
+			data = (cc_uint8*)mem; capacity *= 2;
+		}
+
+		res = src->Read(src, data + len, capacity - len, &read);
+		if (res) { Mem_Free(data); return ZipWriter_Fail(w, res); }
+		if (!read) break;
+		len += read;
+	}
+	return ZipWriter_Queue(w, path, data, len, method, true);
+}
+
+
+static cc_result ZipWriter_OutputWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct ZipWriter* w = (struct ZipWriter*)s->Meta.Inflate;
+	cc_result res = ZipWriter_Write(w, data, count);
+	*modified = res ? 0 : count;
+	return res;
+}
+
+static cc_result ZipWriter_StoredWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct ZipWriter* w = (struct ZipWriter*)s->Meta.Inflate;
+	struct ZipWriterState* state = w->_state;
+	cc_uint32 capacity;
+	void* mem;
+	*modified = 0;
+
+	if (state->len + count > state->storedCapacity) {
+		capacity = max(state->storedCapacity * 2, state->len + count);
+		capacity = max(capacity, 8192);
+
+		mem = Mem_TryRealloc(state->stored, capacity, 1);
+		if (!mem) return ZipWriter_Fail(w, ERR_OUT_OF_MEMORY);
+		state->stored         = (cc_uint8*)mem;
+		state->storedCapacity = capacity;
+	}
+
+	Mem_Copy(state->stored + state->len, data, count);
+	*modified = count;
+	return 0;
+}
+
+static cc_result ZipWriter_EntryWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct ZipWriterState* state = (struct ZipWriterState*)s->Meta.Inflate;
+	struct Stream* dst;
+	cc_result res;
+	*modified = 0;
+
+	dst = state->compressor.Write ? &state->compressor : &state->output;
+	if ((res = Stream_Write(dst, data, count))) return res;
+
+	state->crc32 = Utils_CRC32Update(state->crc32, data, count);
+	state->len  += count;
+	*modified    = count;
+	return 0;
+}
+
+cc_result ZipWriter_BeginEntry(struct ZipWriter* w, const cc_string* path, int method, struct Stream** stream) {
+	struct ZipWriterState* state = w->_state;
+	cc_result res;
+
+	*stream = NULL;
+	if (w->res) return w->res;
+	/* Entries added before this one must be written to the archive first */
+	if ((res = ZipWriter_Flush(w))) return ZipWriter_Fail(w, res);
+
+	method = ZipWriter_ChooseMethod(w, path, method);
+	state->crc32 = 0xFFFFFFFFUL;
+	state->len   = 0;
+
+	Stream_Init(&state->output);
+	state->output.Meta.Inflate = w;
+
+	/* Some readers (e.g. Java's ZipInputStream) reject stored entries with a data descriptor, */
+	/*  so stored data is kept until ZipWriter_EndEntry, when the CRC32 and sizes are known */
+	if (method == ZIP_METHOD_STORE) {
+		if ((res = ZipWriter_AppendEntry(w, path, method, 0))) return ZipWriter_Fail(w, res);
+		state->output.Write = ZipWriter_StoredWrite;
+	} else {
+		if ((res = ZipWriter_AppendEntry(w, path, method, ZIP_FLAG_DATADESCRIPTOR))) return ZipWriter_Fail(w, res);
+		/* CRC32 and sizes are left as 0 in the local header */
+		if ((res = ZipWriter_LocalHeader(w, &w->entries[w->count - 1]))) return res;
+
+		state->dataBeg      = w->offset;
+		state->output.Write = ZipWriter_OutputWrite;
+	}
+
+	Stream_Init(&state->compressor);
+	state->compressor.Write = NULL;
+	if (method == ZIP_METHOD_DEFLATE) {
+		Deflate_MakeStream(&state->compressor, &state->deflate, &state->output);
+		Deflate_SetLevel(&state->deflate, state->level);
+	}
+
+	Stream_Init(&state->stream);
+	state->stream.Meta.Inflate = state;
+	state->stream.Write        = ZipWriter_EntryWrite;
+	*stream = &state->stream;
+	return 0;
+}
+
+cc_result ZipWriter_EndEntry(struct ZipWriter* w) {
+	struct ZipWriterState* state = w->_state;
+	struct ZipWriterEntry* e     = &w->entries[w->count - 1];
+	cc_uint8 data[16];
+	cc_result res;
+
+	if (w->res) return w->res;
+	if (state->compressor.Write && (res = state->compressor.Close(&state->compressor))) {
+		return ZipWriter_Fail(w, res);
+	}
+
+	e->entry.CRC32            = state->crc32 ^ 0xFFFFFFFFUL;
+	e->entry.UncompressedSize = state->len;
+
+	if (e->method == ZIP_METHOD_STORE) {
+		e->entry.CompressedSize = state->len;
+		if ((res = ZipWriter_LocalHeader(w, e))) return res;
+		return ZipWriter_Write(w, state->stored, state->len);
+	}
+	e->entry.CompressedSize = w->offset - state->dataBeg;
+
+	Stream_SetU32_LE(data + 0,  ZIP_SIG_DATADESCRIPTOR);
+	Stream_SetU32_LE(data + 4,  e->entry.CRC32);
+	Stream_SetU32_LE(data + 8,  e->entry.CompressedSize);
+	Stream_SetU32_LE(data + 12, e->entry.UncompressedSize);
+	return ZipWriter_Write(w, data, sizeof(data));
+}
+
+
+/* Waits for any jobs still being compressed by the workers, then frees all buffers */
+static void ZipWriter_Free(struct ZipWriter* w) {
+	struct ZipWriterState* state = w->_state;
+	struct ZipWriterJob* job;
+	int i;
+
+	for (i = 0; state && state->jobs && i < state->numJobs; i++) {
+		job = &state->jobs[i];
+		if (state->numWorkers) Workers_Wait(&job->task);
+
+		if (job->ownsData) Mem_Free(job->data);
+		Mem_Free(job->output);
+	}
+
+	if (state) {
+		if (state->numWorkers)   Workers_Release();
+		if (state->doneWaitable) Waitable_Free(state->doneWaitable);
+		Mem_Free(state->jobs);
+		Mem_Free(state->stored);
+	}
+
+	Mem_Free(w->entries);
+	Mem_Free(w->paths);
+	Mem_Free(w->_state);
+	w->entries = NULL;
+	w->paths   = NULL;
+	w->_state  = NULL;
+}
+
+cc_result ZipWriter_End(struct ZipWriter* w) {
+	cc_uint32 centralDirBeg;
+	int i;
+	cc_result res = w->res;
+
+	if (!res) res = ZipWriter_Flush(w);
+	centralDirBeg = w->offset;
+
+	for (i = 0; !res && i < w->count; i++) {
+		res = ZipWriter_CentralHeader(w, &w->entries[i]);
+	}
+	if (!res) res = ZipWriter_EndOfCentralDir(w, centralDirBeg);
+
+	ZipWriter_Free(w);
+	return res;
+}
+
+static cc_result ZipWriter_Alloc(struct ZipWriter* w, int level) {
+	struct ZipWriterState* state;
+	int i;
+	w->capacity      = 16;
+	w->pathsCapacity = 512;
+	w->entries = (struct ZipWriterEntry*)Mem_TryAlloc(w->capacity, sizeof(struct ZipWriterEntry));
+	w->paths   = (char*)Mem_TryAlloc(w->pathsCapacity, 1);
+	w->_state  = (struct ZipWriterState*)Mem_TryAllocCleared(1, sizeof(struct ZipWriterState));
+	if (!w->entries || !w->paths || !w->_state) return ERR_OUT_OF_MEMORY;
+
+	state        = w->_state;
+	state->level = max(0, min(level, DEFLATE_LEVEL_BEST));
+	/* Not worth the overhead on single core systems */
+	if (Thread_ProcessorCount() > 1) {
+		state->numWorkers   = Workers_Acquire();
+		state->doneWaitable = Waitable_Create();
+	}
+
+	state->numJobs = max(1, state->numWorkers * 2);
+	state->jobs    = (struct ZipWriterJob*)Mem_TryAllocCleared(state->numJobs, sizeof(struct ZipWriterJob));
+	if (!state->jobs) return ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < state->numJobs; i++) {
+		state->jobs[i].task.Run          = ZipWriter_RunJob;
+		state->jobs[i].task.doneWaitable = state->doneWaitable;
+		state->jobs[i].level             = state->level;
+	}
+	return 0;
+}
+
+cc_result ZipWriter_Begin(struct ZipWriter* w, struct Stream* dest, int level) {
+	struct DateTime now;
+	cc_result res;
+
+	Mem_Set(w, 0, sizeof(*w));
+	w->dest = dest;
+
+	DateTime_CurrentLocal(&now);
+	w->modTime = (now.second / 2) | (now.minute << 5) | (now.hour << 11);
+	w->modDate = (now.day) | (now.month << 5) | ((now.year - 1980) << 9);
+
+	if ((res = ZipWriter_Alloc(w, level))) { ZipWriter_Free(w); return res; }
+	return 0;
+}
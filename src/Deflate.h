@@ -27,7 +27,7 @@ cc_result ZLibHeader_Read(struct Stream* s, struct ZLibHeader* header);
 #define INFLATE_MAX_DISTS 32
 #define INFLATE_MAX_LITS_DISTS (INFLATE_MAX_LITS + INFLATE_MAX_DISTS)
 #define INFLATE_MAX_BITS 16
-#define INFLATE_FAST_BITS 9
+#define INFLATE_FAST_BITS 11
 #define INFLATE_WINDOW_SIZE 0x8000UL
 #define INFLATE_WINDOW_MASK 0x7FFFUL
 
@@ -42,7 +42,7 @@ struct HuffmanTable {
 struct InflateState {
 	cc_uint8 State;
 	cc_bool LastBlock; /* Whether the last DEFLATE block has been encounted in the stream */
-	cc_uint32 Bits;    /* Holds bits across byte boundaries */
+	cc_uint64 Bits;    /* Holds bits across byte boundaries */
 	cc_uint32 NumBits; /* Number of bits in Bits buffer */
 
 	cc_uint8* NextIn;   /* Pointer within Input buffer to next byte that can be read */
@@ -63,6 +63,7 @@ struct InflateState {
 		struct HuffmanTable Lits;           /* Values represent literal or lengths */
 	} Table; /* union to save on memory */
 	struct HuffmanTable TableDists;         /* Values represent distances back */
+	cc_uint32 LitPairs[1 << INFLATE_FAST_BITS]; /* Two literals and total codeword bits for fast lookup, or 0 */
 	cc_uint8 Window[INFLATE_WINDOW_SIZE];    /* Holds circular buffer of recent output data, used for LZ77 */
 	cc_result result;
 };
@@ -77,39 +78,78 @@ void Inflate_Process(struct InflateState* s);
 /* If data starts with a GZIP or ZLIB header, use GZipHeader_Read or ZLibHeader_Read to first skip it. */
 CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, struct Stream* underlying);
 
+/* A contiguous run of compressed input data */
+struct InflateSpan { cc_uint8* Data; cc_uint32 Length; };
+/* Decompresses directly from the given list of input buffers, without first copying them into Input. */
+/* Stops when all input is used up, output is full, or the end of the DEFLATE data is reached. */
+/* Each span's Data and Length are updated to the input still left in it afterwards. */
+/* NOTE: Input already buffered in state (e.g. from reading via Inflate_MakeStream2) is decompressed first. */
+CC_API cc_result Inflate_ProcessSpans(struct InflateState* state, struct InflateSpan* spans, int count, 
+									cc_uint8* output, cc_uint32 outputLen, cc_uint32* written);
+
 
 #define DEFLATE_BLOCK_SIZE  16384
 #define DEFLATE_BUFFER_SIZE 32768
 #define DEFLATE_OUT_SIZE 8192
-#define DEFLATE_HASH_SIZE 0x1000UL
-#define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_HASH_BITS 13
+#define DEFLATE_HASH_SIZE (1UL << DEFLATE_HASH_BITS)
+/* Max number of literals/matches in one compressed block */
+#define DEFLATE_MAX_SYMBOLS 8192
+
+/* No compression, only stored blocks and literals */
+#define DEFLATE_LEVEL_NONE    0
+/* Fastest compression, only checking the most recent match */
+#define DEFLATE_LEVEL_FASTEST 1
+#define DEFLATE_LEVEL_DEFAULT 6
+/* Best compression, checking many previous matches */
+#define DEFLATE_LEVEL_BEST    9
+
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
 	cc_uint32 InputPosition;
+	cc_uint32 WindowBase;   /* Position within whole stream of Input[0] */
 
 	cc_uint8* NextOut;    /* Pointer within Output buffer to next byte that can be written */
 	cc_uint32 AvailOut;   /* Max number of bytes that can be written to Output buffer */
 	struct Stream* Dest; /* Destination that Output buffer is written to */
+	int Level;           /* Compression level, see DEFLATE_LEVEL_ */
 
-	cc_uint16 LitsCodewords[INFLATE_MAX_LITS]; /* Codewords for each value */
-	cc_uint8 LitsLens[INFLATE_MAX_LITS];       /* Bit lengths of each codeword */
+	cc_uint16 FixedLitsCodes[INFLATE_MAX_LITS];   /* Fixed huffman codewords for each literal/length */
+	cc_uint16 FixedDistsCodes[INFLATE_MAX_DISTS]; /* Fixed huffman codewords for each distance */
+	cc_uint32 LitsFreqs[INFLATE_MAX_LITS];        /* Number of times each literal/length occurs in current block */
+	cc_uint32 DistsFreqs[INFLATE_MAX_DISTS];      /* Number of times each distance occurs in current block */
+	int NumSymbols;                               /* Number of literals/matches in current block */
+	cc_uint8 Symbols[DEFLATE_MAX_SYMBOLS * 3];    /* Distance (0 for literal) and literal/length of each symbol */
 	
 	cc_uint8 Input[DEFLATE_BUFFER_SIZE];
 	cc_uint8 Output[DEFLATE_OUT_SIZE];
-	int Head[DEFLATE_HASH_SIZE];
-	int Prev[DEFLATE_BUFFER_SIZE];
-	cc_bool WroteHeader;
+	cc_uint32 Head[DEFLATE_HASH_SIZE];   /* Stream position of most recent data for each hash */
+	cc_uint32 Prev[DEFLATE_BUFFER_SIZE]; /* Stream position of previous data with same hash, indexed by position within window */
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Sets how much effort is spent finding matches (DEFLATE_LEVEL_NONE to DEFLATE_LEVEL_BEST) */
+/* NOTE: Must be called before any data is written to the stream. Default is DEFLATE_LEVEL_DEFAULT */
+CC_API void Deflate_SetLevel(struct DeflateState* state, int level);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
 /* GZIP compression is GZIP header, followed by DEFLATE compressed data, followed by GZIP footer. */
 CC_API void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 
+/* Size of each independently compressed part of input data in GZip_MakeParallelStream */
+#define DEFLATE_SEGMENT_SIZE (128 * 1024)
+/* Compresses input data using GZIP across multiple threads, then writes compressed output to another stream. Write only stream. */
+/* Input is split into segments that are compressed in parallel, then joined together (in order) using sync flushes. */
+/* NOTE: Returns non-zero if this is unsupported or memory couldn't be allocated. (use GZip_MakeStream instead) */
+/* NOTE: The stream must always be closed, even after a write fails. */
+CC_API cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level);
+/* Limits how many worker threads are used by GZip_MakeParallelStream, Zip_ExtractParallel and ZipWriter. */
+/* 0 (the default) uses one worker per processor. NOTE: Only applies once all the current workers have stopped. */
+CC_API void Deflate_SetMaxWorkers(int count);
+
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
 /* ZLIB compression is ZLIB header, followed by DEFLATE compressed data, followed by ZLIB footer. */
@@ -151,4 +191,88 @@ CC_API void Zip_Init(struct ZipState* state, struct Stream* input);
 /* Reads and processes the entries in a .zip archive. */
 /* NOTE: Must have been initialised with Zip_Init first. */
 CC_API cc_result Zip_Extract(struct ZipState* state);
+/* Same as Zip_Extract, but entries are read ahead then decompressed on worker threads. */
+/* Entries that are .png files are also decoded by the workers. (see Png_MakeDecodedStream) */
+/* NOTE: ProcessEntry is still called on the calling thread, with entries in the same order. */
+CC_API cc_result Zip_ExtractParallel(struct ZipState* state);
+
+/* Describes an entry in a .zip archive, as listed in the archive's central directory. */
+struct ZipIndexEntry {
+	struct ZipEntry entry;
+	int method;         /* Compression method (0 = stored, 8 = DEFLATE) */
+	int next;           /* Next entry in the same hash bucket, or -1 */
+	cc_uint32 pathOffset, pathLength;
+};
+#define ZIPINDEX_BUCKETS 256
+
+/* Parsed central directory of a .zip archive, for looking up and opening single entries. */
+struct ZipIndex {
+	struct ZipIndexEntry* entries;
+	char* paths; /* Paths of all the entries, one after the other */
+	int count;
+	/* Used to check whether the archive has changed since last loaded */
+	int total; cc_uint32 length, centralDirBeg, centralDirSize;
+	/* Index of the last entry in each bucket, or -1 */
+	int buckets[ZIPINDEX_BUCKETS];
+};
+
+/* Reads the central directory of a .zip archive into the given index. */
+/* NOTE: Does nothing if the index was already loaded from the same (unchanged) archive. */
+/* NOTE: index must be zeroed before the first call. */
+CC_API cc_result ZipIndex_Load(struct ZipIndex* index, struct Stream* input);
+/* Frees the entries of the given index. */
+CC_API void ZipIndex_Free(struct ZipIndex* index);
+/* Returns the full path of the given entry. */
+CC_API cc_string ZipIndex_UNSAFE_GetPath(struct ZipIndex* index, struct ZipIndexEntry* e);
+/* Finds the entry whose filename (path without directories) caselessly equals the given name. */
+/* NOTE: If multiple entries match, the last one in the archive is returned. Returns NULL if none. */
+CC_API struct ZipIndexEntry* ZipIndex_Find(struct ZipIndex* index, const cc_string* filename);
+/* Opens the data of the given entry for reading (decompressing if needed) through stream. */
+/* portion and inflate are only used as the source and state for decompressing the data. */
+/* NOTE: input must be the archive the index was loaded from, and can't be used while stream is. */
+CC_API cc_result ZipIndex_Open(struct ZipIndexEntry* e, struct Stream* input, struct Stream* stream,
+								struct Stream* portion, struct InflateState* inflate);
+
+/* Compression methods for entries written with ZipWriter */
+#define ZIP_METHOD_STORE    0
+#define ZIP_METHOD_DEFLATE  8
+/* Stores already compressed files (e.g. .png, .ogg), and compresses everything else with DEFLATE */
+#define ZIP_METHOD_AUTO    -1
+struct ZipWriterEntry;
+struct ZipWriterState;
+
+/* Stores state for writing a .zip archive. Never seeks, so the destination stream can be write only. */
+struct ZipWriter {
+	struct Stream* dest;
+	cc_uint32 offset; /* Number of bytes written to dest so far */
+	cc_result res;    /* First error that occurred, after which nothing more gets written */
+	int modTime, modDate;
+	/* (internal) Entries written or queued so far, for the central directory */
+	struct ZipWriterEntry* entries;
+	char* paths;
+	int count, capacity;
+	cc_uint32 pathsLen, pathsCapacity;
+	/* (internal) State for the entry being written through a stream */
+	struct ZipWriterState* _state;
+};
+
+/* Begins writing a .zip archive to the given stream. level is the DEFLATE compression level. */
+/* NOTE: If this succeeds, ZipWriter_End must always be called afterwards to free the writer. */
+CC_API cc_result ZipWriter_Begin(struct ZipWriter* w, struct Stream* dest, int level);
+/* Adds an entry with the given data, which is compressed on a worker thread if possible. */
+/* NOTE: data is copied, so the caller can free or reuse it as soon as this returns. */
+/* NOTE: Entries are still written to the archive in the same order they are added. */
+CC_API cc_result ZipWriter_AddData(struct ZipWriter* w, const cc_string* path, const void* data, cc_uint32 len, int method);
+/* Same as ZipWriter_AddData, but the data is all read from the given stream. */
+CC_API cc_result ZipWriter_AddStream(struct ZipWriter* w, const cc_string* path, struct Stream* src, int method);
+/* Begins an entry whose data is written through the returned stream (and compressed as it is written). */
+/* CRC32 and sizes of the entry are written in a data descriptor after the data, by ZipWriter_EndEntry. */
+/* NOTE: Stored entries are instead kept in memory until ZipWriter_EndEntry, which writes them with a full local header. */
+/* NOTE: ZipWriter_EndEntry must be called before adding any other entries. */
+CC_API cc_result ZipWriter_BeginEntry(struct ZipWriter* w, const cc_string* path, int method, struct Stream** stream);
+/* Finishes the entry begun with ZipWriter_BeginEntry. */
+CC_API cc_result ZipWriter_EndEntry(struct ZipWriter* w);
+/* Writes any remaining entries and then the central directory, then frees the writer. */
+/* Returns the first error that occurred while writing the archive. */
+CC_API cc_result ZipWriter_End(struct ZipWriter* w);
 #endif
@@ -331,9 +331,14 @@ static void InterpComp_SetPos(struct InterpState* state, struct LocationUpdate*
 /*########################################################################################################################*
 *----------------------------------------------NetworkInterpolationComponent----------------------------------------------*
 *#########################################################################################################################*/
+/* Maximum number of states to extrapolate when the server is late sending the next position */
+#define NETINTERP_MAX_EXTRAPOLATE 2
+/* Entities moving further than this per state have likely teleported, so shouldn't be extrapolated */
+#define NETINTERP_MAX_VELOCITY_SQ (2.0f * 2.0f)
+
 static void NetInterpComp_RemoveOldestState(struct NetInterpComp* interp) {
 	int i;
-	for (i = 0; i < Array_Elems(interp->States); i++) {
+	for (i = 0; i < Array_Elems(interp->States) - 1; i++) {
 		interp->States[i] = interp->States[i + 1];
 	}
 	interp->StatesCount--;
@@ -361,9 +366,21 @@ void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpda
 		interp->Prev = *cur; interp->PrevRotY = cur->Yaw;
 		interp->Next = *cur; interp->NextRotY = cur->Yaw;
 		interp->RotYCount = 0; interp->StatesCount = 0;
+		interp->Extrapolated = 0;
+		Vec3_Set(interp->Velocity, 0, 0, 0);
 	} else {
 		/* Smoother interpolation by also adding midpoint. */
 		struct InterpState mid;
+		Vec3_Sub(&interp->Velocity, &cur->Pos, &last.Pos);
+		Vec3_Mul1By(&interp->Velocity, 0.5f);
+		if (Vec3_LengthSquared(&interp->Velocity) > NETINTERP_MAX_VELOCITY_SQ) {
+			Vec3_Set(interp->Velocity, 0, 0, 0);
+		}
+
+		/* Continue on from the guessed position, rather than jumping back to the last known position */
+		if (interp->Extrapolated && !interp->StatesCount) last.Pos = interp->Next.Pos;
+		interp->Extrapolated = 0;
+
 		Vec3_Lerp(&mid.Pos, &last.Pos, &cur->Pos, 0.5f);
 		mid.RotX  = Math_LerpAngle(last.RotX,  cur->RotX,  0.5f);
 		mid.RotZ  = Math_LerpAngle(last.RotZ,  cur->RotZ,  0.5f);
@@ -384,6 +401,14 @@ void NetInterpComp_AdvanceState(struct NetInterpComp* interp) {
 	if (interp->StatesCount > 0) {
 		interp->Next = interp->States[0];
 		NetInterpComp_RemoveOldestState(interp);
+	} else if (interp->Extrapolated < NETINTERP_MAX_EXTRAPOLATE) {
+		/* Next position is late, so guess where the entity is from how it was last moving */
+		Vec3_AddBy(&interp->Next.Pos, &interp->Velocity);
+		interp->Extrapolated++;
+	} else if (interp->Extrapolated == NETINTERP_MAX_EXTRAPOLATE) {
+		/* Entity has likely stopped moving, so move back to the last known position */
+		interp->Next.Pos = interp->Cur.Pos;
+		interp->Extrapolated++;
 	}
 	InterpComp_AdvanceRotY((struct InterpComp*)interp);
 }
@@ -96,6 +96,10 @@ struct NetInterpComp {
 	InterpComp_Layout
 	/* Last known position and orientation sent by the server */
 	struct InterpState Cur;
+	/* Change in position per state, estimated from the last two positions sent by the server */
+	Vec3 Velocity;
+	/* Number of states extrapolated from Velocity since the last position sent by the server */
+	int Extrapolated;
 	int StatesCount;
 	struct InterpState States[10];
 };
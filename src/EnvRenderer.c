@@ -365,7 +365,7 @@ static void InitWeatherHeightmap(void) {
 }
 
 #define RainCalcBody(get_block)\
-for (y = maxY; y >= 0; y--, i -= World.OneY) {\
+for (y = maxY; y >= 0; i = World_PackBelow(i, y), y--) {\
 	draw = Blocks.Draw[get_block];\
 \
 	if (!(draw == DRAW_GAS || draw == DRAW_SPRITE)) {\
@@ -378,6 +378,12 @@ static int CalcRainHeightAt(int x, int maxY, int z, int hIndex) {
 	int i = World_Pack(x, maxY, z), y;
 	cc_uint8 draw;
 
+	if (World.Sections) {
+		RainCalcBody(World_GetSectionsBlock(x, y, z));
+		Weather_Heightmap[hIndex] = -1;
+		return -1;
+	}
+
 #ifndef EXTENDED_BLOCKS
 	RainCalcBody(World.Blocks[i]);
 #else
@@ -23,12 +23,50 @@
 *#########################################################################################################################*/
 static cc_result Map_ReadBlocks(struct Stream* stream) {
 	World.Volume = World.Width * World.Length * World.Height;
-	World.Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	World.Blocks = World_TryAllocBlocks(World.Volume);
 
 	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
 	return Stream_Read(stream, World.Blocks, World.Volume);
 }
 
+/* Writes either the lower or upper 8 bits of every block in the world */
+static cc_result Map_WriteBlocks(struct Stream* stream, cc_bool upper) {
+	BlockID blocks[2048];
+	BlockRaw tmp[2048];
+	int x, y, z, i, count;
+	cc_result res;
+
+#ifndef CC_BUILD_TILEDWORLD
+	if (!World.Sections) {
+#ifdef EXTENDED_BLOCKS
+		if (upper) return Stream_Write(stream, World.Blocks2, World.Volume);
+#endif
+		return Stream_Write(stream, World.Blocks, World.Volume);
+	}
+#endif
+
+	for (y = 0; y < World.Height; y++) {
+		for (z = 0; z < World.Length; z++) {
+			for (x = 0; x < World.Width; x += count) {
+				count = min(World.Width - x, (int)Array_Elems(blocks));
+
+				if (World.Sections) {
+					World_GetSectionsRow(x, y, z, blocks, count);
+				} else {
+					/* Tiled blocks arrays aren't in map file order */
+					for (i = 0; i < count; i++) { blocks[i] = World_GetBlock(x + i, y, z); }
+				}
+
+				for (i = 0; i < count; i++) {
+					tmp[i] = (BlockRaw)(upper ? blocks[i] >> 8 : blocks[i]);
+				}
+				if ((res = Stream_Write(stream, tmp, count))) return res;
+			}
+		}
+	}
+	return 0;
+}
+
 static cc_result Map_SkipGZipHeader(struct Stream* stream) {
 	struct GZipHeader gzHeader;
 	cc_result res;
@@ -60,7 +98,7 @@ void Map_LoadFrom(const cc_string* path) {
 	cc_result res;
 	Game_Reset();
 	
-	res = Stream_OpenFile(&stream, path);
+	res = Stream_OpenMapped(&stream, path);
 	if (res) { Logger_SysWarn2(res, "opening", path); return; }
 
 	importer = Map_FindImporter(path);
@@ -135,13 +173,13 @@ static cc_result Lvl_ReadCustomBlocks(struct Stream* stream) {
 				if ((res = stream->ReadU8(stream, &hasCustom))) return res;
 				if (hasCustom != 1) continue;
 				if ((res = Stream_Read(stream, chunk, sizeof(chunk)))) return res;
-				baseIndex = World_Pack(x, y, z);
+				baseIndex = World_PackLinear(x, y, z);
 
 				if ((x + LVL_CHUNKSIZE) <= adjWidth && (y + LVL_CHUNKSIZE) <= adjHeight && (z + LVL_CHUNKSIZE) <= adjLength) {
 					for (i = 0; i < sizeof(chunk); i++) {
 						xx = i & 0xF; yy = (i >> 8) & 0xF; zz = (i >> 4) & 0xF;
 
-						index = baseIndex + World_Pack(xx, yy, zz);
+						index = baseIndex + World_PackLinear(xx, yy, zz);
 						World.Blocks[index] = World.Blocks[index] == LVL_CUSTOMTILE ? chunk[i] : World.Blocks[index];
 					}
 				} else {
@@ -149,7 +187,7 @@ static cc_result Lvl_ReadCustomBlocks(struct Stream* stream) {
 						xx = i & 0xF; yy = (i >> 8) & 0xF; zz = (i >> 4) & 0xF;
 						if ((x + xx) >= World.Width || (y + yy) >= World.Height || (z + zz) >= World.Length) continue;
 
-						index = baseIndex + World_Pack(xx, yy, zz);
+						index = baseIndex + World_PackLinear(xx, yy, zz);
 						World.Blocks[index] = World.Blocks[index] == LVL_CUSTOMTILE ? chunk[i] : World.Blocks[index];
 					}
 				}
@@ -399,11 +437,12 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 		if (NbtTag_IsSmall(&tag)) {
 			res = Stream_Read(stream, tag.value.small, tag.dataSize);
 		} else {
-			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
+			/* Large byte arrays are usually blocks arrays (e.g. BlockArray) */
+			tag.value.big = World_TryAllocBlocks(tag.dataSize);
 			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
 
 			res = Stream_Read(stream, tag.value.big, tag.dataSize);
-			if (res) Mem_Free(tag.value.big);
+			if (res) World_FreeBlocks(tag.value.big);
 		}
 		break;
 	case NBT_STR:
@@ -439,7 +478,7 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 	tag.result = 0;
 	callback(&tag);
 	/* NOTE: callback must set DataBig to NULL, if doesn't want it to be freed */
-	if (!NbtTag_IsSmall(&tag)) Mem_Free(tag.value.big);
+	if (!NbtTag_IsSmall(&tag)) World_FreeBlocks(tag.value.big);
 	return tag.result;
 }
 #define IsTag(tag, tagName) (String_CaselessEqualsConst(&tag->name, tagName))
@@ -494,7 +533,7 @@ static BlockRaw* Cw_GetBlocks(struct NbtTag* tag) {
 		Mem_Copy(ptr, tag->value.small, tag->dataSize);
 	} else {
 		ptr = tag->value.big;
-		tag->value.big = NULL; /* So Nbt_ReadTag doesn't call Mem_Free on World.Blocks */
+		tag->value.big = NULL; /* So Nbt_ReadTag doesn't call World_FreeBlocks on World.Blocks */
 	}
 	return ptr;
 }
@@ -869,11 +908,11 @@ static cc_result Dat_ReadFieldData(struct Stream* stream, struct JFieldDesc* fie
 
 		if ((res = Stream_ReadU32_BE(stream, &count))) return res;
 		field->Value.Array.Size = count;
-		field->Value.Array.Ptr  = (cc_uint8*)Mem_TryAlloc(count, 1);
+		field->Value.Array.Ptr  = World_TryAllocBlocks(count);
 
 		if (!field->Value.Array.Ptr) return ERR_OUT_OF_MEMORY;
 		res = Stream_Read(stream, field->Value.Array.Ptr, count);
-		if (res) { Mem_Free(field->Value.Array.Ptr); return res; }
+		if (res) { World_FreeBlocks(field->Value.Array.Ptr); return res; }
 	} break;
 	}
 	return 0;
@@ -1113,14 +1152,15 @@ cc_result Cw_Save(struct Stream* stream) {
 		tmp[112] = Math_Deg2Packed(p->SpawnPitch);
 	}
 	if ((res = Stream_Write(stream, tmp,      sizeof(cw_begin)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+	if ((res = Map_WriteBlocks(stream, false))) return res;
 
-	if (World.Blocks != World.Blocks2) {
+	/* IDMask is only 0x3FF when World.Blocks2 is separate (or sections contain over 256 blocks) */
+	if (World.IDMask > 0xFF) {
 		Mem_Copy(tmp, cw_map2, sizeof(cw_map2));
 		Stream_SetU32_BE(&tmp[14], World.Volume);
 
-		if ((res = Stream_Write(stream, tmp,        sizeof(cw_map2)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+		if ((res = Stream_Write(stream, tmp, sizeof(cw_map2)))) return res;
+		if ((res = Map_WriteBlocks(stream, true)))              return res;
 	}
 
 	Mem_Copy(tmp, cw_meta_cpe, sizeof(cw_meta_cpe));
@@ -1186,7 +1226,7 @@ cc_result Schematic_Save(struct Stream* stream) {
 		Stream_SetU32_BE(&tmp[74], World.Volume);
 	}
 	if ((res = Stream_Write(stream, tmp, sizeof(sc_begin)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+	if ((res = Map_WriteBlocks(stream, false)))               return res;
 
 	Mem_Copy(tmp, sc_data, sizeof(sc_data));
 	{
@@ -172,7 +172,7 @@ static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, Bloc
 			for (xx = xBeg; xx <= xEnd; xx++) { dx = xx - x;
 
 				if ((dx * dx + 2 * dy * dy + dz * dz) < radiusSq) {
-					index = World_Pack(xx, yy, zz);
+					index = World_PackLinear(xx, yy, zz);
 					if (Gen_Blocks[index] == BLOCK_STONE)
 						Gen_Blocks[index] = block;
 				}
@@ -303,13 +303,13 @@ static void NotchyGen_CreateStrata(void) {
 			stoneHeight = min(stoneHeight, maxY);
 			dirtHeight  = min(dirtHeight,  maxY);
 
-			index = World_Pack(x, minStoneY, z);
+			index = World_PackLinear(x, minStoneY, z);
 			for (y = minStoneY; y <= stoneHeight; y++) {
 				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
 			}
 
 			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
+			index = World_PackLinear(x, (stoneHeight + 1), z);
 			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
 				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
 			}
@@ -404,8 +404,8 @@ static void NotchyGen_FloodFillWaterBorders(void) {
 	int x, z;
 	Gen_CurrentState = "Flooding edge water";
 
-	index1 = World_Pack(0, waterY, 0);
-	index2 = World_Pack(0, waterY, World.Length - 1);
+	index1 = World_PackLinear(0, waterY, 0);
+	index2 = World_PackLinear(0, waterY, World.Length - 1);
 	for (x = 0; x < World.Width; x++) {
 		Gen_CurrentProgress = 0.0f + ((float)x / World.Width) * 0.5f;
 
@@ -414,8 +414,8 @@ static void NotchyGen_FloodFillWaterBorders(void) {
 		index1++; index2++;
 	}
 
-	index1 = World_Pack(0,             waterY, 0);
-	index2 = World_Pack(World.Width - 1, waterY, 0);
+	index1 = World_PackLinear(0,             waterY, 0);
+	index2 = World_PackLinear(World.Width - 1, waterY, 0);
 	for (z = 0; z < World.Length; z++) {
 		Gen_CurrentProgress = 0.5f + ((float)z / World.Length) * 0.5f;
 
@@ -437,7 +437,7 @@ static void NotchyGen_FloodFillWater(void) {
 		x = Random_Next(&rnd, World.Width);
 		z = Random_Next(&rnd, World.Length);
 		y = waterLevel - Random_Range(&rnd, 1, 3);
-		NotchyGen_FloodFill(World_Pack(x, y, z), BLOCK_WATER);
+		NotchyGen_FloodFill(World_PackLinear(x, y, z), BLOCK_WATER);
 	}
 }
 
@@ -453,7 +453,7 @@ static void NotchyGen_FloodFillLava(void) {
 		x = Random_Next(&rnd, World.Width);
 		z = Random_Next(&rnd, World.Length);
 		y = (int)((waterLevel - 3) * Random_Float(&rnd) * Random_Float(&rnd));
-		NotchyGen_FloodFill(World_Pack(x, y, z), BLOCK_LAVA);
+		NotchyGen_FloodFill(World_PackLinear(x, y, z), BLOCK_LAVA);
 	}
 }
 
@@ -474,7 +474,7 @@ static void NotchyGen_CreateSurfaceLayer(void) {
 			y = Heightmap[hIndex++];
 			if (y < 0 || y >= World.Height) continue;
 
-			index = World_Pack(x, y, z);
+			index = World_PackLinear(x, y, z);
 			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
 
 			/* TODO: update heightmap */
@@ -513,7 +513,7 @@ static void NotchyGen_PlantFlowers(void) {
 				flowerY = Heightmap[flowerZ * World.Width + flowerX] + 1;
 				if (flowerY <= 0 || flowerY >= World.Height) continue;
 
-				index = World_Pack(flowerX, flowerY, flowerZ);
+				index = World_PackLinear(flowerX, flowerY, flowerZ);
 				if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_GRASS)
 					Gen_Blocks[index] = block;
 			}
@@ -548,7 +548,7 @@ static void NotchyGen_PlantMushrooms(void) {
 				groundHeight = Heightmap[mushZ * World.Width + mushX];
 				if (mushY >= (groundHeight - 1)) continue;
 
-				index = World_Pack(mushX, mushY, mushZ);
+				index = World_PackLinear(mushX, mushY, mushZ);
 				if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_STONE)
 					Gen_Blocks[index] = block;
 			}
@@ -589,14 +589,14 @@ static void NotchyGen_PlantTrees(void) {
 				if (treeY >= World.Height) continue;
 				treeHeight = 5 + Random_Next(&rnd, 3);
 
-				index = World_Pack(treeX, treeY, treeZ);
+				index = World_PackLinear(treeX, treeY, treeZ);
 				under = treeY > 0 ? Gen_Blocks[index - World.OneY] : BLOCK_AIR;
 
 				if (under == BLOCK_GRASS && TreeGen_CanGrow(treeX, treeY, treeZ, treeHeight)) {
 					count = TreeGen_Grow(treeX, treeY, treeZ, treeHeight, coords, blocks);
 
 					for (m = 0; m < count; m++) {
-						index = World_Pack(coords[m].X, coords[m].Y, coords[m].Z);
+						index = World_PackLinear(coords[m].X, coords[m].Y, coords[m].Z);
 						Gen_Blocks[index] = blocks[m];
 					}
 				}
@@ -641,6 +641,13 @@ void NotchyGen_Generate(void) {
 BlockRaw* Tree_Blocks;
 RNGState* Tree_Rnd;
 
+#ifdef CC_BUILD_TILEDWORLD
+/* Generated blocks are only tiled once passed to World_SetNewMap */
+#define Tree_Pack(x, y, z) (Tree_Blocks == Gen_Blocks ? World_PackLinear(x, y, z) : World_Pack(x, y, z))
+#else
+#define Tree_Pack(x, y, z) World_Pack(x, y, z)
+#endif
+
 cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 	int baseHeight = treeHeight - 4;
 	int index;
@@ -652,7 +659,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 			for (x = treeX - 1; x <= treeX + 1; x++) {
 
 				if (!World_Contains(x, y, z)) return false;
-				index = World_Pack(x, y, z);
+				index = Tree_Pack(x, y, z);
 				if (Tree_Blocks[index] != BLOCK_AIR) return false;
 			}
 		}
@@ -664,7 +671,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 			for (x = treeX - 2; x <= treeX + 2; x++) {
 
 				if (!World_Contains(x, y, z)) return false;
-				index = World_Pack(x, y, z);
+				index = Tree_Pack(x, y, z);
 				if (Tree_Blocks[index] != BLOCK_AIR) return false;
 			}
 		}
@@ -455,7 +455,7 @@ static void ExtractTexturePack(const cc_string* path) {
 	struct Stream stream;
 	cc_result res;
 
-	res = Stream_OpenFile(&stream, path);
+	res = Stream_OpenMapped(&stream, path);
 	if (res == ReturnCode_FileNotFound) return;
 	if (res) { Logger_SysWarn(res, "opening texture pack"); return; }
 
@@ -12,7 +12,7 @@ static cc_int16* light_heightmap;
 #define HEIGHT_UNCALCULATED Int16_MaxValue
 
 #define Lighting_CalcBody(get_block)\
-for (y = maxY; y >= 0; y--, i -= World.OneY) {\
+for (y = maxY; y >= 0; i = World_PackBelow(i, y), y--) {\
 	block = get_block;\
 \
 	if (Blocks.BlocksLight[block]) {\
@@ -27,6 +27,12 @@ static int Lighting_CalcHeightAt(int x, int maxY, int z, int hIndex) {
 	BlockID block;
 	int y, offset;
 
+	if (World.Sections) {
+		Lighting_CalcBody(World_GetSectionsBlock(x, y, z));
+		light_heightmap[hIndex] = -10;
+		return -10;
+	}
+
 #ifndef EXTENDED_BLOCKS
 	Lighting_CalcBody(World.Blocks[i]);
 #else
@@ -138,7 +144,7 @@ static cc_bool Lighting_Needs(BlockID block, BlockID other) {
 
 #define Lighting_NeedsNeighourBody(get_block)\
 /* Update if any blocks in the chunk are affected by light change. */ \
-for (; y >= minY; y--, i -= World.OneY) {\
+for (; y >= minY; i = World_PackBelow(i, y), y--) {\
 	other    = get_block;\
 	affected = y == nY ? Lighting_Needs(block, other) : Blocks.Draw[other] != DRAW_GAS;\
 	if (affected) return true;\
@@ -147,6 +153,13 @@ for (; y >= minY; y--, i -= World.OneY) {\
 static cc_bool Lighting_NeedsNeighour(BlockID block, int i, int minY, int y, int nY) {
 	BlockID other;
 	cc_bool affected;
+	int x, z;
+
+	if (World.Sections) {
+		World_Unpack(i, x, y, z);
+		Lighting_NeedsNeighourBody(World_GetSectionsBlock(x, y, z));
+		return false;
+	}
 
 #ifndef EXTENDED_BLOCKS
 	Lighting_NeedsNeighourBody(World.Blocks[i]);
@@ -266,6 +279,13 @@ static int Lighting_InitialHeightmapCoverage(int x1, int z1, int xCount, int zCo
 	return elemsLeft;
 }
 
+#ifdef CC_BUILD_TILEDWORLD
+/* Blocks in a row are only contiguous within the same 16x16x16 tile */
+#define Lighting_MapIndex World_Pack(x1 + x, y, z1 + z)
+#else
+#define Lighting_MapIndex mapIndex
+#endif
+
 #define Lighting_CalculateBody(get_block)\
 for (y = World.Height - 1; y >= 0; y--) {\
 	if (elemsLeft <= 0) { return true; } \
@@ -315,13 +335,18 @@ static cc_bool Lighting_CalculateHeightmapCoverage(int x1, int z1, int xCount, i
 	int mapIndex, hIndex, baseIndex, index;
 	int x, y, z;
 
+	if (World.Sections) {
+		Lighting_CalculateBody(World_GetSectionsBlock(x1 + x, y, z1 + z));
+		return false;
+	}
+
 #ifndef EXTENDED_BLOCKS
-	Lighting_CalculateBody(World.Blocks[mapIndex]);
+	Lighting_CalculateBody(World.Blocks[Lighting_MapIndex]);
 #else
 	if (World.IDMask <= 0xFF) {
-		Lighting_CalculateBody(World.Blocks[mapIndex]);
+		Lighting_CalculateBody(World.Blocks[Lighting_MapIndex]);
 	} else {
-		Lighting_CalculateBody(World.Blocks[mapIndex] | (World.Blocks2[mapIndex] << 8));
+		Lighting_CalculateBody(World.Blocks[Lighting_MapIndex] | (World.Blocks2[Lighting_MapIndex] << 8));
 	}
 #endif
 	return false;
@@ -0,0 +1,583 @@
+#include "LocalServer.h"
+#ifndef CC_BUILD_WEB
+#include "String.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "Deflate.h"
+#include "Generator.h"
+#include "World.h"
+#include "Protocol.h"
+#include "ExtMath.h"
+#include "Funcs.h"
+#include "Logger.h"
+#include "Errors.h"
+#include "Game.h"
+#include "BlockID.h"
+#include "Entity.h"
+
+#define LS_MAP_WIDTH  256
+#define LS_MAP_HEIGHT 64
+#define LS_MAP_LENGTH 256
+#define LS_MAX_BOTS   254 /* IDs 0 to 253, 254 and 255 are reserved */
+#define LS_TICK_MS    50  /* Server is ticked 20 times a second */
+
+static void* ls_thread;
+static void* ls_mutex;
+static cc_bool ls_stop;
+static cc_socket ls_listener, ls_client;
+static cc_bool ls_hasClient;
+static RNGState ls_rnd;
+
+static BlockRaw* ls_blocks;
+static int ls_numBots, ls_changesPerSec;
+static float ls_pendingChanges; /* Block changes due to be sent, but not sent yet */
+
+static struct LocalBot { float x, y, z, yaw; } ls_bots[LS_MAX_BOTS];
+
+enum LS_STATE { LS_STATE_LOGIN, LS_STATE_EXTENSIONS, LS_STATE_PLAYING };
+static int ls_state;
+static int ls_clientExts; /* Number of ExtEntry packets the client has yet to send */
+static cc_bool ls_fastMap, ls_extEntityPos, ls_bulkUpdate, ls_clientRelPos, ls_extBlocks;
+/* Block IDs in packets are 2 bytes instead of 1 when ExtendedBlocks is used */
+#define LS_BLOCK_SIZE (ls_extBlocks ? 2 : 1)
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Sending-----------------------------------------------------------*
+*#########################################################################################################################*/
+/* Data waiting to be sent to the client, which grows as needed (e.g. when sending the map) */
+static cc_uint8* ls_sendBuffer;
+static cc_uint32 ls_sendHead, ls_sendTail, ls_sendCapacity;
+
+/* Returns pointer to space for the given number of bytes at the end of the outgoing data */
+static cc_uint8* LocalServer_Reserve(cc_uint32 count) {
+	cc_uint32 pending = ls_sendTail - ls_sendHead;
+	cc_uint8* dst;
+
+	/* Move unsent data back to the start (when it won't overlap), so that the buffer doesn't keep growing */
+	if (ls_sendHead && pending <= ls_sendHead) {
+		Mem_Copy(ls_sendBuffer, ls_sendBuffer + ls_sendHead, pending);
+		ls_sendHead = 0; ls_sendTail = pending;
+	}
+
+	if (ls_sendTail + count > ls_sendCapacity) {
+		ls_sendCapacity = max(ls_sendCapacity * 2, ls_sendTail + count);
+		ls_sendBuffer   = (cc_uint8*)Mem_Realloc(ls_sendBuffer, ls_sendCapacity, 1, "local server send");
+	}
+
+	dst = ls_sendBuffer + ls_sendTail;
+	ls_sendTail += count;
+	return dst;
+}
+
+static void LocalServer_WriteString(cc_uint8* dst, const char* str) {
+	int i;
+	for (i = 0; i < STRING_SIZE; i++) {
+		dst[i] = *str ? *str++ : ' ';
+	}
+}
+
+/* Writes an entity position, in the format the client expects based on the agreed extensions */
+static cc_uint8* LocalServer_WritePos(cc_uint8* dst, float x, float y, float z) {
+	/* Clients expect Y to be the eye position, not the feet position */
+	int px = (int)(x * 32), py = (int)(y * 32) + 51, pz = (int)(z * 32);
+
+	if (ls_extEntityPos) {
+		Stream_SetU32_BE(dst + 0, px); Stream_SetU32_BE(dst + 4, py); Stream_SetU32_BE(dst + 8, pz);
+		return dst + 12;
+	}
+	Stream_SetU16_BE(dst + 0, px); Stream_SetU16_BE(dst + 2, py); Stream_SetU16_BE(dst + 4, pz);
+	return dst + 6;
+}
+
+static void LocalServer_SendMessage(const char* msg) {
+	cc_uint8* dst = LocalServer_Reserve(66);
+	dst[0] = OPCODE_MESSAGE;
+	dst[1] = 0xFF;
+	LocalServer_WriteString(dst + 2, msg);
+}
+
+static void LocalServer_SendExtInfo(void) {
+	static const char* exts[5] = { "FastMap", "ExtEntityPositions", "BulkBlockUpdate", "ClientRelPositions", "ExtendedBlocks" };
+	cc_uint8* dst;
+	int i;
+
+	dst = LocalServer_Reserve(67);
+	dst[0] = OPCODE_EXT_INFO;
+	LocalServer_WriteString(dst + 1, GAME_APP_NAME " loopback");
+	Stream_SetU16_BE(dst + 65, Array_Elems(exts));
+
+	for (i = 0; i < Array_Elems(exts); i++) {
+		dst = LocalServer_Reserve(69);
+		dst[0] = OPCODE_EXT_ENTRY;
+		LocalServer_WriteString(dst + 1, exts[i]);
+		Stream_SetU32_BE(dst + 65, 1);
+	}
+}
+
+static void LocalServer_SendIdentification(void) {
+	cc_uint8* dst = LocalServer_Reserve(131);
+	dst[0] = OPCODE_HANDSHAKE;
+	dst[1] = 7; /* protocol version */
+	LocalServer_WriteString(dst + 2,  "Loopback server");
+	LocalServer_WriteString(dst + 66, "Generating load for testing");
+	dst[130] = 0x64; /* operator */
+}
+
+static void LocalServer_SendAddEntity(cc_uint8 id, const char* name, float x, float y, float z, float yaw) {
+	cc_uint8* dst = LocalServer_Reserve(ls_extEntityPos ? 80 : 74);
+	dst[0] = OPCODE_ADD_ENTITY;
+	dst[1] = id;
+	LocalServer_WriteString(dst + 2, name);
+
+	dst    = LocalServer_WritePos(dst + 66, x, y, z);
+	dst[0] = Math_Deg2Packed(yaw);
+	dst[1] = 0;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Map sending---------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint8 ls_chunk[1024];
+static cc_uint32 ls_chunkLen;
+static cc_uint8  ls_chunkPercent;
+
+static void LocalServer_FlushChunk(void) {
+	cc_uint8* dst;
+	if (!ls_chunkLen) return;
+
+	dst = LocalServer_Reserve(1028);
+	dst[0] = OPCODE_LEVEL_DATA;
+	Stream_SetU16_BE(dst + 1, ls_chunkLen);
+	Mem_Copy(dst + 3, ls_chunk, ls_chunkLen);
+	Mem_Set(dst + 3 + ls_chunkLen, 0, 1024 - ls_chunkLen);
+	/* With ExtendedBlocks, the last byte instead indicates which layer of blocks the data is for */
+	dst[1027] = ls_extBlocks ? 0 : ls_chunkPercent;
+	ls_chunkLen = 0;
+}
+
+/* Splits compressed map data into LevelDataChunk packets */
+static cc_result LocalServer_WriteChunks(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_uint32 len;
+	*modified = count;
+
+	while (count) {
+		len = min(count, 1024 - ls_chunkLen);
+		Mem_Copy(ls_chunk + ls_chunkLen, data, len);
+		ls_chunkLen += len; data += len; count -= len;
+		if (ls_chunkLen == 1024) LocalServer_FlushChunk();
+	}
+	return 0;
+}
+
+static void LocalServer_SendMap(void) {
+	static struct GZipState gzip;
+	static struct DeflateState deflate;
+	struct Stream chunks, compressed;
+	cc_uint32 i, volume = LS_MAP_WIDTH * LS_MAP_HEIGHT * LS_MAP_LENGTH;
+	cc_uint8 tmp[4];
+	cc_uint8* dst;
+	cc_result res;
+
+	dst    = LocalServer_Reserve(ls_fastMap ? 5 : 1);
+	dst[0] = OPCODE_LEVEL_BEGIN;
+	if (ls_fastMap) Stream_SetU32_BE(dst + 1, volume);
+
+	Stream_Init(&chunks);
+	chunks.Write = LocalServer_WriteChunks;
+	ls_chunkLen  = 0;
+
+	/* Fast map uses raw DEFLATE, with the volume sent in LevelInit instead */
+	if (ls_fastMap) {
+		Deflate_MakeStream(&compressed, &deflate, &chunks);
+		Deflate_SetLevel(&deflate, DEFLATE_LEVEL_FASTEST);
+		res = 0;
+	} else {
+		GZip_MakeStream(&compressed, &gzip, &chunks);
+		Deflate_SetLevel(&gzip.Base, DEFLATE_LEVEL_FASTEST);
+		Stream_SetU32_BE(tmp, volume);
+		res = Stream_Write(&compressed, tmp, 4);
+	}
+
+	for (i = 0; !res && i < volume; i += LS_MAP_WIDTH * LS_MAP_LENGTH) {
+		ls_chunkPercent = (cc_uint8)(i * 100.0f / volume);
+		res = Stream_Write(&compressed, ls_blocks + i, LS_MAP_WIDTH * LS_MAP_LENGTH);
+	}
+	if (!res) res = compressed.Close(&compressed);
+	if (res) Logger_SysWarn(res, "compressing loopback map");
+
+	ls_chunkPercent = 100;
+	LocalServer_FlushChunk();
+
+	dst    = LocalServer_Reserve(7);
+	dst[0] = OPCODE_LEVEL_END;
+	Stream_SetU16_BE(dst + 1, LS_MAP_WIDTH);
+	Stream_SetU16_BE(dst + 3, LS_MAP_HEIGHT);
+	Stream_SetU16_BE(dst + 5, LS_MAP_LENGTH);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Load------------------------------------------------------------*
+*#########################################################################################################################*/
+#define LS_Index(x, y, z) (((y) * LS_MAP_LENGTH + (z)) * LS_MAP_WIDTH + (x))
+
+/* Returns the Y coordinate just above the highest non-air block at the given coordinates */
+static int LocalServer_SurfaceY(int x, int z) {
+	int y;
+	for (y = LS_MAP_HEIGHT - 1; y >= 0; y--) {
+		if (ls_blocks[LS_Index(x, y, z)] != BLOCK_AIR) return y + 1;
+	}
+	return 0;
+}
+
+static void LocalServer_SpawnEntities(void) {
+	cc_string name; char nameBuffer[STRING_SIZE];
+	char nameRaw[STRING_SIZE + 1];
+	int i, x, z;
+
+	x = LS_MAP_WIDTH / 2; z = LS_MAP_LENGTH / 2;
+	LocalServer_SendAddEntity(ENTITIES_SELF_ID, "Player", x + 0.5f, (float)LocalServer_SurfaceY(x, z), z + 0.5f, 0);
+
+	for (i = 0; i < ls_numBots; i++) {
+		x = Random_Next(&ls_rnd, LS_MAP_WIDTH);
+		z = Random_Next(&ls_rnd, LS_MAP_LENGTH);
+
+		ls_bots[i].x   = x + 0.5f;
+		ls_bots[i].y   = (float)LocalServer_SurfaceY(x, z);
+		ls_bots[i].z   = z + 0.5f;
+		ls_bots[i].yaw = Random_Float(&ls_rnd) * 360.0f;
+
+		String_InitArray(name, nameBuffer);
+		String_Format1(&name, "Bot%i", &i);
+		String_CopyToRaw(nameRaw, STRING_SIZE + 1, &name);
+		LocalServer_SendAddEntity((cc_uint8)i, nameRaw, ls_bots[i].x, ls_bots[i].y, ls_bots[i].z, ls_bots[i].yaw);
+	}
+}
+
+/* Moves each bot forwards, turning a little bit and following the terrain */
+static void LocalServer_MoveBots(void) {
+	struct LocalBot* bot;
+	cc_uint8* dst;
+	int i;
+
+	for (i = 0; i < ls_numBots; i++) {
+		bot = &ls_bots[i];
+		bot->yaw += (Random_Float(&ls_rnd) - 0.5f) * 30.0f;
+		bot->x   += Math_SinF(bot->yaw * MATH_DEG2RAD) * 0.2f;
+		bot->z   -= Math_CosF(bot->yaw * MATH_DEG2RAD) * 0.2f;
+
+		Math_Clamp(bot->x, 0.5f, LS_MAP_WIDTH  - 0.5f);
+		Math_Clamp(bot->z, 0.5f, LS_MAP_LENGTH - 0.5f);
+		bot->y = (float)LocalServer_SurfaceY((int)bot->x, (int)bot->z);
+
+		dst    = LocalServer_Reserve(ls_extEntityPos ? 16 : 10);
+		dst[0] = OPCODE_ENTITY_TELEPORT;
+		dst[1] = (cc_uint8)i;
+		dst    = LocalServer_WritePos(dst + 2, bot->x, bot->y, bot->z);
+		dst[0] = Math_Deg2Packed(bot->yaw);
+		dst[1] = 0;
+	}
+}
+
+/* Changes a random surface block, either removing it or placing a block on top of it */
+static void LocalServer_RandomChange(int* index, BlockRaw* block) {
+	int x = Random_Next(&ls_rnd, LS_MAP_WIDTH);
+	int z = Random_Next(&ls_rnd, LS_MAP_LENGTH);
+	int y = LocalServer_SurfaceY(x, z);
+
+	if (y > 1 && (y == LS_MAP_HEIGHT || Random_Next(&ls_rnd, 2))) {
+		y--; *block = BLOCK_AIR;
+	} else {
+		*block = (BlockRaw)Random_Range(&ls_rnd, BLOCK_RED, BLOCK_WHITE + 1);
+	}
+
+	*index = LS_Index(x, y, z);
+	ls_blocks[*index] = *block;
+}
+
+static void LocalServer_ChangeBlocks(void) {
+	int i, count, index;
+	BlockRaw block;
+	cc_uint8* dst;
+
+	ls_pendingChanges += ls_changesPerSec * (LS_TICK_MS / 1000.0f);
+	count = (int)ls_pendingChanges;
+	ls_pendingChanges -= count;
+
+	while (count > 0) {
+		if (ls_bulkUpdate) {
+			/* Upper bits of block IDs are always 0, since only the lower 256 blocks are ever used */
+			i = min(count, 256);
+			dst = LocalServer_Reserve(ls_extBlocks ? 1346 : 1282);
+			Mem_Set(dst, 0, ls_extBlocks ? 1346 : 1282);
+			dst[0] = OPCODE_BULK_BLOCK_UPDATE;
+			dst[1] = (cc_uint8)(i - 1);
+
+			for (count -= i; i > 0; i--) {
+				LocalServer_RandomChange(&index, &block);
+				Stream_SetU32_BE(dst + 2 + (i - 1) * 4, index);
+				dst[2 + 1024 + (i - 1)] = block;
+			}
+		} else {
+			LocalServer_RandomChange(&index, &block);
+			dst    = LocalServer_Reserve(7 + LS_BLOCK_SIZE);
+			dst[0] = OPCODE_SET_BLOCK;
+			Stream_SetU16_BE(dst + 1, index % LS_MAP_WIDTH);
+			Stream_SetU16_BE(dst + 3, index / (LS_MAP_WIDTH * LS_MAP_LENGTH));
+			Stream_SetU16_BE(dst + 5, (index / LS_MAP_WIDTH) % LS_MAP_LENGTH);
+			if (ls_extBlocks) { Stream_SetU16_BE(dst + 7, block); } else { dst[7] = block; }
+			count--;
+		}
+	}
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Receiving----------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint8 ls_recvBuffer[4096];
+static int ls_recvLength;
+
+static void LocalServer_BeginPlaying(void) {
+	ls_state = LS_STATE_PLAYING;
+	LocalServer_SendIdentification();
+	LocalServer_SendMap();
+	LocalServer_SpawnEntities();
+	LocalServer_SendMessage("&eWelcome to the loopback test server");
+}
+
+static void LocalServer_HandleLogin(cc_uint8* data) {
+	if (ls_state != LS_STATE_LOGIN) return;
+
+	/* Client only supports CPE if it sets the magic value */
+	if (data[130] != 0x42) { LocalServer_BeginPlaying(); return; }
+	ls_state = LS_STATE_EXTENSIONS;
+	LocalServer_SendExtInfo();
+}
+
+static void LocalServer_HandleExtInfo(cc_uint8* data) {
+	ls_clientExts = Stream_GetU16_BE(data + 65);
+	if (!ls_clientExts) LocalServer_BeginPlaying();
+}
+
+static void LocalServer_HandleExtEntry(cc_uint8* data) {
+	cc_string name = String_Init((char*)data + 1, STRING_SIZE, STRING_SIZE);
+	String_UNSAFE_TrimEnd(&name);
+
+	if (String_CaselessEqualsConst(&name, "FastMap"))            ls_fastMap      = true;
+	if (String_CaselessEqualsConst(&name, "ExtEntityPositions")) ls_extEntityPos = true;
+	if (String_CaselessEqualsConst(&name, "BulkBlockUpdate"))    ls_bulkUpdate   = true;
+	if (String_CaselessEqualsConst(&name, "ClientRelPositions")) ls_clientRelPos = true;
+	if (String_CaselessEqualsConst(&name, "ExtendedBlocks"))     ls_extBlocks    = true;
+
+	/* Client sends all of its extensions before any further packets */
+	if (--ls_clientExts == 0) LocalServer_BeginPlaying();
+}
+
+static void LocalServer_HandleSetBlock(cc_uint8* data) {
+	int x = Stream_GetU16_BE(data + 1);
+	int y = Stream_GetU16_BE(data + 3);
+	int z = Stream_GetU16_BE(data + 5);
+	int block = ls_extBlocks ? Stream_GetU16_BE(data + 8) : data[8];
+	if (x >= LS_MAP_WIDTH || y >= LS_MAP_HEIGHT || z >= LS_MAP_LENGTH) return;
+	/* Map is only sent as the lower 256 blocks */
+	if (block > 255) return;
+
+	ls_blocks[LS_Index(x, y, z)] = data[7] ? (BlockRaw)block : BLOCK_AIR;
+}
+
+/* Returns size of the given packet sent by clients, or 0 if not a packet clients send */
+/* NOTE: Sizes depend on the extensions negotiated, as the client includes its held block in position packets */
+static int LocalServer_PacketSize(cc_uint8 opcode) {
+	switch (opcode) {
+	case OPCODE_HANDSHAKE:        return 131;
+	case OPCODE_SET_BLOCK_CLIENT: return 8 + LS_BLOCK_SIZE;
+	case OPCODE_ENTITY_TELEPORT:  return (ls_extEntityPos ? 15 : 9) + LS_BLOCK_SIZE;
+	case OPCODE_RELPOS_AND_ORI_UPDATE: return ls_clientRelPos ? 6 + LS_BLOCK_SIZE : 0;
+	case OPCODE_RELPOS_UPDATE:         return ls_clientRelPos ? 4 + LS_BLOCK_SIZE : 0;
+	case OPCODE_ORI_UPDATE:            return ls_clientRelPos ? 3 + LS_BLOCK_SIZE : 0;
+	case OPCODE_MESSAGE:          return 66;
+	case OPCODE_EXT_INFO:         return 67;
+	case OPCODE_EXT_ENTRY:        return 69;
+	}
+	return 0;
+}
+
+/* Handles all complete packets received, returning false if the client sent an invalid packet */
+static cc_bool LocalServer_HandlePackets(void) {
+	cc_uint8* data;
+	int size, pos = 0;
+
+	while (pos < ls_recvLength) {
+		data = ls_recvBuffer + pos;
+		size = LocalServer_PacketSize(data[0]);
+		if (!size) return false;
+		if (pos + size > ls_recvLength) break;
+
+		switch (data[0]) {
+		case OPCODE_HANDSHAKE:        LocalServer_HandleLogin(data);    break;
+		case OPCODE_SET_BLOCK_CLIENT: LocalServer_HandleSetBlock(data); break;
+		case OPCODE_EXT_INFO:         LocalServer_HandleExtInfo(data);  break;
+		case OPCODE_EXT_ENTRY:        LocalServer_HandleExtEntry(data); break;
+		}
+		pos += size;
+	}
+
+	/* Keep any partial packet at the start of the buffer */
+	ls_recvLength -= pos;
+	if (pos) Mem_Move(ls_recvBuffer, ls_recvBuffer + pos, ls_recvLength);
+	return true;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Server-----------------------------------------------------------*
+*#########################################################################################################################*/
+static void LocalServer_DropClient(const char* reason) {
+	if (!ls_hasClient) return;
+	Platform_Log1("Loopback server: dropping client (%c)", reason);
+
+	Socket_Close(ls_client);
+	ls_hasClient = false;
+}
+
+static void LocalServer_Accept(void) {
+	cc_socket client;
+	if (Socket_Accept(ls_listener, &client)) return;
+
+	/* Only one client at a time is supported */
+	if (ls_hasClient) { Socket_Close(client); return; }
+	ls_client    = client;
+	ls_hasClient = true;
+
+	ls_state      = LS_STATE_LOGIN;
+	ls_recvLength = 0;
+	ls_sendHead   = 0;
+	ls_sendTail   = 0;
+	ls_fastMap    = false; ls_extEntityPos = false; ls_bulkUpdate = false; ls_clientRelPos = false;
+	ls_extBlocks  = false;
+	Platform_LogConst("Loopback server: client connected");
+}
+
+static void LocalServer_Receive(void) {
+	cc_uint32 read;
+	cc_result res;
+
+	res = Socket_Read(ls_client, ls_recvBuffer + ls_recvLength, sizeof(ls_recvBuffer) - ls_recvLength, &read);
+	if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) return;
+
+	if (res || !read) { LocalServer_DropClient("disconnected"); return; }
+	ls_recvLength += read;
+	if (!LocalServer_HandlePackets()) LocalServer_DropClient("sent invalid packet");
+}
+
+static void LocalServer_Flush(void) {
+	cc_uint32 wrote;
+	cc_result res;
+
+	while (ls_sendHead < ls_sendTail) {
+		res = Socket_Write(ls_client, ls_sendBuffer + ls_sendHead, ls_sendTail - ls_sendHead, &wrote);
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) return;
+
+		if (res || !wrote) { LocalServer_DropClient("write failed"); return; }
+		ls_sendHead += wrote;
+	}
+}
+
+static void LocalServer_Run(void) {
+	cc_uint64 lastTick = Stopwatch_Measure(), now;
+	cc_bool stop, ready, sending;
+	int wait;
+
+	for (;;) {
+		Mutex_Lock(ls_mutex);
+		{
+			stop = ls_stop;
+		}
+		Mutex_Unlock(ls_mutex);
+		if (stop) break;
+
+		if (!ls_hasClient) {
+			Socket_PollFor(ls_listener, SOCKET_POLL_READ, LS_TICK_MS, &ready);
+			if (ready) LocalServer_Accept();
+			continue;
+		}
+
+		/* Sleep until the client sends something, there's room to send more data, or the next tick is due */
+		wait    = LS_TICK_MS;
+		if (ls_state == LS_STATE_PLAYING) wait -= Stopwatch_ElapsedMS(lastTick, Stopwatch_Measure());
+		wait    = max(wait, 0);
+		sending = ls_sendHead < ls_sendTail;
+		Socket_PollFor(ls_client, sending ? SOCKET_POLL_READWRITE : SOCKET_POLL_READ, wait, &ready);
+
+		/* Find out whether the client actually sent something, since the socket may have just become writable */
+		if (ready && sending) Socket_Poll(ls_client, SOCKET_POLL_READ, &ready);
+		if (ready) LocalServer_Receive();
+		if (!ls_hasClient) continue;
+
+		now = Stopwatch_Measure();
+		if (Stopwatch_ElapsedMS(lastTick, now) >= LS_TICK_MS && ls_state == LS_STATE_PLAYING) {
+			lastTick = now;
+			LocalServer_MoveBots();
+			LocalServer_ChangeBlocks();
+		}
+		LocalServer_Flush();
+	}
+	LocalServer_DropClient("server stopping");
+}
+
+/* Generates the map in advance, since the generator uses the client's world dimensions */
+static cc_result LocalServer_GenerateMap(void) {
+	World_SetDimensions(LS_MAP_WIDTH, LS_MAP_HEIGHT, LS_MAP_LENGTH);
+	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!Gen_Blocks) { World_SetDimensions(0, 0, 0); return ERR_OUT_OF_MEMORY; }
+
+	Gen_Seed = Random_Next(&ls_rnd, Int32_MaxValue);
+	NotchyGen_Generate();
+
+	ls_blocks  = Gen_Blocks;
+	Gen_Blocks = NULL;
+	Gen_Done   = false;
+	World_SetDimensions(0, 0, 0);
+	return 0;
+}
+
+cc_result LocalServer_Start(int bots, int changes) {
+	int port = LOCALSERVER_PORT;
+	cc_result res;
+	ls_numBots       = min(max(bots, 0), LS_MAX_BOTS);
+	ls_changesPerSec = max(changes, 0);
+	Random_SeedFromCurrentTime(&ls_rnd);
+
+	if ((res = LocalServer_GenerateMap())) return res;
+	if ((res = Socket_Listen(&ls_listener, LOCALSERVER_PORT))) return res;
+
+	Platform_Log3("Loopback server: listening on port %i (%i bots, %i changes/sec)",
+		&port, &ls_numBots, &ls_changesPerSec);
+	ls_mutex  = Mutex_Create();
+	ls_stop   = false;
+	ls_thread = Thread_Start(LocalServer_Run);
+	return 0;
+}
+
+void LocalServer_Stop(void) {
+	if (!ls_thread) return;
+	Mutex_Lock(ls_mutex);
+	{
+		ls_stop = true;
+	}
+	Mutex_Unlock(ls_mutex);
+
+	Thread_Join(ls_thread);
+	ls_thread = NULL;
+	Mutex_Free(ls_mutex);
+	Socket_Close(ls_listener);
+
+	Mem_Free(ls_blocks);
+	Mem_Free(ls_sendBuffer);
+	ls_blocks     = NULL;
+	ls_sendBuffer = NULL;
+}
+#endif
@@ -0,0 +1,17 @@
+#ifndef CC_LOCALSERVER_H
+#define CC_LOCALSERVER_H
+#include "Core.h"
+/* Implements a minimal Classic/CPE server that runs on a background thread and listens on the loopback address.
+   Generates a map, then synthesizes load (moving bots and block changes) for testing the client's networking.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+
+/* Port the loopback server listens on */
+#define LOCALSERVER_PORT 25565
+
+/* Generates the map, then starts listening for a client on LOCALSERVER_PORT. */
+/* bots is number of moving bot entities, changes is number of random block changes per second. */
+cc_result LocalServer_Start(int bots, int changes);
+/* Disconnects any client and stops the server. */
+void LocalServer_Stop(void);
+#endif
@@ -1348,11 +1348,18 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 	static const cc_string cw = String_FromConst(".cw");
 	struct Stream stream, compStream;
 	struct GZipState state;
+	int level;
 	cc_result res;
 
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return; }
-	GZip_MakeStream(&compStream, &state, &stream);
+	level = Options_GetInt(OPT_MAP_COMPRESSION, DEFLATE_LEVEL_NONE, DEFLATE_LEVEL_BEST, DEFLATE_LEVEL_DEFAULT);
+
+	/* Compressing on multiple threads avoids freezing the game for long when saving large maps */
+	if (GZip_MakeParallelStream(&compStream, &stream, level)) {
+		GZip_MakeStream(&compStream, &state, &stream);
+		Deflate_SetLevel(&state.Base, level);
+	}
 
 #ifdef CC_BUILD_WEB
 	res = Cw_Save(&compStream);
@@ -1365,6 +1372,8 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 #endif
 
 	if (res) {
+		/* Still need to close, so compression threads are stopped */
+		compStream.Close(&compStream);
 		stream.Close(&stream);
 		Logger_SysWarn2(res, "encoding", path); return;
 	}
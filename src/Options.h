@@ -73,6 +73,9 @@
 #define OPT_TOUCH_SCALE "gui-touchscale"
 #define OPT_HTTP_ONLY "http-no-https"
 #define OPT_RAW_INPUT "win-raw-input"
+#define OPT_SEND_QUEUE_MAX "net-sendqueue-max"
+#define OPT_POSITION_HEARTBEAT "net-position-heartbeat"
+#define OPT_MAP_COMPRESSION "map-compression-level"
 
 #define LOPT_SESSION  "launcher-session"
 #define LOPT_USERNAME "launcher-cc-username"
@@ -6,7 +6,7 @@
 */
 struct DateTime;
 
-enum Socket_PollMode { SOCKET_POLL_READ, SOCKET_POLL_WRITE };
+enum Socket_PollMode { SOCKET_POLL_READ, SOCKET_POLL_WRITE, SOCKET_POLL_READWRITE };
 #ifdef CC_BUILD_WIN
 typedef cc_uintptr cc_socket;
 typedef void* cc_file;
@@ -125,11 +125,25 @@ CC_API void* Mem_AllocCleared(cc_uint32 numElems, cc_uint32 elemsSize, const cha
 CC_API void* Mem_Realloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, const char* place);
 /* Frees an allocated a block of memory. Does nothing when passed NULL. */
 CC_API void  Mem_Free(void* mem);
+enum Mem_Access { MEM_ACCESS_NORMAL, MEM_ACCESS_SEQUENTIAL, MEM_ACCESS_RANDOM };
+/* Allocates a block of memory backed by a temporary file, with contents of all 0. */
+/* Pages are only loaded into memory when accessed, and can be written back to the file */
+/*  when memory is low, so the block can be larger than the amount of free memory. */
+/* Returns NULL if unsupported, or on failure to create/map the temporary file. */
+void* Mem_TryAllocMapped(cc_uint32 numBytes);
+/* Frees a block of memory allocated by Mem_TryAllocMapped or File_TryMap. */
+void  Mem_FreeMapped(void* mem, cc_uint32 numBytes);
+/* Hints to the OS how a block of memory allocated by Mem_TryAllocMapped or File_TryMap will be accessed. */
+/* (e.g. sequential access lets the OS read ahead aggressively, and drop pages behind) */
+void  Mem_AdviseMapped(void* mem, cc_uint32 numBytes, int access);
+
 /* Sets the contents of a block of memory to the given value. */
 void Mem_Set(void* dst, cc_uint8 value, cc_uint32 numBytes);
 /* Copies a block of memory to another block of memory. */
 /* NOTE: These blocks MUST NOT overlap. */
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes);
+/* Copies a block of memory to another block of memory, which may overlap. */
+void Mem_Move(void* dst, const void* src, cc_uint32 numBytes);
 /* Returns non-zero if the two given blocks of memory have equal contents. */
 int Mem_Equal(const void* a, const void* b, cc_uint32 numBytes);
 
@@ -181,9 +195,15 @@ cc_result File_Seek(cc_file file, int offset, int seekType);
 cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
+/* Attempts to map the first len bytes of the given file into memory, for reading only. */
+/* Returns NULL if unsupported, or on failure to map the file. (e.g. file is empty) */
+/* NOTE: The file can be closed afterwards. Mem_FreeMapped must be used to unmap the memory. */
+void* File_TryMap(cc_file file, cc_uint32 len);
 
 /* Blocks the current thread for the given number of milliseconds. */
 CC_API void Thread_Sleep(cc_uint32 milliseconds);
+/* Returns the number of processors that threads can run on. (at least 1) */
+int Thread_ProcessorCount(void);
 typedef void (*Thread_StartFunc)(void);
 /* Starts a new thread and then runs the given function in that thread. */
 /* NOTE: Threads must either be detached or joined, otherwise data leaks. */
@@ -227,6 +247,11 @@ CC_API int Socket_ValidAddress(const cc_string* address);
 
 /* Allocates a new non-blocking socket and then begins connecting to the given address:port. */
 CC_API cc_result Socket_Connect(cc_socket* s, const cc_string* address, int port);
+/* Allocates a new non-blocking socket that listens for connections to the given port on the loopback address. */
+CC_API cc_result Socket_Listen(cc_socket* s, int port);
+/* Accepts a pending connection on the given listening socket, as a new non-blocking socket. */
+/* NOTE: Returns ReturnCode_SocketWouldBlock (or equivalent) when there are no pending connections. */
+CC_API cc_result Socket_Accept(cc_socket s, cc_socket* client);
 /* Attempts to read data from the given socket. */
 CC_API cc_result Socket_Read(cc_socket s, cc_uint8* data, cc_uint32 count, cc_uint32* modified);
 /* Attempts to write data to the given socket. */
@@ -234,9 +259,13 @@ CC_API cc_result Socket_Write(cc_socket s, const cc_uint8* data, cc_uint32 count
 /* Attempts to close the given socket. */
 CC_API cc_result Socket_Close(cc_socket s);
 /* Attempts to poll the given socket for readability or writability. */
+/* NOTE: SOCKET_POLL_READWRITE succeeds when the socket is either readable or writable. */
 /* NOTE: A closed socket is still considered readable. */
 /* NOTE: A socket is considered writable once it has finished connecting. */
 CC_API cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success);
+/* Same as Socket_Poll, but waits up to the given number of milliseconds for the socket to become ready. */
+/* NOTE: Does not wait on platforms without threading support (i.e. returns immediately like Socket_Poll) */
+CC_API cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success);
 
 #ifdef CC_BUILD_ANDROID
 #include <jni.h>
@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <utime.h>
 #include <signal.h>
 #include <stdio.h>
@@ -62,6 +63,7 @@ const cc_result ReturnCode_DirectoryExists  = EEXIST;
 *#########################################################################################################################*/
 void Mem_Set(void*  dst, cc_uint8 value,  cc_uint32 numBytes) { memset(dst, value, numBytes); }
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes) { memcpy(dst, src,   numBytes); }
+void Mem_Move(void* dst, const void* src, cc_uint32 numBytes) { memmove(dst, src,  numBytes); }
 
 void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
 	cc_uint32 size = CalcMemSize(numElems, elemsSize);
@@ -81,6 +83,43 @@ void Mem_Free(void* mem) {
 	if (mem) free(mem);
 }
 
+void* Mem_TryAllocMapped(cc_uint32 numBytes) {
+	/* Temp directory might be in memory (e.g. tmpfs), which would defeat the point */
+	char path[] = "blocks-XXXXXX";
+	void* mem;
+	int fd = mkstemp(path);
+	if (fd == -1) return NULL;
+
+	/* File only needs to exist for as long as it is mapped */
+	unlink(path);
+	if (ftruncate(fd, numBytes) == -1) { close(fd); return NULL; }
+
+	mem = mmap(NULL, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	return mem == MAP_FAILED ? NULL : mem;
+}
+
+void Mem_FreeMapped(void* mem, cc_uint32 numBytes) {
+	if (mem) munmap(mem, numBytes);
+}
+
+#ifdef CC_BUILD_ANDROID
+/* posix_madvise is only in bionic from API 23, but madvise has always been there */
+void Mem_AdviseMapped(void* mem, cc_uint32 numBytes, int access) {
+	int advice = MADV_NORMAL;
+	if (access == MEM_ACCESS_SEQUENTIAL) advice = MADV_SEQUENTIAL;
+	if (access == MEM_ACCESS_RANDOM)     advice = MADV_RANDOM;
+	madvise(mem, numBytes, advice);
+}
+#else
+void Mem_AdviseMapped(void* mem, cc_uint32 numBytes, int access) {
+	int advice = POSIX_MADV_NORMAL;
+	if (access == MEM_ACCESS_SEQUENTIAL) advice = POSIX_MADV_SEQUENTIAL;
+	if (access == MEM_ACCESS_RANDOM)     advice = POSIX_MADV_RANDOM;
+	posix_madvise(mem, numBytes, advice);
+}
+#endif
+
 
 /*########################################################################################################################*
 *------------------------------------------------------Logging/Time-------------------------------------------------------*
@@ -256,11 +295,23 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = st.st_size; return 0;
 }
 
+void* File_TryMap(cc_file file, cc_uint32 len) {
+	void* mem;
+	if (!len) return NULL;
+
+	mem = mmap(NULL, len, PROT_READ, MAP_PRIVATE, file, 0);
+	return mem == MAP_FAILED ? NULL : mem;
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
 void Thread_Sleep(cc_uint32 milliseconds) { usleep(milliseconds * 1000); }
+int Thread_ProcessorCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
 
 #ifdef CC_BUILD_ANDROID
 /* All threads using JNI must detach BEFORE they exit */
@@ -533,6 +584,37 @@ cc_result Socket_Connect(cc_socket* s, const cc_string* address, int port) {
 	return res == -1 ? errno : 0;
 }
 
+cc_result Socket_Listen(cc_socket* s, int port) {
+	int blocking_raw = -1, reuse = 1; /* non-blocking mode */
+	struct sockaddr_in addr = { 0 };
+	cc_result res;
+
+	*s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (*s == -1) return errno;
+	ioctl(*s, FIONBIO, &blocking_raw);
+	setsockopt(*s, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	addr.sin_family      = AF_INET;
+	addr.sin_port        = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(*s, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(*s, 4) == -1) {
+		res = errno;
+		close(*s); *s = -1;
+		return res;
+	}
+	return 0;
+}
+
+cc_result Socket_Accept(cc_socket s, cc_socket* client) {
+	int blocking_raw = -1; /* non-blocking mode */
+	*client = accept(s, NULL, NULL);
+	if (*client == -1) return errno;
+
+	ioctl(*client, FIONBIO, &blocking_raw);
+	return 0;
+}
+
 cc_result Socket_Read(cc_socket s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	int recvCount = recv(s, data, count, 0);
 	if (recvCount != -1) { *modified = recvCount; return 0; }
@@ -559,40 +641,47 @@ cc_result Socket_Close(cc_socket s) {
 
 #if defined CC_BUILD_DARWIN
 /* poll is broken on old OSX apparently https://daniel.haxx.se/docs/poll-vs-select.html */
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
-	fd_set set;
-	struct timeval time = { 0 };
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
+	fd_set readSet, writeSet;
+	struct timeval time;
 	int selectCount;
 
-	FD_ZERO(&set);
-	FD_SET(s, &set);
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
+	FD_ZERO(&readSet);  FD_SET(s, &readSet);
+	FD_ZERO(&writeSet); FD_SET(s, &writeSet);
 
-	if (mode == SOCKET_POLL_READ) {
-		selectCount = select(s + 1, &set, NULL, NULL, &time);
-	} else {
-		selectCount = select(s + 1, NULL, &set, NULL, &time);
-	}
+	selectCount = select(s + 1, mode != SOCKET_POLL_WRITE ? &readSet  : NULL,
+								mode != SOCKET_POLL_READ  ? &writeSet : NULL, NULL, &time);
 
 	if (selectCount == -1) { *success = false; return errno; }
-	*success = FD_ISSET(s, &set) != 0; return 0;
+	*success = (mode != SOCKET_POLL_WRITE && FD_ISSET(s, &readSet))
+			|| (mode != SOCKET_POLL_READ  && FD_ISSET(s, &writeSet));
+	return 0;
 }
 #else
 #include <poll.h>
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
 	struct pollfd pfd;
 	int flags;
 
 	pfd.fd     = s;
-	pfd.events = mode == SOCKET_POLL_READ ? POLLIN : POLLOUT;
-	if (poll(&pfd, 1, 0) == -1) { *success = false; return errno; }
+	pfd.events = 0;
+	if (mode != SOCKET_POLL_WRITE) pfd.events |= POLLIN;
+	if (mode != SOCKET_POLL_READ)  pfd.events |= POLLOUT;
+	if (poll(&pfd, 1, (int)milliseconds) == -1) { *success = false; return errno; }
 	
 	/* to match select, closed socket still counts as readable */
-	flags    = mode == SOCKET_POLL_READ ? (POLLIN | POLLHUP) : POLLOUT;
+	flags    = pfd.events | (mode != SOCKET_POLL_WRITE ? POLLHUP : 0);
 	*success = (pfd.revents & flags) != 0;
 	return 0;
 }
 #endif
 
+cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+	return Socket_PollFor(s, mode, 0, success);
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Process/Module------------------------------------------------------*
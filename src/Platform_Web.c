@@ -40,6 +40,7 @@ const cc_result ReturnCode_DirectoryExists  = EEXIST;
 *#########################################################################################################################*/
 void Mem_Set(void*  dst, cc_uint8 value,  cc_uint32 numBytes) { memset(dst, value, numBytes); }
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes) { memcpy(dst, src,   numBytes); }
+void Mem_Move(void* dst, const void* src, cc_uint32 numBytes) { memmove(dst, src,  numBytes); }
 
 void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
 	cc_uint32 size = CalcMemSize(numElems, elemsSize);
@@ -59,6 +60,11 @@ void Mem_Free(void* mem) {
 	if (mem) free(mem);
 }
 
+/* No memory mapped files with emscripten backend */
+void* Mem_TryAllocMapped(cc_uint32 numBytes) { return NULL; }
+void  Mem_FreeMapped(void* mem, cc_uint32 numBytes) { }
+void  Mem_AdviseMapped(void* mem, cc_uint32 numBytes, int access) { }
+
 
 /*########################################################################################################################*
 *------------------------------------------------------Logging/Time-------------------------------------------------------*
@@ -225,12 +231,16 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	}
 }
 
+/* Files are accessed through javascript, so can't be mapped */
+void* File_TryMap(cc_file file, cc_uint32 len) { return NULL; }
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
 /* No real threading support with emscripten backend */
 void Thread_Sleep(cc_uint32 milliseconds) { }
+int Thread_ProcessorCount(void) { return 1; }
 void* Thread_Start(Thread_StartFunc func) { func(); return NULL; }
 void Thread_Detach(void* handle) { }
 void Thread_Join(void* handle) { }
@@ -300,6 +310,10 @@ cc_result Socket_Connect(cc_socket* s, const cc_string* address, int port) {
 }
 
 extern int interop_SocketRecv(int sock, void* data, int len);
+/* WebSockets can only be used to connect to servers */
+cc_result Socket_Listen(cc_socket* s, int port) { return ERR_NOT_SUPPORTED; }
+cc_result Socket_Accept(cc_socket s, cc_socket* client) { return ERR_NOT_SUPPORTED; }
+
 cc_result Socket_Read(cc_socket s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	/* recv only reads one WebSocket frame at most, hence call it multiple times */
 	int res; *modified = 0;
@@ -344,7 +358,7 @@ cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 	int res = interop_SocketPoll(s), flags;
 
 	if (res >= 0) {
-		flags    = mode == SOCKET_POLL_READ ? 0x01 : 0x02;
+		flags    = mode == SOCKET_POLL_READ ? 0x01 : (mode == SOCKET_POLL_WRITE ? 0x02 : 0x03);
 		*success = (res & flags) != 0;
 		return 0;
 	} else {
@@ -352,6 +366,11 @@ cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 	}
 }
 
+/* No threading support, so waiting would only block the game */
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
+	return Socket_Poll(s, mode, success);
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Process/Module------------------------------------------------------*
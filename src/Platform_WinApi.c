@@ -40,6 +40,7 @@ static void LoadDynamicFuncs(const cc_string* path, const struct DynamicLibSym*
 *#########################################################################################################################*/
 void Mem_Set(void*  dst, cc_uint8 value,  cc_uint32 numBytes) { memset(dst, value, numBytes); }
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes) { memcpy(dst, src,   numBytes); }
+void Mem_Move(void* dst, const void* src, cc_uint32 numBytes) { memmove(dst, src,  numBytes); }
 
 void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
 	cc_uint32 size = CalcMemSize(numElems, elemsSize);
@@ -60,6 +61,36 @@ void Mem_Free(void* mem) {
 	if (mem) HeapFree(heap, 0, mem);
 }
 
+void* Mem_TryAllocMapped(cc_uint32 numBytes) {
+	WCHAR dir[MAX_PATH + 1], path[MAX_PATH + 1];
+	HANDLE file, mapping;
+	void* mem;
+
+	if (!GetTempPathW(MAX_PATH, dir))              return NULL;
+	if (!GetTempFileNameW(dir, L"ccb", 0, path)) return NULL;
+
+	/* File only needs to exist for as long as it is mapped */
+	file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+				FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (file == INVALID_HANDLE_VALUE) { DeleteFileW(path); return NULL; }
+
+	/* The mapping and view keep the file open, so it's fine to close the handles here */
+	mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, 0, numBytes, NULL);
+	CloseHandle(file);
+	if (!mapping) return NULL;
+
+	mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, numBytes);
+	CloseHandle(mapping);
+	return mem;
+}
+
+void Mem_FreeMapped(void* mem, cc_uint32 numBytes) {
+	if (mem) UnmapViewOfFile(mem);
+}
+
+/* PrefetchVirtualMemory is Windows 8+ only, and there's no equivalent for random access */
+void Mem_AdviseMapped(void* mem, cc_uint32 numBytes, int access) { }
+
 
 /*########################################################################################################################*
 *------------------------------------------------------Logging/Time-------------------------------------------------------*
@@ -275,11 +306,31 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
 
+void* File_TryMap(cc_file file, cc_uint32 len) {
+	HANDLE mapping;
+	void* mem;
+	if (!len) return NULL;
+
+	/* The view keeps the mapping open, so it's fine to close the handle here */
+	/* (Windows 9x does not support CreateFileMappingW) */
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, len, NULL);
+	if (!mapping) return NULL;
+
+	mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, len);
+	CloseHandle(mapping);
+	return mem;
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
 void Thread_Sleep(cc_uint32 milliseconds) { Sleep(milliseconds); }
+int Thread_ProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? (int)info.dwNumberOfProcessors : 1;
+}
 static DWORD WINAPI ExecThread(void* param) {
 	Thread_StartFunc func = (Thread_StartFunc)param;
 	func();
@@ -482,6 +533,36 @@ cc_result Socket_Connect(cc_socket* s, const cc_string* address, int port) {
 	return res == -1 ? WSAGetLastError() : 0;
 }
 
+cc_result Socket_Listen(cc_socket* s, int port) {
+	int blockingMode = -1; /* non-blocking mode */
+	SOCKADDR_IN addr = { 0 };
+	cc_result res;
+
+	*s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (*s == -1) return WSAGetLastError();
+	ioctlsocket(*s, FIONBIO, &blockingMode);
+
+	addr.sin_family      = AF_INET;
+	addr.sin_port        = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(*s, (SOCKADDR*)&addr, sizeof(addr)) == -1 || listen(*s, 4) == -1) {
+		res = WSAGetLastError();
+		closesocket(*s); *s = -1;
+		return res;
+	}
+	return 0;
+}
+
+cc_result Socket_Accept(cc_socket s, cc_socket* client) {
+	int blockingMode = -1; /* non-blocking mode */
+	*client = accept(s, NULL, NULL);
+	if (*client == -1) return WSAGetLastError();
+
+	ioctlsocket(*client, FIONBIO, &blockingMode);
+	return 0;
+}
+
 cc_result Socket_Read(cc_socket s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	int recvCount = recv(s, data, count, 0);
 	if (recvCount != -1) { *modified = recvCount; return 0; }
@@ -506,23 +587,30 @@ cc_result Socket_Close(cc_socket s) {
 	return res;
 }
 
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
-	fd_set set;
-	struct timeval time = { 0 };
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
+	fd_set readSet, writeSet;
+	struct timeval time;
 	int selectCount;
 
-	set.fd_count    = 1;
-	set.fd_array[0] = s;
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
+	readSet.fd_count     = 1;
+	readSet.fd_array[0]  = s;
+	writeSet.fd_count    = 1;
+	writeSet.fd_array[0] = s;
 
-	if (mode == SOCKET_POLL_READ) {
-		selectCount = select(1, &set, NULL, NULL, &time);
-	} else {
-		selectCount = select(1, NULL, &set, NULL, &time);
-	}
+	selectCount = select(1, mode != SOCKET_POLL_WRITE ? &readSet  : NULL,
+							mode != SOCKET_POLL_READ  ? &writeSet : NULL, NULL, &time);
 
 	if (selectCount == -1) { *success = false; return WSAGetLastError(); }
 
-	*success = set.fd_count != 0; return 0;
+	*success = (mode != SOCKET_POLL_WRITE && readSet.fd_count  != 0)
+			|| (mode != SOCKET_POLL_READ  && writeSet.fd_count != 0);
+	return 0;
+}
+
+cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+	return Socket_PollFor(s, mode, 0, success);
 }
 
 
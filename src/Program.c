@@ -9,6 +9,7 @@
 #include "Launcher.h"
 #include "Server.h"
 #include "Options.h"
+#include "LocalServer.h"
 
 /*#define CC_TEST_VORBIS*/
 #ifdef CC_TEST_VORBIS
@@ -84,6 +85,35 @@ CC_NOINLINE static void WarnMissingArgs(int argsCount, const cc_string* args) {
 	Logger_DialogWarn(&tmp);
 }
 
+#ifndef CC_BUILD_WEB
+/* Starts the loopback test server, then runs the game connected to it */
+static int RunLoopback(int argsCount, const cc_string* args) {
+	static const cc_string localhost = String_FromConst("127.0.0.1");
+	int bots = 0, changes = 0;
+	cc_result res;
+
+	if (argsCount > 2 && !Convert_ParseInt(&args[2], &bots)) {
+		WarnInvalidArg("Invalid bot count", &args[2]);
+		return 1;
+	}
+	if (argsCount > 3 && !Convert_ParseInt(&args[3], &changes)) {
+		WarnInvalidArg("Invalid block changes per second", &args[3]);
+		return 1;
+	}
+
+	res = LocalServer_Start(bots, changes);
+	if (res) { Logger_SysWarn(res, "starting loopback server"); return 1; }
+
+	String_Copy(&Game_Username,  &args[0]);
+	String_Copy(&Server.Address, &localhost);
+	Server.Port = LOCALSERVER_PORT;
+
+	RunGame();
+	LocalServer_Stop();
+	return 0;
+}
+#endif
+
 #ifdef CC_BUILD_ANDROID
 int Program_Run(int argc, char** argv) {
 #else
@@ -115,6 +145,17 @@ static int Program_Run(int argc, char** argv) {
 	} else if (argsCount == 1) {
 		String_Copy(&Game_Username, &args[0]);
 		RunGame();		
+	/* [username] --replay [trace file] [fast] to replay a packet trace instead of connecting */
+	} else if (argsCount >= 3 && String_CaselessEqualsConst(&args[1], "--replay")) {
+		String_Copy(&Game_Username,    &args[0]);
+		String_Copy(&Server.ReplayPath, &args[2]);
+		Server.ReplayFast = argsCount > 3 && String_CaselessEqualsConst(&args[3], "fast");
+		RunGame();
+#ifndef CC_BUILD_WEB
+	/* [username] --loopback [bots] [block changes per second] to play on a local test server */
+	} else if (argsCount >= 2 && String_CaselessEqualsConst(&args[1], "--loopback")) {
+		return RunLoopback(argsCount, args);
+#endif
 	} else if (argsCount < 4) {
 		WarnMissingArgs(argsCount, args);
 		return 1;
@@ -143,6 +184,7 @@ int main_real(int argc, char** argv) {
 int main(int argc, char** argv) {
 #endif
 	static char ipBuffer[STRING_SIZE];
+	static char replayBuffer[FILENAME_SIZE];
 	cc_result res;
 	Logger_Hook();
 	Platform_Init();
@@ -155,6 +197,7 @@ int main(int argc, char** argv) {
 #endif
 	Platform_LogConst("Starting " GAME_APP_NAME " ..");
 	String_InitArray(Server.Address, ipBuffer);
+	String_InitArray(Server.ReplayPath, replayBuffer);
 	Options_Load();
 
 	res = Program_Run(argc, argv);
@@ -29,6 +29,7 @@
 #include "Picking.h"
 #include "Input.h"
 #include "Utils.h"
+#include "Options.h"
 
 #define QUOTE(x) #x
 #define STRINGIFY(val) QUOTE(val)
@@ -38,6 +39,13 @@ struct _ProtocolData Protocol;
 static cc_uint8 classic_tabList[ENTITIES_MAX_COUNT >> 3];
 static cc_bool classic_receivedFirstPos;
 
+/* Position and orientation last sent to the server, in network units */
+struct SentPosition { int x, y, z; cc_uint8 yaw, pitch; BlockID payload; };
+static struct SentPosition classic_lastPos;
+static cc_bool classic_sentPos;
+/* Number of ticks since last sending position, and max ticks before resending an unchanged position */
+static int classic_idleTicks, classic_heartbeatTicks;
+
 /* Map state */
 static cc_bool map_begunLoading;
 static cc_uint64 map_receiveBeg;
@@ -45,6 +53,8 @@ static struct Stream map_part;
 static struct GZipHeader map_gzHeader;
 static int map_sizeIndex, map_volume;
 static cc_uint8 map_size[4];
+/* Whether the map is too large to fit in memory as flat arrays, and so is loaded into sections */
+static cc_bool map_sections;
 
 struct MapState {
 	struct InflateState inflateState;
@@ -52,18 +62,23 @@ struct MapState {
 	BlockRaw* blocks;
 	int index;
 	cc_bool allocFailed;
+	/* Compressed data that is kept until LevelFinalise when loading into sections */
+	/*  (since the dimensions of the map are needed to decompress into sections) */
+	cc_uint8* pending;
+	cc_uint32 pendingLen, pendingCap;
 };
 static struct MapState map;
 #ifdef EXTENDED_BLOCKS
 static struct MapState map2;
 #endif
+static void MapDecoder_Stop(void);
 
 /* CPE state */
 cc_bool cpe_needD3Fix;
 static int cpe_serverExtensionsCount, cpe_pingTicks;
 static int cpe_envMapVer = 2, cpe_blockDefsExtVer = 2, cpe_customModelsVer = 2;
 static cc_bool cpe_sendHeldBlock, cpe_useMessageTypes, cpe_extEntityPos, cpe_blockPerms, cpe_fastMap;
-static cc_bool cpe_twoWayPing, cpe_extTextures, cpe_extBlocks;
+static cc_bool cpe_twoWayPing, cpe_extTextures, cpe_extBlocks, cpe_clientRelPos;
 
 /*########################################################################################################################*
 *-----------------------------------------------------Common handlers-----------------------------------------------------*
@@ -161,12 +176,14 @@ static void CheckName(EntityID id, cc_string* name, cc_string* skin) {
 }
 
 static void Classic_ReadAbsoluteLocation(cc_uint8* data, EntityID id, cc_bool interpolate);
+static void DiscardLocation(EntityID id);
 static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const cc_string* skin, cc_bool readPosition) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	struct Entity* e;
 
 	if (id != ENTITIES_SELF_ID) {
 		if (Entities.List[id]) Entities_Remove(id);
+		DiscardLocation(id);
 		e = &NetPlayers_List[id].Base;
 
 		NetPlayer_Init((struct NetPlayer*)e);
@@ -191,6 +208,7 @@ void Protocol_RemoveEntity(EntityID id) {
 	struct Entity* e = Entities.List[id];
 	if (!e) return;
 	if (id != ENTITIES_SELF_ID) Entities_Remove(id);
+	DiscardLocation(id);
 
 	/* See comment about some servers in Classic_AddEntity */
 	if (!Classic_TabList_Get(id)) return;
@@ -198,9 +216,76 @@ void Protocol_RemoveEntity(EntityID id) {
 	Classic_TabList_Reset(id);
 }
 
+/* Servers may send multiple location updates for the same entity within one network tick */
+/*  (e.g. when lagging), which would each add interpolation states. So interpolated updates */
+/*  are instead merged together, with the merged update applied once per network tick. */
+static struct LocationUpdate pending_updates[ENTITIES_MAX_COUNT];
+static EntityID pending_ids[ENTITIES_MAX_COUNT];
+static cc_bool  pending_listed[ENTITIES_MAX_COUNT];
+static int pending_count;
+
+static void MergeLocation(struct LocationUpdate* dst, const struct LocationUpdate* src) {
+	cc_uint8 flags = src->Flags;
+
+	if (flags & LOCATIONUPDATE_POS) {
+		if (src->RelativePos && (dst->Flags & LOCATIONUPDATE_POS)) {
+			Vec3_AddBy(&dst->Pos, &src->Pos);
+		} else {
+			dst->Pos         = src->Pos;
+			dst->RelativePos = src->RelativePos;
+		}
+	}
+	if (flags & LOCATIONUPDATE_PITCH) dst->Pitch = src->Pitch;
+	if (flags & LOCATIONUPDATE_YAW)   dst->Yaw   = src->Yaw;
+	if (flags & LOCATIONUPDATE_ROTX)  dst->RotX  = src->RotX;
+	if (flags & LOCATIONUPDATE_ROTZ)  dst->RotZ  = src->RotZ;
+	dst->Flags |= flags;
+}
+
+static void ApplyLocation(EntityID id) {
+	struct LocationUpdate* update = &pending_updates[id];
+	struct Entity* e = Entities.List[id];
+
+	if (!update->Flags) return;
+	if (e) { e->VTABLE->SetLocation(e, update, true); }
+	update->Flags = 0;
+}
+
+static void DiscardLocation(EntityID id) { pending_updates[id].Flags = 0; }
+
 static void UpdateLocation(EntityID id, struct LocationUpdate* update, cc_bool interpolate) {
 	struct Entity* e = Entities.List[id];
-	if (e) { e->VTABLE->SetLocation(e, update, interpolate); }
+	if (!e) return;
+
+	/* Own position and non-interpolated updates (e.g. spawning) must be applied immediately */
+	if (id == ENTITIES_SELF_ID || !interpolate) {
+		ApplyLocation(id);
+		e->VTABLE->SetLocation(e, update, interpolate);
+		return;
+	}
+
+	MergeLocation(&pending_updates[id], update);
+	if (pending_listed[id]) return;
+	pending_listed[id] = true;
+	pending_ids[pending_count++] = id;
+}
+
+void Protocol_ApplyLocations(void) {
+	EntityID id;
+	int i;
+
+	for (i = 0; i < pending_count; i++) {
+		id = pending_ids[i];
+		pending_listed[id] = false;
+		ApplyLocation(id);
+	}
+	pending_count = 0;
+}
+
+static void ResetLocations(void) {
+	Mem_Set(pending_updates, 0, sizeof(pending_updates));
+	Mem_Set(pending_listed,  0, sizeof(pending_listed));
+	pending_count = 0;
 }
 
 static void UpdateUserType(struct HacksComp* hacks, cc_uint8 value) {
@@ -324,33 +409,83 @@ void Classic_SendChat(const cc_string* text, cc_bool partial) {
 	Server.SendData(data, 66);
 }
 
-void Classic_WritePosition(Vec3 pos, float yaw, float pitch) {
-	BlockID payload;
-	int x, y, z;
+static void Classic_MakePosition(struct SentPosition* s, Vec3 pos, float yaw, float pitch) {
+	s->payload = cpe_sendHeldBlock ? Inventory_SelectedBlock : ENTITIES_SELF_ID;
+	s->x = (int)(pos.X * 32);
+	s->y = (int)(pos.Y * 32) + 51;
+	s->z = (int)(pos.Z * 32);
+	s->yaw   = Math_Deg2Packed(yaw);
+	s->pitch = Math_Deg2Packed(pitch);
+}
 
+static void Classic_WriteTeleport(const struct SentPosition* s) {
 	cc_uint8* data = Server.WriteBuffer;
 	*data++ = OPCODE_ENTITY_TELEPORT;
 	{
-		payload = cpe_sendHeldBlock ? Inventory_SelectedBlock : ENTITIES_SELF_ID;
-		WriteBlock(data, payload);
-		x = (int)(pos.X * 32);
-		y = (int)(pos.Y * 32) + 51;
-		z = (int)(pos.Z * 32);
-
+		WriteBlock(data, s->payload);
 		if (cpe_extEntityPos) {
-			Stream_SetU32_BE(data, x); data += 4;
-			Stream_SetU32_BE(data, y); data += 4;
-			Stream_SetU32_BE(data, z); data += 4;
+			Stream_SetU32_BE(data, s->x); data += 4;
+			Stream_SetU32_BE(data, s->y); data += 4;
+			Stream_SetU32_BE(data, s->z); data += 4;
 		} else {
-			Stream_SetU16_BE(data, x); data += 2;
-			Stream_SetU16_BE(data, y); data += 2;
-			Stream_SetU16_BE(data, z); data += 2;
+			Stream_SetU16_BE(data, s->x); data += 2;
+			Stream_SetU16_BE(data, s->y); data += 2;
+			Stream_SetU16_BE(data, s->z); data += 2;
 		}
 
-		*data++ = Math_Deg2Packed(yaw);
-		*data++ = Math_Deg2Packed(pitch);
+		*data++ = s->yaw;
+		*data++ = s->pitch;
+	}
+	Server.WriteBuffer = data;
+
+	classic_lastPos   = *s;
+	classic_sentPos   = true;
+	classic_idleTicks = 0;
+}
+
+#define Classic_FitsDelta(d) ((d) >= -128 && (d) <= 127)
+/* Writes the change from the last sent position, using the same packets as servers send for relative movement */
+/*  (but with the payload of EntityTeleport instead of entity ID). Returns false when too large to fit in a delta. */
+static cc_bool Classic_WriteDelta(const struct SentPosition* s) {
+	int dx = s->x - classic_lastPos.x;
+	int dy = s->y - classic_lastPos.y;
+	int dz = s->z - classic_lastPos.z;
+	cc_bool moved   = dx || dy || dz;
+	cc_bool rotated = s->yaw != classic_lastPos.yaw || s->pitch != classic_lastPos.pitch;
+	cc_uint8* data;
+
+	if (!Classic_FitsDelta(dx) || !Classic_FitsDelta(dy) || !Classic_FitsDelta(dz)) return false;
+	data = Server.WriteBuffer;
+
+	if (moved && rotated) {
+		*data++ = OPCODE_RELPOS_AND_ORI_UPDATE;
+	} else if (moved) {
+		*data++ = OPCODE_RELPOS_UPDATE;
+	} else {
+		*data++ = OPCODE_ORI_UPDATE;
+	}
+	WriteBlock(data, s->payload);
+
+	if (moved) {
+		*data++ = (cc_uint8)dx;
+		*data++ = (cc_uint8)dy;
+		*data++ = (cc_uint8)dz;
+	}
+	if (rotated || !moved) {
+		*data++ = s->yaw;
+		*data++ = s->pitch;
 	}
 	Server.WriteBuffer = data;
+
+	classic_lastPos   = *s;
+	classic_idleTicks = 0;
+	return true;
+}
+
+void Classic_WritePosition(Vec3 pos, float yaw, float pitch) {
+	struct SentPosition s;
+	Classic_MakePosition(&s, pos, yaw, pitch);
+	Classic_WriteTeleport(&s);
 }
 
 void Classic_WriteSetBlock(int x, int y, int z, cc_bool place, BlockID block) {
@@ -414,40 +549,427 @@ static void MapState_Init(struct MapState* m) {
 	m->index  = 0;
 	m->blocks = NULL;
 	m->allocFailed = false;
+
+	m->pending    = NULL;
+	m->pendingLen = 0;
+	m->pendingCap = 0;
+}
+
+static void MapState_Free(struct MapState* m) {
+	World_FreeBlocks(m->blocks);
+	m->blocks  = NULL;
+	Mem_Free(m->pending);
+	m->pending = NULL;
+	m->pendingLen = 0;
+	m->pendingCap = 0;
 }
 
 static void FreeMapStates(void) {
-	Mem_Free(map.blocks);
-	map.blocks  = NULL;
+	MapDecoder_Stop();
+	MapState_Free(&map);
 #ifdef EXTENDED_BLOCKS
-	Mem_Free(map2.blocks);
-	map2.blocks = NULL;
+	MapState_Free(&map2);
 #endif
+	map_sections = false;
+}
+
+/* NOTE: Called on the map decoder thread, so the dialog is only shown in LevelFinalise */
+static void MapState_OutOfMemory(struct MapState* m) { m->allocFailed = true; }
+
+static void ShowMapOutOfMemory(void) {
+	Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+}
+
+/* Keeps the compressed data in the given spans, for decompressing in LevelFinalise */
+static void MapState_Defer(struct MapState* m, struct InflateSpan* spans, int count) {
+	cc_uint32 capacity, left;
+	cc_uint8* data;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		left = spans[i].Length;
+
+		if (m->pendingLen + left > m->pendingCap) {
+			capacity = max(m->pendingCap * 2, 64 * 1024);
+			data     = (cc_uint8*)Mem_TryRealloc(m->pending, capacity, 1);
+			if (!data) { MapState_OutOfMemory(m); return; }
+
+			m->pending    = data;
+			m->pendingCap = capacity;
+		}
+
+		Mem_Copy(m->pending + m->pendingLen, spans[i].Data, left);
+		m->pendingLen += left;
+	}
 }
 
-static void MapState_Read(struct MapState* m) {
+/* Decompresses the given run of compressed data straight into the blocks array */
+static cc_result MapState_Read(struct MapState* m, struct InflateSpan* spans, int count) {
 	cc_uint32 left, read;
 	cc_result res;
-	if (m->allocFailed) return;
+	if (m->allocFailed) return 0;
+	if (map_sections) { MapState_Defer(m, spans, count); return 0; }
 
 	if (!m->blocks) {
-		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
+		m->blocks = World_TryAllocBlocks(map_volume);
 		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return;
+		if (!m->blocks && m == &map) {
+			/* Too large to fit in memory as a flat array, so fallback to sections instead */
+			Platform_LogConst("Map too large for flat arrays, loading into sections instead");
+			map_sections = true;
+			MapState_Defer(m, spans, count); return 0;
+		} else if (!m->blocks) {
+			MapState_OutOfMemory(m); return 0;
 		}
 	}
 
 	left = map_volume - m->index;
-	res  = m->stream.Read(&m->stream, &m->blocks[m->index], left, &read);
+	if (!left) return 0;
+	res  = Inflate_ProcessSpans(&m->inflateState, spans, count, &m->blocks[m->index], left, &read);
 
-	if (res) DisconnectInvalidMap(res);
 	m->index += read;
+	return res;
+}
+
+/* Decompresses the deferred data of the given map state into the world's sections */
+static cc_result MapState_ReadSections(struct MapState* m, cc_bool upper, BlockRaw* raw, BlockID* blocks) {
+	int x, y, z, width = World.Width;
+	cc_result res;
+	map_part.Meta.Mem.Cur    = m->pending;
+	map_part.Meta.Mem.Base   = m->pending;
+	map_part.Meta.Mem.Left   = m->pendingLen;
+	map_part.Meta.Mem.Length = m->pendingLen;
+
+	for (y = 0; y < World.Height; y++) {
+		for (z = 0; z < World.Length; z++) {
+			if ((res = Stream_Read(&m->stream, raw, width))) return res;
+
+			if (upper) {
+				/* upper 8 bits are almost always 0 */
+				for (x = 0; x < width && !raw[x]; x++) { }
+				if (x == width) continue;
+
+				World_GetSectionsRow(0, y, z, blocks, width);
+				for (x = 0; x < width; x++) { blocks[x] |= (BlockID)(raw[x] << 8); }
+			} else {
+				for (x = 0; x < width; x++) { blocks[x] = raw[x]; }
+			}
+
+			World_SetSectionsRow(0, y, z, blocks, width);
+			/* ran out of memory */
+			if (!World.Sections) return 0;
+		}
+	}
+	return 0;
+}
+
+static cc_result LoadMapSections(int width, int height, int length) {
+	BlockRaw* raw;
+	BlockID* blocks;
+	cc_result res;
+
+	if (!World_InitSections(width, height, length)) {
+		World_OutOfMemory(); return 0;
+	}
+	raw    = (BlockRaw*)Mem_Alloc(width, 1,               "map row");
+	blocks = (BlockID*) Mem_Alloc(width, sizeof(BlockID), "map row blocks");
+
+	res = MapState_ReadSections(&map, false, raw, blocks);
+#ifdef EXTENDED_BLOCKS
+	if (!res && cpe_extBlocks && map2.pendingLen && World.Sections) {
+		res = MapState_ReadSections(&map2, true, raw, blocks);
+	}
+#endif
+
+	Mem_Free(raw);
+	Mem_Free(blocks);
+	return res;
+}
+
+/* Reads the GZIP header and map volume at the start of the map data from the given packet */
+static cc_result MapState_DecodeHeader(struct InflateSpan* span) {
+	cc_uint32 left, read;
+	cc_result res;
+
+	map_part.Meta.Mem.Cur    = span->Data;
+	map_part.Meta.Mem.Base   = span->Data;
+	map_part.Meta.Mem.Left   = span->Length;
+	map_part.Meta.Mem.Length = span->Length;
+
+	if (!map_gzHeader.done) {
+		res = GZipHeader_Read(&map_part, &map_gzHeader);
+		if (res && res != ERR_END_OF_STREAM) return res;
+	}
+
+	if (map_gzHeader.done && map_sizeIndex < MAP_SIZE_LEN) {
+		left = MAP_SIZE_LEN - map_sizeIndex;
+		res  = map.stream.Read(&map.stream, &map_size[map_sizeIndex], left, &read); 
+
+		if (res) return res;
+		map_sizeIndex += read;
+	}
+	if (map_sizeIndex == MAP_SIZE_LEN && !map_volume) map_volume = Stream_GetU32_BE(map_size);
+
+	/* Any compressed data left over is either still in map_part, or buffered in map's inflater */
+	span->Data   = map_part.Meta.Mem.Cur;
+	span->Length = map_part.Meta.Mem.Left;
+	return 0;
+}
+
+#ifdef EXTENDED_BLOCKS
+#define MapState_For(value) ((cpe_extBlocks && (value)) ? &map2 : &map)
+#else
+#define MapState_For(value) (&map)
+#endif
+
+/* Decompresses the data from consecutive LevelDataChunk packets into the map state(s) */
+/* Consecutive packets for the same map state are decompressed together in one run */
+static cc_result MapState_DecodeSpans(struct InflateSpan* spans, const cc_uint8* values, int count) {
+	struct MapState* m;
+	cc_result res;
+	int i, j;
+
+	for (i = 0; i < count; i = j) {
+		if (map_sizeIndex < MAP_SIZE_LEN) {
+			if ((res = MapState_DecodeHeader(&spans[i]))) return res;
+			if (map_sizeIndex < MAP_SIZE_LEN) { j = i + 1; continue; }
+		}
+
+		m = MapState_For(values[i]);
+		for (j = i + 1; j < count && MapState_For(values[j]) == m; j++) { }
+		if ((res = MapState_Read(m, &spans[i], j - i))) return res;
+	}
+	return 0;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Map decoder-------------------------------------------------------*
+*#########################################################################################################################*/
+/* First error that occurred while decompressing the map */
+static volatile cc_result map_result;
+
+#ifdef CC_BUILD_WEB
+/* No threading support, so just decompress each chunk as it is received */
+static void MapDecoder_Start(void) { map_result = 0; }
+static void MapDecoder_Stop(void)  { }
+static cc_result MapDecoder_Finish(void) { return map_result; }
+
+static void MapDecoder_Submit(cc_uint8* data, int length, cc_uint8 value) {
+	struct InflateSpan span;
+	span.Data   = data;
+	span.Length = length;
+	if (!map_result) map_result = MapState_DecodeSpans(&span, &value, 1);
+}
+#else
+/* Decompressing is done on separate threads, so that decompressing overlaps with */
+/*  receiving the rest of the map, and the loading screen still renders smoothly */
+/* With extended blocks, the lower and upper 8 bits of blocks are two independent DEFLATE */
+/*  streams, so each gets its own thread and is decompressed at the same time as the other */
+#define MAP_QUEUE_SIZE 256 /* must be a power of two */
+struct MapChunk { cc_uint8 data[1024]; int length; cc_uint8 value; };
+
+/* Single producer (game thread), single consumer (decoder thread) queue of chunks */
+/* The game thread only ever advances tail, and the decoder thread only ever advances head */
+struct MapDecoder {
+	struct MapChunk* queue;
+	int head, tail;
+	cc_bool finished, cancelled;
+	void* mutex;
+	void* decoderWaitable;  /* signalled when a chunk is submitted or no more will be */
+	void* producerWaitable; /* signalled when the decoder frees up a chunk */
+	void* thread;
+	/* Map state all chunks are decompressed into, or NULL to read the map header and pick the state per chunk */
+	struct MapState* state;
+	/* Compressed data of all the chunks queued up, which is then decompressed in one batch */
+	struct InflateSpan spans[MAP_QUEUE_SIZE];
+	cc_uint8 values[MAP_QUEUE_SIZE];
+};
+static struct MapDecoder map_lower;
+#ifdef EXTENDED_BLOCKS
+static struct MapDecoder map_upper;
+/* Whether chunks for map2 are being decompressed by map_upper instead of map_lower */
+static cc_bool map_parallel;
+#endif
+
+static void MapDecoder_Run(struct MapDecoder* d) {
+	struct MapChunk* chunk;
+	cc_bool finished, cancelled;
+	cc_result res;
+	int i, count;
+
+	for (;;) {
+		Mutex_Lock(d->mutex);
+		{
+			count     = d->tail - d->head;
+			finished  = d->finished;
+			cancelled = d->cancelled;
+		}
+		Mutex_Unlock(d->mutex);
+
+		if (cancelled) return;
+		if (!count) {
+			if (finished) return;
+			Waitable_Wait(d->decoderWaitable);
+			continue;
+		}
+
+		/* The chunks are only ever modified by the game thread once head has moved past them */
+		for (i = 0; i < count; i++) {
+			chunk = &d->queue[(d->head + i) & (MAP_QUEUE_SIZE - 1)];
+			d->spans[i].Data   = chunk->data;
+			d->spans[i].Length = chunk->length;
+			d->values[i]       = chunk->value;
+		}
+
+		if (!map_result) {
+			if (d->state) {
+				res = MapState_Read(d->state, d->spans, count);
+			} else {
+				res = MapState_DecodeSpans(d->spans, d->values, count);
+			}
+			if (res) map_result = res;
+		}
+
+		Mutex_Lock(d->mutex);
+		{
+			d->head += count;
+		}
+		Mutex_Unlock(d->mutex);
+		Waitable_Signal(d->producerWaitable);
+	}
+}
+
+static void MapDecoder_RunLower(void) { MapDecoder_Run(&map_lower); }
+#ifdef EXTENDED_BLOCKS
+static void MapDecoder_RunUpper(void) { MapDecoder_Run(&map_upper); }
+#endif
+
+static void MapDecoder_Init(struct MapDecoder* d, struct MapState* state, Thread_StartFunc func) {
+	d->head  = 0;
+	d->tail  = 0;
+	d->state = state;
+	d->finished  = false;
+	d->cancelled = false;
+
+	if (!d->queue) {
+		d->queue = (struct MapChunk*)Mem_Alloc(MAP_QUEUE_SIZE, sizeof(struct MapChunk), "map chunks");
+		d->mutex            = Mutex_Create();
+		d->decoderWaitable  = Waitable_Create();
+		d->producerWaitable = Waitable_Create();
+	}
+	d->thread = Thread_Start(func);
+}
+
+static void MapDecoder_Start(void) {
+	map_result = 0;
+	MapDecoder_Init(&map_lower, NULL, MapDecoder_RunLower);
+#ifdef EXTENDED_BLOCKS
+	map_parallel = false;
+	if (cpe_extBlocks) MapDecoder_Init(&map_upper, &map2, MapDecoder_RunUpper);
+#endif
+}
+
+/* Waits for the decoder thread to exit, after telling it to stop */
+static void MapDecoder_Join(struct MapDecoder* d, cc_bool cancel) {
+	if (!d->thread) return;
+
+	Mutex_Lock(d->mutex);
+	{
+		d->finished  = true;
+		d->cancelled = cancel;
+	}
+	Mutex_Unlock(d->mutex);
+
+	Waitable_Signal(d->decoderWaitable);
+	Thread_Join(d->thread);
+	d->thread = NULL;
+}
+
+static void MapDecoder_Stop(void) { 
+	MapDecoder_Join(&map_lower, true);
+#ifdef EXTENDED_BLOCKS
+	MapDecoder_Join(&map_upper, true);
+#endif
+}
+
+static cc_result MapDecoder_Finish(void) {
+	MapDecoder_Join(&map_lower, false);
+#ifdef EXTENDED_BLOCKS
+	MapDecoder_Join(&map_upper, false);
+#endif
+	return map_result;
+}
+
+/* Waits until the decoder thread has decompressed all the chunks submitted to it */
+static void MapDecoder_Drain(struct MapDecoder* d) {
+	int head;
+
+	for (;;) {
+		Mutex_Lock(d->mutex);
+		{
+			head = d->head;
+		}
+		Mutex_Unlock(d->mutex);
+
+		if (head == d->tail) return;
+		Waitable_Wait(d->producerWaitable);
+	}
+}
+
+static void MapDecoder_Push(struct MapDecoder* d, cc_uint8* data, int length, cc_uint8 value) {
+	struct MapChunk* chunk;
+	int head;
+
+	for (;;) {
+		Mutex_Lock(d->mutex);
+		{
+			head = d->head;
+		}
+		Mutex_Unlock(d->mutex);
+
+		if (d->tail - head < MAP_QUEUE_SIZE) break;
+		/* Received chunks faster than they can be decompressed */
+		Waitable_Wait(d->producerWaitable);
+	}
+
+	chunk = &d->queue[d->tail & (MAP_QUEUE_SIZE - 1)];
+	Mem_Copy(chunk->data, data, length);
+	chunk->length = length;
+	chunk->value  = value;
+
+	Mutex_Lock(d->mutex);
+	{
+		d->tail++;
+	}
+	Mutex_Unlock(d->mutex);
+	Waitable_Signal(d->decoderWaitable);
+}
+
+#ifdef EXTENDED_BLOCKS
+/* map2 can only be decompressed separately once the map volume is known, and whether */
+/*  the map is being loaded into sections has been decided when decompressing map */
+static cc_bool MapDecoder_CanSplit(void) {
+	if (map_parallel) return true;
+	MapDecoder_Drain(&map_lower);
+
+	map_parallel = map_volume && (map.blocks || map_sections || map.allocFailed);
+	return map_parallel;
 }
+#endif
+
+static void MapDecoder_Submit(cc_uint8* data, int length, cc_uint8 value) {
+#ifdef EXTENDED_BLOCKS
+	if (cpe_extBlocks && value && MapDecoder_CanSplit()) {
+		MapDecoder_Push(&map_upper, data, length, value); return;
+	}
+#endif
+	MapDecoder_Push(&map_lower, data, length, value);
+}
+#endif
 
 static void Classic_StartLoading(void) {
+	FreeMapStates();
 	World_NewMap();
 	Stream_ReadonlyMemory(&map_part, NULL, 0);
 
@@ -460,11 +982,13 @@ static void Classic_StartLoading(void) {
 	map_sizeIndex    = 0;
 	map_receiveBeg   = Stopwatch_Measure();
 	map_volume       = 0;
+	map_sections     = false;
 
 	MapState_Init(&map);
 #ifdef EXTENDED_BLOCKS
 	MapState_Init(&map2);
 #endif
+	MapDecoder_Start();
 }
 
 static void Classic_LevelInit(cc_uint8* data) {
@@ -483,51 +1007,18 @@ static void Classic_LevelInit(cc_uint8* data) {
 static void Classic_LevelDataChunk(cc_uint8* data) {
 	int usedLength;
 	float progress;
-	cc_uint32 left, read;
 	cc_uint8 value;
-	cc_result res;
 
 	/* Workaround for some servers that send LevelDataChunk before LevelInit due to their async sending behaviour */
 	if (!map_begunLoading) Classic_StartLoading();
 	usedLength = Stream_GetU16_BE(data); data += 2;
+	usedLength = min(usedLength, 1024);
+	value      = data[1024]; /* progress in original classic, but we ignore it */
 
-	map_part.Meta.Mem.Cur    = data;
-	map_part.Meta.Mem.Base   = data;
-	map_part.Meta.Mem.Left   = usedLength;
-	map_part.Meta.Mem.Length = usedLength;
-
-	data += 1024;
-	value = *data; /* progress in original classic, but we ignore it */
-
-	if (!map_gzHeader.done) {
-		res = GZipHeader_Read(&map_part, &map_gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
-	}
-
-	if (map_gzHeader.done) {
-		if (map_sizeIndex < MAP_SIZE_LEN) {
-			left = MAP_SIZE_LEN - map_sizeIndex;
-			res  = map.stream.Read(&map.stream, &map_size[map_sizeIndex], left, &read); 
-
-			if (res) { DisconnectInvalidMap(res); return; }
-			map_sizeIndex += read;
-		}
-
-		if (map_sizeIndex == MAP_SIZE_LEN) {
-			if (!map_volume) map_volume = Stream_GetU32_BE(map_size);
-
-#ifndef EXTENDED_BLOCKS
-			MapState_Read(&map);
-#else
-			if (cpe_extBlocks && value) {
-				MapState_Read(&map2);
-			} else {
-				MapState_Read(&map);
-			}
-#endif
-		}
-	}
+	MapDecoder_Submit(data, usedLength, value);
+	if (map_result) { DisconnectInvalidMap(map_result); return; }
 
+	/* NOTE: Decoder thread may be updating these at the same time, but only for progress display */
 	progress = !map.blocks ? 0.0f : (float)map.index / map_volume;
 	Event_RaiseFloat(&WorldEvents.Loading, progress);
 }
@@ -535,6 +1026,7 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 static void Classic_LevelFinalise(cc_uint8* data) {
 	int width, height, length;
 	cc_uint64 end;
+	cc_result res;
 	int delta;
 
 	end   = Stopwatch_Measure();
@@ -543,8 +1035,12 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	map_begunLoading = false;
 	WoM_CheckSendWomID();
 
+	/* Wait for the rest of the received chunks to be decompressed */
+	if ((res = MapDecoder_Finish())) { DisconnectInvalidMap(res); return; }
+
+	if (map.allocFailed) ShowMapOutOfMemory();
 #ifdef EXTENDED_BLOCKS
-	if (map2.allocFailed) FreeMapStates();
+	if (map2.allocFailed) { ShowMapOutOfMemory(); FreeMapStates(); }
 #endif
 
 	width  = Stream_GetU16_BE(data + 0);
@@ -556,6 +1052,15 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 		Chat_AddRaw("   &cBlocks array size does not match volume of map");
 		FreeMapStates();
 	}
+
+	if (map_sections) {
+		if (!map.allocFailed && (res = LoadMapSections(width, height, length))) {
+			DisconnectInvalidMap(res); return;
+		}
+		FreeMapStates();
+		World_SetNewMap(NULL, width, height, length);
+		return;
+	}
 	
 #ifdef EXTENDED_BLOCKS
 	/* defer allocation of second map array if possible */
@@ -719,6 +1224,10 @@ static void Classic_ReadAbsoluteLocation(cc_uint8* data, EntityID id, cc_bool in
 static void Classic_Reset(void) {
 	map_begunLoading = false;
 	classic_receivedFirstPos = false;
+	classic_sentPos   = false;
+	classic_idleTicks = 0;
+	/* Heartbeat is in milliseconds, position is sent at most every 50 milliseconds */
+	classic_heartbeatTicks = Options_GetInt(OPT_POSITION_HEARTBEAT, 0, 60000, 1000) / 50;
 
 	Net_Set(OPCODE_HANDSHAKE, Classic_Handshake, 131);
 	Net_Set(OPCODE_PING, Classic_Ping, 1);
@@ -739,26 +1248,42 @@ static void Classic_Reset(void) {
 	Net_Set(OPCODE_SET_PERMISSION, Classic_SetPermission, 2);
 }
 
+static cc_bool Classic_SameAsSent(const struct SentPosition* s) {
+	const struct SentPosition* l = &classic_lastPos;
+	return s->x == l->x && s->y == l->y && s->z == l->z && s->payload == l->payload
+		&& s->yaw == l->yaw && s->pitch == l->pitch;
+}
+
 static void Classic_Tick(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	struct Entity* e      = &LocalPlayer_Instance.Base;
+	struct SentPosition s;
 	if (!classic_receivedFirstPos) return;
+
 	/* Report end position of each physics tick, rather than current position */
 	/*  (otherwise can miss landing on a block then jumping off of it again) */
-	Classic_WritePosition(p->Interp.Next.Pos, e->Yaw, e->Pitch);
+	Classic_MakePosition(&s, p->Interp.Next.Pos, e->Yaw, e->Pitch);
+
+	/* Unchanged position is only resent occasionally, so the server still knows the player is there */
+	if (classic_sentPos && Classic_SameAsSent(&s)) {
+		if (++classic_idleTicks < classic_heartbeatTicks) return;
+		Classic_WriteTeleport(&s);
+	} else if (!classic_sentPos || !cpe_clientRelPos || !Classic_WriteDelta(&s)) {
+		Classic_WriteTeleport(&s);
+	}
 }
 
 
 /*########################################################################################################################*
 *------------------------------------------------------CPE protocol-------------------------------------------------------*
 *#########################################################################################################################*/
-static const char* cpe_clientExtensions[35] = {
+static const char* cpe_clientExtensions[36] = {
 	"ClickDistance", "CustomBlocks", "HeldBlock", "EmoteFix", "TextHotKey", "ExtPlayerList",
 	"EnvColors", "SelectionCuboid", "BlockPermissions", "ChangeModel", "EnvMapAppearance",
 	"EnvWeatherType", "MessageTypes", "HackControl", "PlayerClick", "FullCP437", "LongerMessages",
 	"BlockDefinitions", "BlockDefinitionsExt", "BulkBlockUpdate", "TextColors", "EnvMapAspect",
 	"EntityProperty", "ExtEntityPositions", "TwoWayPing", "InventoryOrder", "InstantMOTD", "FastMap", "SetHotbar",
-	"SetSpawnpoint", "VelocityControl", "CustomParticles", "CustomModels",
+	"SetSpawnpoint", "VelocityControl", "CustomParticles", "CustomModels", "ClientRelPositions",
 	/* NOTE: These must be placed last for when EXTENDED_TEXTURES or EXTENDED_BLOCKS are not defined */
 	"ExtendedTextures", "ExtendedBlocks"
 };
@@ -885,63 +1410,57 @@ static void CPE_ExtInfo(cc_uint8* data) {
 	CPE_SendCpeExtInfoReply();
 }
 
-static void CPE_ExtEntry(cc_uint8* data) {
-	cc_string ext = UNSAFE_GetString(data);
-	int version   = data[67];
-	Platform_Log2("cpe ext: %s, %i", &ext, &version);
-
-	cpe_serverExtensionsCount--;
-	CPE_SendCpeExtInfoReply();	
-
-	/* update support state */
-	if (String_CaselessEqualsConst(&ext, "HeldBlock")) {
+static void CPE_ApplyExtEntry(const cc_string* ext, int version) {
+	if (String_CaselessEqualsConst(ext, "HeldBlock")) {
 		cpe_sendHeldBlock = true;
-	} else if (String_CaselessEqualsConst(&ext, "MessageTypes")) {
+	} else if (String_CaselessEqualsConst(ext, "MessageTypes")) {
 		cpe_useMessageTypes = true;
-	} else if (String_CaselessEqualsConst(&ext, "ExtPlayerList")) {
+	} else if (String_CaselessEqualsConst(ext, "ExtPlayerList")) {
 		Server.SupportsExtPlayerList = true;
-	} else if (String_CaselessEqualsConst(&ext, "BlockPermissions")) {
+	} else if (String_CaselessEqualsConst(ext, "BlockPermissions")) {
 		cpe_blockPerms = true;
-	} else if (String_CaselessEqualsConst(&ext, "PlayerClick")) {
+	} else if (String_CaselessEqualsConst(ext, "PlayerClick")) {
 		Server.SupportsPlayerClick = true;
-	} else if (String_CaselessEqualsConst(&ext, "EnvMapAppearance")) {
+	} else if (String_CaselessEqualsConst(ext, "EnvMapAppearance")) {
 		cpe_envMapVer = version;
 		if (version == 1) return;
 		Protocol.Sizes[OPCODE_ENV_SET_MAP_APPEARANCE] += 4;
-	} else if (String_CaselessEqualsConst(&ext, "LongerMessages")) {
+	} else if (String_CaselessEqualsConst(ext, "LongerMessages")) {
 		Server.SupportsPartialMessages = true;
-	} else if (String_CaselessEqualsConst(&ext, "FullCP437")) {
+	} else if (String_CaselessEqualsConst(ext, "FullCP437")) {
 		Server.SupportsFullCP437 = true;
-	} else if (String_CaselessEqualsConst(&ext, "BlockDefinitionsExt")) {
+	} else if (String_CaselessEqualsConst(ext, "BlockDefinitionsExt")) {
 		cpe_blockDefsExtVer = version;
 		if (version == 1) return;
 		Protocol.Sizes[OPCODE_DEFINE_BLOCK_EXT] += 3;
-	} else if (String_CaselessEqualsConst(&ext, "ExtEntityPositions")) {
+	} else if (String_CaselessEqualsConst(ext, "ExtEntityPositions")) {
 		Protocol.Sizes[OPCODE_ENTITY_TELEPORT] += 6;
 		Protocol.Sizes[OPCODE_ADD_ENTITY]      += 6;
 		Protocol.Sizes[OPCODE_EXT_ADD_ENTITY2] += 6;
 		Protocol.Sizes[OPCODE_SET_SPAWNPOINT]  += 6;
 		cpe_extEntityPos = true;
-	} else if (String_CaselessEqualsConst(&ext, "TwoWayPing")) {
+	} else if (String_CaselessEqualsConst(ext, "TwoWayPing")) {
 		cpe_twoWayPing = true;
-	} else if (String_CaselessEqualsConst(&ext, "FastMap")) {
+	} else if (String_CaselessEqualsConst(ext, "ClientRelPositions")) {
+		cpe_clientRelPos = true;
+	} else if (String_CaselessEqualsConst(ext, "FastMap")) {
 		Protocol.Sizes[OPCODE_LEVEL_BEGIN] += 4;
 		cpe_fastMap = true;
-	} else if (String_CaselessEqualsConst(&ext, "CustomModels")) {
+	} else if (String_CaselessEqualsConst(ext, "CustomModels")) {
 		cpe_customModelsVer = min(2, version);
 		if (version == 2) {
 			Protocol.Sizes[OPCODE_DEFINE_MODEL_PART] = 167;
 		}
 	}
 #ifdef EXTENDED_TEXTURES
-	else if (String_CaselessEqualsConst(&ext, "ExtendedTextures")) {
+	else if (String_CaselessEqualsConst(ext, "ExtendedTextures")) {
 		Protocol.Sizes[OPCODE_DEFINE_BLOCK]     += 3;
 		Protocol.Sizes[OPCODE_DEFINE_BLOCK_EXT] += 6;
 		cpe_extTextures = true;
 	}
 #endif
 #ifdef EXTENDED_BLOCKS
-	else if (String_CaselessEqualsConst(&ext, "ExtendedBlocks")) {
+	else if (String_CaselessEqualsConst(ext, "ExtendedBlocks")) {
 		if (!Game_AllowCustomBlocks) return;
 		cpe_extBlocks = true;
 
@@ -958,6 +1477,19 @@ static void CPE_ExtEntry(cc_uint8* data) {
 #endif
 }
 
+static void CPE_ExtEntry(cc_uint8* data) {
+	cc_string ext = UNSAFE_GetString(data);
+	int version   = data[67];
+	Platform_Log2("cpe ext: %s, %i", &ext, &version);
+
+	/* update support state */
+	/* NOTE: Packet sizes must be updated before sending the reply, as packets are framed */
+	/*  on the network thread and the server may use the new formats as soon as it gets the reply */
+	CPE_ApplyExtEntry(&ext, version);
+	cpe_serverExtensionsCount--;
+	CPE_SendCpeExtInfoReply();
+}
+
 static void CPE_SetClickDistance(cc_uint8* data) {
 	LocalPlayer_Instance.ReachDistance = Stream_GetU16_BE(data) / 32.0f;
 }
@@ -1187,7 +1719,7 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	for (i = 0; i < count; i++) {
 		index = indices[i];
 		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
+		World_UnpackLinear(index, x, y, z);
 
 #ifdef EXTENDED_BLOCKS
 		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
@@ -1294,7 +1826,7 @@ static void CPE_SetEntityProperty(cc_uint8* data) {
 	default:
 		return;
 	}
-	e->VTABLE->SetLocation(e, &update, true);
+	UpdateLocation(id, &update, true);
 }
 
 static void CPE_TwoWayPing(cc_uint8* data) {
@@ -1532,7 +2064,7 @@ static void CPE_Reset(void) {
 	cpe_sendHeldBlock = false; cpe_useMessageTypes = false;
 	cpe_envMapVer = 2; cpe_blockDefsExtVer = 2; cpe_customModelsVer = 2;
 	cpe_needD3Fix = false; cpe_extEntityPos = false; cpe_twoWayPing = false; 
-	cpe_extTextures = false; cpe_fastMap = false; cpe_extBlocks = false;
+	cpe_extTextures = false; cpe_fastMap = false; cpe_extBlocks = false; cpe_clientRelPos = false;
 	Game_UseCPEBlocks = false; cpe_blockPerms = false;
 	if (!Game_UseCPE) return;
 
@@ -1720,10 +2252,144 @@ static void BlockDefs_Reset(void) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Packet profiler-----------------------------------------------------*
+*#########################################################################################################################*/
+static struct PacketStats {
+	cc_uint32 count, bytes;
+	cc_uint64 elapsed; /* Total microseconds spent in handler */
+} profiler_stats[256];
+static cc_bool profiler_enabled;
+static cc_uint64 profiler_beg; /* When statistics were last reset */
+
+static struct Stream profiler_trace;
+static cc_bool profiler_tracing;
+static cc_result profiler_traceResult;
+static cc_uint64 profiler_traceLast; /* When the last packet was written to the trace */
+static cc_uint32 profiler_traceUsed;
+static cc_uint8  profiler_traceBuffer[64 * 1024];
+
+static void PacketProfiler_FlushTrace(void) {
+	cc_result res;
+	if (!profiler_traceUsed) return;
+	/* Buffered packets are just discarded once writing has failed */
+	if (profiler_traceResult) { profiler_traceUsed = 0; return; }
+
+	res = Stream_Write(&profiler_trace, profiler_traceBuffer, profiler_traceUsed);
+	profiler_traceUsed = 0;
+	if (!res) return;
+
+	profiler_traceResult = res;
+	Logger_SysWarn(res, "writing packet trace");
+}
+
+static void PacketProfiler_Trace(const cc_uint8* data, int size, cc_uint64 now) {
+	cc_uint8* dst;
+	/* No point tracing any more packets once writing the trace has failed */
+	if (profiler_traceResult) return;
+
+	if (profiler_traceUsed + PACKET_TRACE_HEADER_SIZE + size > sizeof(profiler_traceBuffer)) {
+		PacketProfiler_FlushTrace();
+	}
+
+	dst = profiler_traceBuffer + profiler_traceUsed;
+	Stream_SetU32_BE(dst + 0, (cc_uint32)Stopwatch_ElapsedMicroseconds(profiler_traceLast, now));
+	Stream_SetU16_BE(dst + 4, size);
+	Mem_Copy(dst + PACKET_TRACE_HEADER_SIZE, data, size);
+
+	profiler_traceUsed += PACKET_TRACE_HEADER_SIZE + size;
+	profiler_traceLast  = now;
+}
+
+void Protocol_HandlePacket(cc_uint8* data) {
+	cc_uint8 opcode = data[0];
+	int size        = Protocol.Sizes[opcode];
+	cc_uint64 beg, end;
+
+	if (!profiler_enabled) { Protocol.Handlers[opcode](data + 1); return; }
+	beg = Stopwatch_Measure();
+	/* NOTE: Packet size must be retrieved before calling handler, since handler might change it */
+	if (profiler_tracing) PacketProfiler_Trace(data, size, beg);
+
+	Protocol.Handlers[opcode](data + 1); /* skip opcode */
+	end = Stopwatch_Measure();
+
+	profiler_stats[opcode].count++;
+	profiler_stats[opcode].bytes   += size;
+	profiler_stats[opcode].elapsed += Stopwatch_ElapsedMicroseconds(beg, end);
+}
+
+void PacketProfiler_SetEnabled(cc_bool enabled) {
+	if (!enabled) PacketProfiler_StopTrace();
+	profiler_enabled = enabled;
+	profiler_beg     = Stopwatch_Measure();
+	Mem_Set(profiler_stats, 0, sizeof(profiler_stats));
+}
+
+cc_bool PacketProfiler_IsEnabled(void) { return profiler_enabled; }
+
+void PacketProfiler_PrintTop(int count) {
+	cc_bool shown[256] = { 0 };
+	float secs, perSec, msPerSec;
+	int i, j, best, bytesPerSec;
+	cc_uint8 opcode;
+
+	secs = Stopwatch_ElapsedMicroseconds(profiler_beg, Stopwatch_Measure()) / (1000.0f * 1000.0f);
+	if (secs <= 0.0f) return;
+
+	for (i = 0; i < count; i++) {
+		best = -1;
+		for (j = 0; j < 256; j++) {
+			if (shown[j] || !profiler_stats[j].count) continue;
+			if (best == -1 || profiler_stats[j].elapsed > profiler_stats[best].elapsed) best = j;
+		}
+		if (best == -1) return;
+
+		shown[best] = true;
+		opcode      = (cc_uint8)best;
+		perSec      = profiler_stats[best].count / secs;
+		bytesPerSec = (int)(profiler_stats[best].bytes / secs);
+		msPerSec    = profiler_stats[best].elapsed / 1000.0f / secs;
+		Chat_Add4("&e  Opcode %b: &f%f1 packets/s, %i bytes/s, %f3 ms/s", 
+				&opcode, &perSec, &bytesPerSec, &msPerSec);
+	}
+}
+
+cc_result PacketProfiler_StartTrace(const cc_string* path) {
+	static const cc_uint8 header[5] = { 'C','C','P','T', PACKET_TRACE_VERSION };
+	cc_result res;
+
+	PacketProfiler_StopTrace();
+	res = Stream_CreateFile(&profiler_trace, path);
+	if (res) return res;
+
+	res = Stream_Write(&profiler_trace, header, sizeof(header));
+	if (res) { profiler_trace.Close(&profiler_trace); return res; }
+
+	if (!profiler_enabled) PacketProfiler_SetEnabled(true);
+	profiler_tracing     = true;
+	profiler_traceResult = 0;
+	profiler_traceUsed   = 0;
+	profiler_traceLast   = Stopwatch_Measure();
+	return 0;
+}
+
+void PacketProfiler_StopTrace(void) {
+	cc_result res;
+	if (!profiler_tracing) return;
+
+	PacketProfiler_FlushTrace();
+	profiler_tracing = false;
+	res = profiler_trace.Close(&profiler_trace);
+	if (res) Logger_SysWarn(res, "closing packet trace");
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------Public handlers-----------------------------------------------------*
 *#########################################################################################################################*/
 static void Protocol_Reset(void) {
+	ResetLocations();
 	Classic_Reset();
 	CPE_Reset();
 	BlockDefs_Reset();
@@ -1742,14 +2408,20 @@ static void OnInit(void) {
 }
 
 static void OnReset(void) {
+	PacketProfiler_StopTrace();
 	if (Server.IsSinglePlayer) return;
 	Mem_Set(&Protocol, 0, sizeof(Protocol));
 	Protocol_Reset();
 	FreeMapStates();
 }
 
+static void OnFree(void) {
+	PacketProfiler_StopTrace();
+	FreeMapStates();
+}
+
 struct IGameComponent Protocol_Component = {
 	OnInit,  /* Init  */
-	NULL,    /* Free  */
+	OnFree,  /* Free  */
 	OnReset, /* Reset */
 };
@@ -56,6 +56,23 @@ extern struct IGameComponent Protocol_Component;
 
 void Protocol_RemoveEntity(EntityID id);
 void Protocol_Tick(void);
+/* Applies the location updates for each entity that have been merged together since the last call */
+void Protocol_ApplyLocations(void);
+/* Calls the handler for the given packet, recording statistics about it if profiling is enabled */
+void Protocol_HandlePacket(cc_uint8* data);
+
+/* Packet trace files start with "CCPT" and a version byte, followed by each received packet as: */
+/*  microseconds since previous packet (u32 BE), packet length (u16 BE), raw packet data (including opcode) */
+#define PACKET_TRACE_VERSION 1
+#define PACKET_TRACE_HEADER_SIZE 6
+/* Enables or disables recording per-opcode statistics of handled packets, resetting the statistics */
+void PacketProfiler_SetEnabled(cc_bool enabled);
+cc_bool PacketProfiler_IsEnabled(void);
+/* Prints the given number of opcodes which have taken the most handler time to chat */
+void PacketProfiler_PrintTop(int count);
+/* Begins writing all handled packets to the given file (also enabling profiling) */
+cc_result PacketProfiler_StartTrace(const cc_string* path);
+void PacketProfiler_StopTrace(void);
 
 extern cc_bool cpe_needD3Fix;
 void Classic_SendChat(const cc_string* text, cc_bool partial);
@@ -37,8 +37,6 @@ static struct FileResource {
 
 static struct ResourceTexture {
 	const char* filename;
-	/* zip data */
-	cc_uint32 size, offset, crc32;
 } textureResources[] = {
 	/* classic jar files */
 	{ "char.png"     }, { "clouds.png"      }, { "default.png" }, { "particles.png" },
@@ -162,32 +160,28 @@ static void Resources_CheckSounds(void) {
 	allSoundsExist = true;
 }
 
-static cc_bool Resources_SelectZipEntry(const cc_string* path) {
-	cc_string name = *path;
-	Utils_UNSAFE_GetFilename(&name);
-
-	if (Resources_FindTex(&name)) texturesFound++;
-	return false;
-}
-
 static void Resources_CheckTextures(void) {
 	static const cc_string path = String_FromConst("texpacks/default.zip");
+	static struct ZipIndex index;
 	struct Stream stream;
-	struct ZipState state;
+	cc_string name;
 	cc_result res;
+	int i;
 
-	res = Stream_OpenFile(&stream, &path);
+	res = Stream_OpenMapped(&stream, &path);
 	if (res == ReturnCode_FileNotFound) return;
 
 	if (res) { Logger_SysWarn(res, "checking default.zip"); return; }
-	Zip_Init(&state, &stream);
-	state.SelectEntry = Resources_SelectZipEntry;
-
-	res = Zip_Extract(&state);
+	res = ZipIndex_Load(&index, &stream);
 	stream.Close(&stream);
 	if (res) Logger_SysWarn(res, "inspecting default.zip");
 
-	/* if somehow have say "gui.png", "GUI.png" */
+	/* Only the central directory needs to be read to check which textures exist */
+	for (i = 0; i < Array_Elems(textureResources); i++) {
+		name = String_FromReadonly(textureResources[i].filename);
+		if (ZipIndex_Find(&index, &name)) texturesFound++;
+	}
+	ZipIndex_Free(&index);
 	allTexturesExist = texturesFound >= Array_Elems(textureResources);
 }
 
@@ -211,149 +205,25 @@ void Resources_CheckExistence(void) {
 /*########################################################################################################################*
 *---------------------------------------------------------Zip writer------------------------------------------------------*
 *#########################################################################################################################*/
-static cc_result ZipPatcher_LocalFile(struct Stream* s, struct ResourceTexture* e) {
-	int filenameLen = String_Length(e->filename);
-	cc_uint8 header[30 + STRING_SIZE];
-	cc_result res;
-	if ((res = s->Position(s, &e->offset))) return res;
-
-	Stream_SetU32_LE(header + 0,  0x04034b50);  /* signature */
-	Stream_SetU16_LE(header + 4,  20);          /* version needed */
-	Stream_SetU16_LE(header + 6,  0);           /* bitflags */
-	Stream_SetU16_LE(header + 8,  0);           /* compression method */
-	Stream_SetU16_LE(header + 10, 0);           /* last modified */
-	Stream_SetU16_LE(header + 12, 0);           /* last modified */
-	
-	Stream_SetU32_LE(header + 14, e->crc32);    /* CRC32 */
-	Stream_SetU32_LE(header + 18, e->size);     /* Compressed size */
-	Stream_SetU32_LE(header + 22, e->size);     /* Uncompressed size */
-	 
-	Stream_SetU16_LE(header + 26, filenameLen); /* name length */
-	Stream_SetU16_LE(header + 28, 0);           /* extra field length */
-
-	Mem_Copy(header + 30, e->filename, filenameLen);
-	return Stream_Write(s, header, 30 + filenameLen);
-}
-
-static cc_result ZipPatcher_CentralDir(struct Stream* s, struct ResourceTexture* e) {
-	int filenameLen = String_Length(e->filename);
-	cc_uint8 header[46 + STRING_SIZE];
-	struct DateTime now;
-	int modTime, modDate;
-
-	DateTime_CurrentLocal(&now);
-	modTime = (now.second / 2) | (now.minute << 5) | (now.hour << 11);
-	modDate = (now.day) | (now.month << 5) | ((now.year - 1980) << 9);
-
-	Stream_SetU32_LE(header + 0,  0x02014b50);  /* signature */
-	Stream_SetU16_LE(header + 4,  20);          /* version */
-	Stream_SetU16_LE(header + 6,  20);          /* version needed */
-	Stream_SetU16_LE(header + 8,  0);           /* bitflags */
-	Stream_SetU16_LE(header + 10, 0);           /* compression method */
-	Stream_SetU16_LE(header + 12, modTime);     /* last modified */
-	Stream_SetU16_LE(header + 14, modDate);     /* last modified */
-
-	Stream_SetU32_LE(header + 16, e->crc32);    /* CRC32 */
-	Stream_SetU32_LE(header + 20, e->size);     /* compressed size */
-	Stream_SetU32_LE(header + 24, e->size);     /* uncompressed size */
-
-	Stream_SetU16_LE(header + 28, filenameLen); /* name length */
-	Stream_SetU16_LE(header + 30, 0);           /* extra field length */
-	Stream_SetU16_LE(header + 32, 0);           /* file comment length */
-	Stream_SetU16_LE(header + 34, 0);           /* disk number */
-	Stream_SetU16_LE(header + 36, 0);           /* internal attributes */
-	Stream_SetU32_LE(header + 38, 0);           /* external attributes */
-	Stream_SetU32_LE(header + 42, e->offset);   /* local header offset */
-
-	Mem_Copy(header + 46, e->filename, filenameLen);
-	return Stream_Write(s, header, 46 + filenameLen);
-}
-
-static cc_result ZipPatcher_EndOfCentralDir(struct Stream* s, cc_uint32 centralDirBeg, cc_uint32 centralDirEnd) {
-	cc_uint8 header[22];
-
-	Stream_SetU32_LE(header + 0,  0x06054b50); /* signature */
-	Stream_SetU16_LE(header + 4,  0);          /* disk number */
-	Stream_SetU16_LE(header + 6,  0);          /* disk number of start */
-	Stream_SetU16_LE(header + 8,  Array_Elems(textureResources));  /* disk entries */
-	Stream_SetU16_LE(header + 10, Array_Elems(textureResources));  /* total entries */
-	Stream_SetU32_LE(header + 12, centralDirEnd - centralDirBeg);  /* central dir size */
-	Stream_SetU32_LE(header + 16, centralDirBeg);                  /* central dir start */
-	Stream_SetU16_LE(header + 20, 0);         /* comment length */
-	return Stream_Write(s, header, 22);
-}
-
-static cc_result ZipPatcher_FixupLocalFile(struct Stream* s, struct ResourceTexture* e) {
-	int filenameLen = String_Length(e->filename);
-	cc_uint8 tmp[2048];
-	cc_uint32 dataBeg, dataEnd;
-	cc_uint32 i, crc, toRead, read;
-	cc_result res;
-
-	dataBeg = e->offset + 30 + filenameLen;
-	if ((res = s->Position(s, &dataEnd))) return res;
-	e->size = dataEnd - dataBeg;
-
-	/* work out the CRC 32 */
-	crc = 0xffffffffUL;
-	if ((res = s->Seek(s, dataBeg))) return res;
-
-	for (; dataBeg < dataEnd; dataBeg += read) {
-		toRead = dataEnd - dataBeg;
-		toRead = min(toRead, sizeof(tmp));
-
-		if ((res = s->Read(s, tmp, toRead, &read))) return res;
-		if (!read) return ERR_END_OF_STREAM;
-
-		for (i = 0; i < read; i++) {
-			crc = Utils_Crc32Table[(crc ^ tmp[i]) & 0xFF] ^ (crc >> 8);
-		}
-	}
-	e->crc32 = crc ^ 0xffffffffUL;
-
-	/* then fixup the header */
-	if ((res = s->Seek(s, e->offset)))      return res;
-	if ((res = ZipPatcher_LocalFile(s, e))) return res;
-	return s->Seek(s, dataEnd);
-}
-
-static cc_result ZipPatcher_WriteData(struct Stream* dst, struct ResourceTexture* tex, const cc_uint8* data, cc_uint32 len) {
-	cc_result res;
-	tex->size  = len;
-	tex->crc32 = Utils_CRC32(data, len);
-
-	res = ZipPatcher_LocalFile(dst, tex);
-	if (res) return res;
-	return Stream_Write(dst, data, len);
+static cc_result ZipPatcher_WriteData(struct ZipWriter* w, struct ResourceTexture* tex, const cc_uint8* data, cc_uint32 len) {
+	cc_string path = String_FromReadonly(tex->filename);
+	return ZipWriter_AddData(w, &path, data, len, ZIP_METHOD_AUTO);
 }
 
 static cc_result ZipPatcher_WriteZipEntry(struct Stream* src, struct ResourceTexture* tex, struct ZipState* state) {
-	cc_uint8 tmp[2048];
-	cc_uint32 read;
-	struct Stream* dst = (struct Stream*)state->obj;
-	cc_result res;
-
-	tex->size  = state->_curEntry->UncompressedSize;
-	tex->crc32 = state->_curEntry->CRC32;
-	res = ZipPatcher_LocalFile(dst, tex);
-	if (res) return res;
-
-	for (;;) {
-		res = src->Read(src, tmp, sizeof(tmp), &read);
-		if (res)   return res;
-		if (!read) break;
-
-		if ((res = Stream_Write(dst, tmp, read))) return res;
-	}
-	return 0;
+	cc_string path = String_FromReadonly(tex->filename);
+	return ZipWriter_AddStream((struct ZipWriter*)state->obj, &path, src, ZIP_METHOD_AUTO);
 }
 
-static cc_result ZipPatcher_WritePng(struct Stream* s, struct ResourceTexture* tex, struct Bitmap* src) {
+static cc_result ZipPatcher_WritePng(struct ZipWriter* w, struct ResourceTexture* tex, struct Bitmap* src) {
+	cc_string path = String_FromReadonly(tex->filename);
+	struct Stream* s;
 	cc_result res;
 
-	if ((res = ZipPatcher_LocalFile(s, tex)))   return res;
-	if ((res = Png_Encode(src, s, NULL, true))) return res;
-	return ZipPatcher_FixupLocalFile(s, tex);
+	if ((res = ZipWriter_BeginEntry(w, &path, ZIP_METHOD_STORE, &s))) return res;
+	/* Only generated once, so worth spending extra time to make default.zip smaller */
+	if ((res = Png_EncodeLevel(src, s, NULL, true, DEFLATE_LEVEL_BEST))) return res;
+	return ZipWriter_EndEntry(w);
 }
 
 
@@ -404,14 +274,14 @@ static cc_result ClassicPatcher_ProcessEntry(const cc_string* path, struct Strea
 	return ZipPatcher_WriteZipEntry(data, entry, state);
 }
 
-static cc_result ClassicPatcher_ExtractFiles(struct Stream* s) {
+static cc_result ClassicPatcher_ExtractFiles(struct ZipWriter* w) {
 	struct ZipState zip;
 	struct Stream src;
 
 	Stream_ReadonlyMemory(&src, fileResources[0].data, fileResources[0].len);
 	Zip_Init(&zip, &src);
 
-	zip.obj = s;
+	zip.obj = w;
 	zip.SelectEntry  = ClassicPatcher_SelectEntry;
 	zip.ProcessEntry = ClassicPatcher_ProcessEntry;
 	return Zip_Extract(&zip);
@@ -466,7 +336,7 @@ static cc_bool ModernPatcher_SelectEntry(const cc_string* path) {
 		ModernPatcher_GetTile(path) != NULL;
 }
 
-static cc_result ModernPatcher_MakeAnimations(struct Stream* s, struct Stream* data) {
+static cc_result ModernPatcher_MakeAnimations(struct ZipWriter* w, struct Stream* data) {
 	static const cc_string animsPng = String_FromConst("animations.png");
 	struct ResourceTexture* entry;
 	BitmapCol pixels[512 * 16];
@@ -483,7 +353,7 @@ static cc_result ModernPatcher_MakeAnimations(struct Stream* s, struct Stream* d
 
 	Mem_Free(bmp.scan0);
 	entry = Resources_FindTex(&animsPng);
-	return ZipPatcher_WritePng(s, entry, &anim);
+	return ZipPatcher_WritePng(w, entry, &anim);
 }
 
 static cc_result ModernPatcher_ProcessEntry(const cc_string* path, struct Stream* data, struct ZipState* state) {
@@ -501,22 +371,22 @@ static cc_result ModernPatcher_ProcessEntry(const cc_string* path, struct Stream
 	}
 
 	if (String_CaselessEqualsConst(path, "assets/minecraft/textures/blocks/fire_layer_1.png")) {
-		struct Stream* dst = (struct Stream*)state->obj;
-		return ModernPatcher_MakeAnimations(dst, data);
+		struct ZipWriter* w = (struct ZipWriter*)state->obj;
+		return ModernPatcher_MakeAnimations(w, data);
 	}
 
 	tile = ModernPatcher_GetTile(path);
 	return ModernPatcher_PatchTile(data, tile);
 }
 
-static cc_result ModernPatcher_ExtractFiles(struct Stream* s) {
+static cc_result ModernPatcher_ExtractFiles(struct ZipWriter* w) {
 	struct ZipState zip;
 	struct Stream src;
 
 	Stream_ReadonlyMemory(&src, fileResources[1].data, fileResources[1].len);
 	Zip_Init(&zip, &src);
 
-	zip.obj = s;
+	zip.obj = w;
 	zip.SelectEntry  = ModernPatcher_SelectEntry;
 	zip.ProcessEntry = ModernPatcher_ProcessEntry;
 	return Zip_Extract(&zip);
@@ -533,27 +403,27 @@ static cc_result TexPatcher_ProcessEntry(const cc_string* path, struct Stream* d
 	return ZipPatcher_WriteZipEntry(data, entry, state);
 }
 
-static cc_result TexPactcher_ExtractGui(struct Stream* s) {
+static cc_result TexPactcher_ExtractGui(struct ZipWriter* w) {
 	struct ZipState zip;
 	struct Stream src;
 
 	Stream_ReadonlyMemory(&src, fileResources[3].data, fileResources[3].len);
 	Zip_Init(&zip, &src);
 
-	zip.obj = s;
+	zip.obj = w;
 	zip.SelectEntry  = TexPatcher_SelectEntry;
 	zip.ProcessEntry = TexPatcher_ProcessEntry;
 	return Zip_Extract(&zip);
 }
 #else
-static cc_result TexPactcher_ExtractGui(struct Stream* s) {
+static cc_result TexPactcher_ExtractGui(struct ZipWriter* w) {
 	static const cc_string guiPng = String_FromConst("gui.png");
 	struct ResourceTexture* entry = Resources_FindTex(&guiPng);
-	return ZipPatcher_WriteData(s, entry, fileResources[3].data, fileResources[3].len);
+	return ZipPatcher_WriteData(w, entry, fileResources[3].data, fileResources[3].len);
 }
 #endif
 
-static cc_result TexPatcher_NewFiles(struct Stream* s) {
+static cc_result TexPatcher_NewFiles(struct ZipWriter* w) {
 	static const cc_string guiPng   = String_FromConst("gui.png");
 	static const cc_string animsTxt = String_FromConst("animations.txt");
 	struct ResourceTexture* entry;
@@ -561,18 +431,18 @@ static cc_result TexPatcher_NewFiles(struct Stream* s) {
 
 	/* make default animations.txt */
 	entry = Resources_FindTex(&animsTxt);
-	res   = ZipPatcher_WriteData(s, entry, (const cc_uint8*)ANIMS_TXT, sizeof(ANIMS_TXT) - 1);
+	res   = ZipPatcher_WriteData(w, entry, (const cc_uint8*)ANIMS_TXT, sizeof(ANIMS_TXT) - 1);
 	if (res) return res;
 
 	/* make ClassiCube gui.png */
-	return TexPactcher_ExtractGui(s);
+	return TexPactcher_ExtractGui(w);
 }
 
 static void TexPatcher_PatchTile(struct Bitmap* src, int srcX, int srcY, int dstX, int dstY) {
 	Bitmap_UNSAFE_CopyBlock(srcX, srcY, dstX * 16, dstY * 16, src, &terrainBmp, 16);
 }
 
-static cc_result TexPatcher_Terrain(struct Stream* s) {
+static cc_result TexPatcher_Terrain(struct ZipWriter* w) {
 	static const cc_string terrainPng = String_FromConst("terrain.png");
 	struct ResourceTexture* entry;
 	struct Bitmap bmp;
@@ -591,28 +461,28 @@ static cc_result TexPatcher_Terrain(struct Stream* s) {
 	TexPatcher_PatchTile(&bmp, 32,16, 11,0);
 
 	entry = Resources_FindTex(&terrainPng);
-	res   = ZipPatcher_WritePng(s, entry, &terrainBmp);
+	res   = ZipPatcher_WritePng(w, entry, &terrainBmp);
 	Mem_Free(bmp.scan0);
 	return res;
 }
 
-static cc_result TexPatcher_WriteEntries(struct Stream* s) {
-	cc_uint32 beg, end;
-	int i;
+static cc_result TexPatcher_WriteEntries(struct ZipWriter* w) {
 	cc_result res;
+	if ((res = ClassicPatcher_ExtractFiles(w))) return res;
+	if ((res = ModernPatcher_ExtractFiles(w)))  return res;
+	if ((res = TexPatcher_NewFiles(w)))         return res;
+	return TexPatcher_Terrain(w);
+}
 
-	if ((res = ClassicPatcher_ExtractFiles(s))) return res;
-	if ((res = ModernPatcher_ExtractFiles(s)))  return res;
-	if ((res = TexPatcher_NewFiles(s)))         return res;
-	if ((res = TexPatcher_Terrain(s)))          return res;
-	
-	if ((res = s->Position(s, &beg))) return res;
-	for (i = 0; i < Array_Elems(textureResources); i++) {
-		if ((res = ZipPatcher_CentralDir(s, &textureResources[i]))) return res;
-	}
+static cc_result TexPatcher_WriteZip(struct Stream* s) {
+	struct ZipWriter zip;
+	cc_result res, endRes;
 
-	if ((res = s->Position(s, &end))) return res;
-	return ZipPatcher_EndOfCentralDir(s, beg, end);
+	if ((res = ZipWriter_Begin(&zip, s, DEFLATE_LEVEL_BEST))) return res;
+	res    = TexPatcher_WriteEntries(&zip);
+	/* Always need to end, so the writer gets freed */
+	endRes = ZipWriter_End(&zip);
+	return res ? res : endRes;
 }
 
 static void TexPatcher_MakeDefaultZip(void) {
@@ -625,7 +495,7 @@ static void TexPatcher_MakeDefaultZip(void) {
 	if (res) {
 		Logger_SysWarn(res, "creating default.zip");
 	} else {
-		res = TexPatcher_WriteEntries(&s);
+		res = TexPatcher_WriteZip(&s);
 		if (res) Logger_SysWarn(res, "making default.zip");
 
 		res = s.Close(&s);
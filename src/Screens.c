@@ -1729,7 +1729,7 @@ static void GeneratingScreen_Init(void* screen) {
 	Gen_Done = false;
 	LoadingScreen_Init(screen);
 
-	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	Gen_Blocks = World_TryAllocBlocks(World.Volume);
 	if (!Gen_Blocks) {
 		Window_ShowDialog("Out of memory", "Not enough free memory to generate a map that large.\nTry a smaller size.");
 		Gen_Done = true;
@@ -24,6 +24,8 @@
 #include "Platform.h"
 #include "Input.h"
 #include "Errors.h"
+#include "Stream.h"
+#include "Options.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -208,29 +210,438 @@ static void SPConnection_Init(void) {
 
 
 /*########################################################################################################################*
-*--------------------------------------------------Multiplayer connection-------------------------------------------------*
+*-----------------------------------------------------Network I/O---------------------------------------------------------*
 *#########################################################################################################################*/
+/* Socket reads and writes are done on a separate thread, so that slow frames don't delay */
+/*  receiving packets, and bursts of received packets don't delay rendering frames. */
+/* Received data is framed into packets (using Protocol.Sizes) and copied into the incoming ring, */
+/*  which the game thread then handles packets from. Data to send is copied into the outgoing queue, */
+/*  which grows as needed so that the game never has to wait for the socket to accept more data. */
+/* Queued data is written straight away without blocking, so the network thread only has to */
+/*  write the data that the socket was unable to accept at the time. */
+
+/* The incoming ring has one producer and one consumer, which only ever advance tail and head respectively */
+/* NOTE: Positions are published under net_ringMutex, since there are no atomics in the platform layer */
+/* The outgoing queue is only ever accessed with net_sendMutex held, since it may be reallocated */
+struct NetRing { cc_uint8* data; cc_uint32 size, head, tail; };
+static struct NetRing net_incoming, net_outgoing;
 static cc_socket net_socket;
-static cc_uint8  net_readBuffer[4096 * 5];
-static cc_uint8  net_writeBuffer[131];
-static cc_uint8* net_readCurrent;
+static volatile cc_bool net_writeFailed;
+
+/* Data is read from the socket into the read ring, which packets are then framed from */
+#define NET_READ_SIZE  (64 * 1024) /* must be a power of two */
+#define NET_READ_SLACK 4096 /* Packets that wrap around the end of the read ring are made contiguous here */
+#define NET_READ_BUDGET (256 * 1024) /* Maximum number of bytes received in one NetIO_Receive call */
+static cc_uint8 net_readBuffer[NET_READ_SIZE + NET_READ_SLACK];
+static cc_uint32 net_readHead, net_readTail; /* Framed up to, and received up to, positions */
+#define NET_INCOMING_SIZE (1024 * 1024) /* must be a power of two */
+#define NET_OUTGOING_SIZE (64 * 1024)   /* initial size, must be a power of two */
+
+/* Packets in the incoming ring are prefixed with their length, or one of these special values */
+#define NET_RECORD_D3FIX   0x0000 /* Skipped an invalid HackControl byte from a D3 server */
+#define NET_RECORD_INVALID 0xFFFE /* Server sent the opcode that follows, which has no handler */
+#define NET_RECORD_WRAP    0xFFFF /* Rest of the ring is unused, next record is at the start */
+
+static void* net_ringMutex;
+static cc_uint32 net_nextHead;   /* Position after the packet last returned by NetIO_PeekPacket */
+static cc_uint8 net_frameOpcode; /* Opcode of the packet last framed */
+static cc_bool net_frameInvalid; /* Whether framing stopped due to an invalid opcode */
+/* Error from reading, or ERR_END_OF_STREAM when the server closed the connection */
+static volatile cc_result net_readResult;
+
+static void* net_sendMutex;
+static cc_uint32 net_sendMax;  /* Maximum size the outgoing queue can grow to */
+static volatile cc_bool net_sendOverflow; /* Whether outgoing queue was full and could not grow */
+/* Statistics about how often the socket was unable to accept data as fast as it was sent */
+static struct NetSendStats {
+	cc_uint32 peakQueued; /* Most bytes waiting in the outgoing queue at once */
+	cc_uint32 stalls;     /* Number of times socket went from accepting data to not accepting data */
+	cc_uint32 grows;      /* Number of times outgoing queue was reallocated to be larger */
+	cc_bool stalled;
+} net_sendStats;
+
+static cc_uint32 NetRing_Load(cc_uint32* pos) {
+	cc_uint32 value;
+	Mutex_Lock(net_ringMutex);
+	{
+		value = *pos;
+	}
+	Mutex_Unlock(net_ringMutex);
+	return value;
+}
+
+static void NetRing_Store(cc_uint32* pos, cc_uint32 value) {
+	Mutex_Lock(net_ringMutex);
+	{
+		*pos = value;
+	}
+	Mutex_Unlock(net_ringMutex);
+}
+
+static void NetRing_Init(struct NetRing* ring, cc_uint32 size, const char* place) {
+	/* Reuse existing buffer (which may have grown larger) from earlier connection */
+	if (!ring->data) {
+		ring->data = (cc_uint8*)Mem_Alloc(size, 1, place);
+		ring->size = size;
+	}
+	ring->head = 0;
+	ring->tail = 0;
+}
+
+/* Copies a record into the incoming ring, returning false when there isn't enough space */
+static cc_bool NetIO_PushRecord(int header, const cc_uint8* data, int len) {
+	struct NetRing* ring = &net_incoming;
+	cc_uint32 head = NetRing_Load(&ring->head);
+	cc_uint32 tail = ring->tail;
+	cc_uint32 pos  = tail & (ring->size - 1);
+	cc_uint32 skip = 0;
+
+	/* Records are always contiguous, so may need to skip the end of the ring */
+	if (pos + 2 + len > ring->size) skip = ring->size - pos;
+	if ((tail - head) + skip + 2 + len > ring->size) return false;
+
+	if (skip) {
+		/* Less than 2 bytes at the end are implicitly skipped */
+		if (skip >= 2) Stream_SetU16_BE(ring->data + pos, NET_RECORD_WRAP);
+		tail += skip; pos = 0;
+	}
+
+	Stream_SetU16_BE(ring->data + pos, header);
+	Mem_Copy(ring->data + pos + 2, data, len);
+	NetRing_Store(&ring->tail, tail + 2 + len);
+	return true;
+}
+
+/* Reads as much data as is available from the socket into the read ring */
+/* Sets whether the socket likely has more data pending that did not fit into the read ring */
+static cc_uint32 NetIO_ReadSocket(cc_bool* more) {
+	cc_uint32 pos, count, read, total = 0;
+	cc_bool readable = false;
+	cc_result res    = 0;
+
+	*more = false;
+	if (net_readResult) return 0;
+	res = Socket_Poll(net_socket, SOCKET_POLL_READ, &readable);
+
+	while (!res && readable) {
+		pos   = net_readTail & (NET_READ_SIZE - 1);
+		count = NET_READ_SIZE - (net_readTail - net_readHead);
+		count = min(count, NET_READ_SIZE - pos);
+		if (!count) { *more = true; break; }
+
+		res = Socket_Read(net_socket, net_readBuffer + pos, count, &read);
+		if (res) break;
+		/* poll read returns true when socket is closed */
+		if (!read && !total) res = ERR_END_OF_STREAM;
+
+		net_readTail += read;
+		total        += read;
+		/* Socket likely still has more data pending when the read filled all the space */
+		readable = read == count;
+	}
+
+	/* Ignore errors for 'no data available for non-blocking read' */
+	if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) res = 0;
+	if (res) net_readResult = res;
+	return total;
+}
+
+/* Frames as many complete packets in the read ring as possible, returning whether any were */
+static cc_bool NetIO_FramePackets(void) {
+	cc_uint32 beg = net_readHead;
+	cc_uint32 pos, avail;
+	cc_uint8 opcode;
+	int size;
+
+	while (net_readHead != net_readTail && !net_frameInvalid) {
+		pos    = net_readHead & (NET_READ_SIZE - 1);
+		avail  = net_readTail - net_readHead;
+		opcode = net_readBuffer[pos];
+
+		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+		if (cpe_needD3Fix && net_frameOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+			if (!NetIO_PushRecord(NET_RECORD_D3FIX, NULL, 0)) break;
+			net_readHead++;
+			continue;
+		}
+
+		/* NOTE: Packets are never anywhere near NET_READ_SLACK bytes in size */
+		size = Protocol.Sizes[opcode];
+		if (!Protocol.Handlers[opcode] || !size || size > NET_READ_SLACK) {
+			if (!NetIO_PushRecord(NET_RECORD_INVALID, &opcode, 1)) break;
+			net_frameInvalid = true;
+			break;
+		}
+
+		/* Protocol packets might be split up across TCP packets */
+		/* If so, these bytes are later combined with subsequently read TCP packet data */
+		if ((cc_uint32)size > avail) break;
+
+		/* Packet wraps around the end of the ring, so copy the wrapped part to just after the end */
+		if (pos + size > NET_READ_SIZE) {
+			Mem_Copy(net_readBuffer + NET_READ_SIZE, net_readBuffer, pos + size - NET_READ_SIZE);
+		}
+		if (!NetIO_PushRecord(size, net_readBuffer + pos, size)) break;
+
+		net_frameOpcode = opcode;
+		net_readHead   += size;
+	}
+	return net_readHead != beg;
+}
+
+/* Receives and frames data until there is no more data pending or the budget is used up */
+/* Returns whether any data was read or framed */
+static cc_bool NetIO_Receive(void) {
+	cc_uint32 read, total = 0;
+	cc_bool more, framed = false;
+
+	do {
+		read    = NetIO_ReadSocket(&more);
+		total  += read;
+		framed |= NetIO_FramePackets();
+	} while (more && read && total < NET_READ_BUDGET);
+	return total || framed;
+}
+
+/* Writes as much of the data in the outgoing queue to the socket as possible */
+/* Returns whether any data was written */
+static cc_bool NetIO_Flush(void) {
+	struct NetRing* ring = &net_outgoing;
+	cc_uint32 pos, count, wrote, total = 0;
+	cc_bool writable;
+	cc_result res;
+
+	Mutex_Lock(net_sendMutex);
+	while (ring->head != ring->tail) {
+		res = Socket_Poll(net_socket, SOCKET_POLL_WRITE, &writable);
+		wrote = 0;
+
+		if (!res && writable) {
+			pos   = ring->head & (ring->size - 1);
+			count = min(ring->tail - ring->head, ring->size - pos);
+			res   = Socket_Write(net_socket, ring->data + pos, count, &wrote);
+		}
+
+		/* Socket send buffer is full, so try again later */
+		if (!res && !writable) res = ReturnCode_SocketWouldBlock;
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+			if (!net_sendStats.stalled) net_sendStats.stalls++;
+			net_sendStats.stalled = true;
+			break;
+		}
+
+		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
+		if (res || !wrote) { net_writeFailed = true; ring->head = ring->tail; break; }
+		ring->head += wrote;
+		total      += wrote;
+		net_sendStats.stalled = false;
+	}
+	Mutex_Unlock(net_sendMutex);
+	return total != 0;
+}
+
+/* Reallocates outgoing queue to be at least the given size, moving queued data to the start */
+static cc_bool NetIO_GrowQueue(cc_uint32 required) {
+	struct NetRing* ring = &net_outgoing;
+	cc_uint32 used = ring->tail - ring->head;
+	cc_uint32 size = ring->size;
+	cc_uint32 i, pos, count;
+	cc_uint8* data;
+
+	while (size < required) size *= 2;
+	if (size > net_sendMax) return false;
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return false;
+
+	for (i = 0; i < used; i += count) {
+		pos   = (ring->head + i) & (ring->size - 1);
+		count = min(used - i, ring->size - pos);
+		Mem_Copy(data + i, ring->data + pos, count);
+	}
+
+	Mem_Free(ring->data);
+	ring->data = data;
+	ring->size = size;
+	ring->head = 0;
+	ring->tail = used;
+	net_sendStats.grows++;
+	return true;
+}
+
+/* Appends data to the outgoing queue, returning false if the queue could not be made large enough */
+static cc_bool NetIO_Enqueue(const cc_uint8* data, cc_uint32 len) {
+	struct NetRing* ring = &net_outgoing;
+	cc_uint32 used = ring->tail - ring->head;
+	cc_uint32 pos, count;
 
-static cc_bool net_writeFailed;
+	if (used + len > ring->size && !NetIO_GrowQueue(used + len)) return false;
+	net_sendStats.peakQueued = max(net_sendStats.peakQueued, used + len);
+
+	while (len) {
+		pos   = ring->tail & (ring->size - 1);
+		count = min(len, ring->size - pos);
+		Mem_Copy(ring->data + pos, data, count);
+
+		data += count; len -= count;
+		ring->tail += count;
+	}
+	return true;
+}
+
+static void NetIO_LogStats(void) {
+	Platform_Log3("Outgoing queue: peak %i bytes, %i stalls, %i grows",
+		&net_sendStats.peakQueued, &net_sendStats.stalls, &net_sendStats.grows);
+}
+
+static void NetIO_Reset(void) {
+	NetRing_Init(&net_incoming, NET_INCOMING_SIZE, "net incoming");
+	NetRing_Init(&net_outgoing, NET_OUTGOING_SIZE, "net outgoing");
+	net_frameInvalid = false;
+	net_readResult   = 0;
+	net_sendOverflow = false;
+	net_readHead     = 0;
+	net_readTail     = 0;
+
+	net_sendMax = Options_GetInt(OPT_SEND_QUEUE_MAX, 64, 256 * 1024, 4096) * 1024;
+	Mem_Set(&net_sendStats, 0, sizeof(net_sendStats));
+}
+
+/* Returns the next packet in the incoming ring, or NULL if there are none */
+/* NOTE: Packet remains valid until NetIO_PopPacket is called */
+static cc_uint8* NetIO_PeekPacket(int* header) {
+	struct NetRing* ring = &net_incoming;
+	cc_uint32 tail = NetRing_Load(&ring->tail);
+	cc_uint32 head = ring->head;
+	cc_uint32 pos;
+
+	for (;;) {
+		if (head == tail) return NULL;
+		pos = head & (ring->size - 1);
+
+		if (pos + 2 <= ring->size) {
+			*header = Stream_GetU16_BE(ring->data + pos);
+			if (*header != NET_RECORD_WRAP) break;
+		}
+		head += ring->size - pos;
+	}
+
+	net_nextHead = head + 2;
+	if (*header == NET_RECORD_INVALID)   net_nextHead += 1;
+	else if (*header != NET_RECORD_D3FIX) net_nextHead += *header;
+	return ring->data + pos + 2;
+}
+
+static void NetIO_PopPacket(void) {
+	NetRing_Store(&net_incoming.head, net_nextHead);
+}
+
+#ifdef CC_BUILD_WEB
+/* No threading support, so reads and writes are done directly in network tick instead */
+static void NetIO_Start(void) { NetIO_Reset(); }
+static void NetIO_Stop(void) { }
+static void NetIO_Tick(void) { NetIO_Flush(); NetIO_Receive(); }
+static void NetIO_Signal(void) { NetIO_Flush(); }
+#else
+static void* net_ioThread;
+static void* net_ioWaitable;
+static cc_bool net_ioStop;
+/* Longest time network thread waits before checking whether it should stop */
+#define NET_IO_WAIT_MS 50
+
+/* Waits until socket has received more data, or can accept more of the queued data */
+static void NetIO_Wait(void) {
+	cc_bool ready, sending;
+	cc_uint32 free = NET_READ_SIZE - (net_readTail - net_readHead);
+
+	Mutex_Lock(net_sendMutex);
+	{
+		sending = net_outgoing.head != net_outgoing.tail;
+	}
+	Mutex_Unlock(net_sendMutex);
+
+	/* Only poll for writing when socket was unable to accept all the queued data */
+	if (net_readResult || !free) {
+		/* Socket would always be readable in these cases, so wait for game thread instead */
+		if (sending) {
+			Socket_PollFor(net_socket, SOCKET_POLL_WRITE, NET_IO_WAIT_MS, &ready);
+		} else {
+			Waitable_WaitFor(net_ioWaitable, NET_IO_WAIT_MS);
+		}
+	} else {
+		Socket_PollFor(net_socket, sending ? SOCKET_POLL_READWRITE : SOCKET_POLL_READ, NET_IO_WAIT_MS, &ready);
+	}
+}
+
+static void NetIO_Run(void) {
+	cc_bool progress;
+
+	for (;;) {
+		Mutex_Lock(net_ringMutex);
+		{
+			progress = net_ioStop;
+		}
+		Mutex_Unlock(net_ringMutex);
+		if (progress) return;
+
+		progress  = NetIO_Flush();
+		progress |= NetIO_Receive();
+		if (!progress) NetIO_Wait();
+	}
+}
+
+static void NetIO_Start(void) {
+	NetIO_Reset();
+
+	if (!net_ringMutex) {
+		net_ringMutex  = Mutex_Create();
+		net_sendMutex  = Mutex_Create();
+		net_ioWaitable = Waitable_Create();
+	}
+	net_ioStop   = false;
+	net_ioThread = Thread_Start(NetIO_Run);
+}
+
+static void NetIO_Stop(void) {
+	if (!net_ioThread) return;
+	Mutex_Lock(net_ringMutex);
+	{
+		net_ioStop = true;
+	}
+	Mutex_Unlock(net_ringMutex);
+
+	Waitable_Signal(net_ioWaitable);
+	Thread_Join(net_ioThread);
+	net_ioThread = NULL;
+}
+
+/* Packets handled last tick may have made room in the incoming ring */
+static void NetIO_Tick(void) { Waitable_Signal(net_ioWaitable); }
+static void NetIO_Signal(void) { NetIO_Flush(); Waitable_Signal(net_ioWaitable); }
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Multiplayer connection-------------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint8 net_writeBuffer[131];
 static double lastPacket;
 static cc_uint8 lastOpcode;
 
 static cc_bool net_connecting;
 static double net_connectTimeout;
 #define NET_TIMEOUT_SECS 15
+/* Maximum time spent handling received packets in each network tick */
+#define NET_TICK_BUDGET_MS 5
 
 static void OnClose(void);
+
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
 	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
 
-	net_readCurrent    = net_readBuffer;
 	Server.WriteBuffer = net_writeBuffer;
+	NetIO_Start();
 
 	Classic_SendLogin();
 	lastPacket = Game.Time;
@@ -338,17 +749,14 @@ static void MPConnection_SendPosition(Vec3 pos, float yaw, float pitch) {
 static void MPConnection_CheckDisconnection(void) {
 	static const cc_string title  = String_FromConst("Disconnected!");
 	static const cc_string reason = String_FromConst("You've lost connection to the server");
-	cc_result availRes, selectRes;
-	int pending = 0;
-	cc_bool poll_read;
-
-	availRes  = Socket_Available(net_socket, &pending);
-	/* poll read returns true when socket is closed */
-	selectRes = Socket_Poll(net_socket, SOCKET_POLL_READ, &poll_read);
+	/* NOTE: The network thread detects the socket being closed while reading */
+	if (net_writeFailed) Game_Disconnect(&title, &reason);
+}
 
-	if (net_writeFailed || availRes || selectRes || (pending == 0 && poll_read)) {	
-		Game_Disconnect(&title, &reason);
-	}
+static void MPConnection_SendOverflow(void) {
+	static const cc_string title  = String_FromConst("Disconnected!");
+	static const cc_string reason = String_FromConst("Too much data waiting to be sent to the server");
+	Game_Disconnect(&title, &reason);
 }
 
 static void DisconnectInvalidOpcode(cc_uint8 opcode) {
@@ -360,77 +768,64 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
-	static const cc_string title_lost  = String_FromConst("&eLost connection to the server");
-	static const cc_string reason_err  = String_FromConst("I/O error when reading packets");
+static void DisconnectReadFailed(cc_result res) {
+	static const cc_string title_lost = String_FromConst("&eLost connection to the server");
+	static const cc_string reason_err = String_FromConst("I/O error when reading packets");
+	static const cc_string title_eos  = String_FromConst("Disconnected!");
+	static const cc_string reason_eos = String_FromConst("You've lost connection to the server");
 	cc_string msg; char msgBuffer[STRING_SIZE * 2];
-	cc_uint32 pending;
-	cc_uint8* readEnd;
-	Net_Handler handler;
-	int i, remaining;
-	cc_result res;
-
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(); return; }
-
-	/* Over 30 seconds since last packet, connection likely dropped */
-	if (lastPacket + 30 < Game.Time) MPConnection_CheckDisconnection();
-	if (Server.Disconnected) return;
-
-	pending = 0;
-	res     = Socket_Available(net_socket, &pending);
-	readEnd = net_readCurrent; /* todo change to int remaining instead */
-
-	if (!res && pending) {
-		/* NOTE: Always using a read call that is a multiple of 4096 (appears to?) improve read performance */	
-		res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &pending);
-		/* Ignore errors for 'no data available for non-blocking read' */
-		if (res) {
-			if (res == ReturnCode_SocketInProgess)  return;
-			if (res == ReturnCode_SocketWouldBlock) return;
-		}
-		readEnd += pending;
-	}
 
-	if (res) {
-		String_InitArray(msg, msgBuffer);
-		String_Format3(&msg, "Error reading from %s:%i: %i" _NL, &Server.Address, &Server.Port, &res);
+	if (res == ERR_END_OF_STREAM) { Game_Disconnect(&title_eos, &reason_eos); return; }
+	String_InitArray(msg, msgBuffer);
+	String_Format3(&msg, "Error reading from %s:%i: %i" _NL, &Server.Address, &Server.Port, &res);
 
-		Logger_Log(&msg);
-		Game_Disconnect(&title_lost, &reason_err);
-		return;
-	}
+	Logger_Log(&msg);
+	Game_Disconnect(&title_lost, &reason_err);
+}
 
-	net_readCurrent = net_readBuffer;
-	while (net_readCurrent < readEnd) {
-		cc_uint8 opcode = net_readCurrent[0];
+/* Handles packets received by the network thread, until time budget for this tick is used up */
+static void MPConnection_HandlePackets(void) {
+	cc_uint64 beg = Stopwatch_Measure();
+	cc_uint8* data;
+	cc_uint8 opcode;
+	int header;
 
-		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
-		if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+	while ((data = NetIO_PeekPacket(&header))) {
+		if (header == NET_RECORD_D3FIX) {
 			Platform_LogConst("Skipping invalid HackControl byte from D3 server");
-			net_readCurrent++;
 			LocalPlayer_ResetJumpVelocity();
-			continue;
+		} else if (header == NET_RECORD_INVALID) {
+			DisconnectInvalidOpcode(data[0]); return;
+		} else {
+			opcode     = data[0];
+			lastOpcode = opcode;
+			lastPacket = Game.Time;
+
+			Protocol_HandlePacket(data);
+			if (Server.Disconnected) return;
 		}
 
-		if (net_readCurrent + Protocol.Sizes[opcode] > readEnd) break;
-		handler = Protocol.Handlers[opcode];
-		if (!handler) { DisconnectInvalidOpcode(opcode); return; }
-
-		lastOpcode = opcode;
-		lastPacket = Game.Time;
-		handler(net_readCurrent + 1); /* skip opcode */
-		net_readCurrent += Protocol.Sizes[opcode];
+		NetIO_PopPacket();
+		if (Stopwatch_ElapsedMS(beg, Stopwatch_Measure()) >= NET_TICK_BUDGET_MS) return;
 	}
 
-	/* Protocol packets might be split up across TCP packets */
-	/* If so, copy last few unprocessed bytes back to beginning of buffer */
-	/* These bytes are then later combined with subsequently read TCP packet data */
-	remaining = (int)(readEnd - net_readCurrent);
-	for (i = 0; i < remaining; i++) {
-		net_readBuffer[i] = net_readCurrent[i];
-	}
-	net_readCurrent = net_readBuffer + remaining;
+	/* Only report read errors after all packets received before the error have been handled */
+	if (net_readResult) DisconnectReadFailed(net_readResult);
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(); return; }
+
+	/* Over 30 seconds since last packet, connection likely dropped */
+	if (lastPacket + 30 < Game.Time) MPConnection_CheckDisconnection();
+	if (net_sendOverflow) MPConnection_SendOverflow();
+	if (Server.Disconnected) return;
+
+	NetIO_Tick();
+	MPConnection_HandlePackets();
+	if (Server.Disconnected) return;
+	Protocol_ApplyLocations();
 
 	/* Network is ticked 60 times a second. We only send position updates 20 times a second */
 	if ((ticks % 3) == 0) {
@@ -443,25 +838,18 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 }
 
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
-	cc_uint32 wrote;
-	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
-
-	while (len) {
-		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
-		}
+	cc_bool queued;
+	if (Server.Disconnected || !net_outgoing.data) return;
 
-		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
-		if (res || !wrote) { net_writeFailed = true; return; }
-		data += wrote; len -= wrote;
+	Mutex_Lock(net_sendMutex);
+	{
+		queued = NetIO_Enqueue(data, len);
 	}
+	Mutex_Unlock(net_sendMutex);
+
+	/* Disconnect happens in next network tick, as this may be called from within a packet handler */
+	if (!queued) net_sendOverflow = true;
+	NetIO_Signal();
 }
 
 void Net_SendPacket(void) {
@@ -481,11 +869,141 @@ static void MPConnection_Init(void) {
 	Server.SendPosition = MPConnection_SendPosition;
 	Server.SendData     = MPConnection_SendData;
 
-	net_readCurrent    = net_readBuffer;
 	Server.WriteBuffer = net_writeBuffer;
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Replay connection----------------------------------------------------*
+*#########################################################################################################################*/
+/* Feeds packets from a trace file (see PacketProfiler_StartTrace) through the protocol handlers, */
+/*  without any network. Useful for repeatable benchmarks of map loading, block updates, etc. */
+static struct Stream replay_file, replay_stream;
+static cc_bool replay_open, replay_haveNext;
+static cc_uint8 replay_readBuffer[64 * 1024];
+static cc_uint8 replay_packet[0xFFFF];
+static cc_uint32 replay_count;
+/* When replay began, and how many microseconds after that the next packet is due */
+static cc_uint64 replay_beg, replay_due;
+
+static void ReplayConnection_Close(void) {
+	if (!replay_open) return;
+	replay_open     = false;
+	replay_haveNext = false;
+	replay_file.Close(&replay_file);
+}
+
+static void ReplayConnection_ReadNext(void) {
+	cc_uint8 header[PACKET_TRACE_HEADER_SIZE];
+	cc_uint32 size = 0;
+	cc_result res;
+	replay_haveNext = false;
+
+	res = Stream_Read(&replay_stream, header, sizeof(header));
+	if (res == ERR_END_OF_STREAM) return;
+
+	if (!res) {
+		replay_due += Stream_GetU32_BE(header);
+		size        = Stream_GetU16_BE(header + 4);
+		res         = Stream_Read(&replay_stream, replay_packet, size);
+	}
+
+	if (res) { Logger_SysWarn2(res, "replaying", &Server.ReplayPath); return; }
+	replay_haveNext = size > 0;
+}
+
+static void ReplayConnection_Finish(void) {
+	float secs = Stopwatch_ElapsedMicroseconds(replay_beg, Stopwatch_Measure()) / (1000.0f * 1000.0f);
+	ReplayConnection_Close();
+
+	Chat_Add2("&eReplayed %i packets in %f3 seconds", &replay_count, &secs);
+	Platform_Log2("Replayed %i packets in %f3 seconds", &replay_count, &secs);
+}
+
+static void ReplayConnection_BeginConnect(void) {
+	static const cc_string title = String_FromConst("Failed to replay packet trace");
+	static const cc_string badVersion = String_FromConst("Trace file is invalid or from an incompatible version");
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	cc_uint8 header[5];
+	cc_result res;
+
+	res = Stream_OpenFile(&replay_file, &Server.ReplayPath);
+	if (res) {
+		String_InitArray(msg, msgBuffer);
+		String_Format2(&msg, "Error %h opening %s", &res, &Server.ReplayPath);
+		Game_Disconnect(&title, &msg); return;
+	}
+
+	replay_open = true;
+	Stream_ReadonlyBuffered(&replay_stream, &replay_file, replay_readBuffer, sizeof(replay_readBuffer));
+	res = Stream_Read(&replay_stream, header, sizeof(header));
+
+	if (res || !Mem_Equal(header, "CCPT", 4) || header[4] != PACKET_TRACE_VERSION) {
+		ReplayConnection_Close();
+		Game_Disconnect(&title, &badVersion); return;
+	}
+
+	Server.Disconnected = false;
+	Event_RaiseVoid(&NetEvents.Connected);
+	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
+
+	replay_count = 0;
+	replay_due   = 0;
+	replay_beg   = Stopwatch_Measure();
+	ReplayConnection_ReadNext();
+}
+
+static void ReplayConnection_Tick(struct ScheduledTask* task) {
+	cc_uint64 beg;
+	if (Server.Disconnected || !replay_open) return;
+	beg = Stopwatch_Measure();
+
+	while (replay_haveNext) {
+		/* When replaying at recorded speed, wait until the packet would have been received */
+		if (!Server.ReplayFast && Stopwatch_ElapsedMicroseconds(replay_beg, beg) < replay_due) break;
+
+		Protocol_HandlePacket(replay_packet);
+		if (Server.Disconnected) return;
+		replay_count++;
+		ReplayConnection_ReadNext();
+
+		/* Even at maximum speed, frames still need to be rendered occasionally */
+		if (Stopwatch_ElapsedMS(beg, Stopwatch_Measure()) >= NET_TICK_BUDGET_MS) break;
+	}
+	Protocol_ApplyLocations();
+	if (!replay_haveNext) ReplayConnection_Finish();
+
+	/* Network is ticked 60 times a second. We only send position updates 20 times a second */
+	if ((ticks % 3) == 0) {
+		Protocol_Tick();
+		Server.WriteBuffer = net_writeBuffer;
+	}
+	ticks++;
+}
+
+/* Nothing is sent anywhere, since there is no server */
+static void ReplayConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
+
+static void ReplayConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now) { }
+
+static void ReplayConnection_SendChat(const cc_string* text) { }
+
+static void ReplayConnection_SendPosition(Vec3 pos, float yaw, float pitch) { }
+
+static void ReplayConnection_Init(void) {
+	Server_ResetState();
+	Server.IsSinglePlayer = false;
+
+	Server.BeginConnect = ReplayConnection_BeginConnect;
+	Server.Tick         = ReplayConnection_Tick;
+	Server.SendBlock    = ReplayConnection_SendBlock;
+	Server.SendChat     = ReplayConnection_SendChat;
+	Server.SendPosition = ReplayConnection_SendPosition;
+	Server.SendData     = ReplayConnection_SendData;
+	Server.WriteBuffer  = net_writeBuffer;
+}
+
+
 static void OnNewMap(void) {
 	int i;
 	if (Server.IsSinglePlayer) return;
@@ -501,7 +1019,9 @@ static void OnInit(void) {
 	String_InitArray(Server.MOTD,    motdBuffer);
 	String_InitArray(Server.AppName, appBuffer);
 
-	if (!Server.Address.length) {
+	if (Server.ReplayPath.length) {
+		ReplayConnection_Init();
+	} else if (!Server.Address.length) {
 		SPConnection_Init();
 	} else {
 		MPConnection_Init();
@@ -526,6 +1046,11 @@ static void OnReset(void) {
 static void OnFree(void) {
 	Server.Address.length = 0;
 	OnClose();
+
+	Mem_Free(net_incoming.data);
+	Mem_Free(net_outgoing.data);
+	net_incoming.data = NULL;
+	net_outgoing.data = NULL;
 }
 
 static void OnClose(void) {
@@ -533,8 +1058,12 @@ static void OnClose(void) {
 		Physics_Free();
 	} else {
 		Ping_Reset();
-		if (Server.Disconnected) return;
+		ReplayConnection_Close();
+		if (Server.Disconnected || Server.ReplayPath.length) return;
 
+		/* Network thread must be stopped before socket is closed */
+		NetIO_Stop();
+		if (net_sendStats.stalls) NetIO_LogStats();
 		Socket_Close(net_socket);
 		Server.Disconnected = true;
 	}
@@ -61,6 +61,10 @@ CC_VAR extern struct _ServerConnectionData {
 	cc_string Address;
 	/* Port of the server if multiplayer, 0 if singleplayer. */
 	int Port;
+	/* Path of packet trace file to replay instead of connecting to a server, empty string if not replaying. */
+	cc_string ReplayPath;
+	/* Whether to replay packets as fast as possible, instead of at the speed they were recorded at. */
+	cc_bool ReplayFast;
 } Server;
 
 /* If user hasn't previously accepted url, displays a dialog asking to confirm downloading it. */
@@ -119,6 +119,31 @@ cc_result Stream_OpenFile(struct Stream* s, const cc_string* path) {
 	return res;
 }
 
+static cc_result Stream_MappedClose(struct Stream* s) {
+	Mem_FreeMapped(s->Meta.Mem.Base, s->Meta.Mem.Length);
+	return 0;
+}
+
+cc_result Stream_OpenMapped(struct Stream* s, const cc_string* path) {
+	cc_file file;
+	cc_uint32 len;
+	void* data;
+	cc_result res;
+
+	if ((res = File_Open(&file, path))) { Stream_FromFile(s, file); return res; }
+	if (File_Length(file, &len)) len = 0;
+
+	/* e.g. empty files can't be mapped, so just read them normally */
+	data = File_TryMap(file, len);
+	if (!data) { Stream_FromFile(s, file); return 0; }
+
+	/* mapping stays valid after the file is closed */
+	File_Close(file);
+	Stream_ReadonlyMemory(s, data, len);
+	s->Close = Stream_MappedClose;
+	return 0;
+}
+
 cc_result Stream_CreateFile(struct Stream* s, const cc_string* path) {
 	cc_file file;
 	cc_result res = File_Create(&file, path);
@@ -363,13 +388,7 @@ void Stream_ReadonlyBuffered(struct Stream* s, struct Stream* source, void* data
 *#########################################################################################################################*/
 static cc_result Stream_Crc32Write(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct Stream* source;
-	cc_uint32 i, crc32 = stream->Meta.CRC32.CRC32;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
-	}
-	stream->Meta.CRC32.CRC32 = crc32;
+	stream->Meta.CRC32.CRC32 = Utils_CRC32Update(stream->Meta.CRC32.CRC32, data, count);
 
 	source = stream->Meta.CRC32.Source;
 	return source->Write(source, data, count, modified);
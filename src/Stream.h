@@ -34,6 +34,7 @@ struct Stream {
 		struct { cc_uint8* Cur; cc_uint32 Left, Length; cc_uint8* Base; } Mem;
 		struct { struct Stream* Source; cc_uint32 Left, Length; } Portion;
 		struct { cc_uint8* Cur; cc_uint32 Left, Length; cc_uint8* Base; struct Stream* Source; cc_uint32 End; } Buffered;
+		struct { cc_uint8* Cur; cc_uint32 Left, Length; cc_uint8* Base; void* Scan0; int Width, Height; } DecodedPng;
 		struct { struct Stream* Source; cc_uint32 CRC32; } CRC32;
 	} Meta;
 };
@@ -47,6 +48,10 @@ void Stream_Init(struct Stream* s);
 
 /* Wrapper for File_Open() then Stream_FromFile() */
 CC_API cc_result Stream_OpenFile(struct Stream* s, const cc_string* path);
+/* Wrapper for File_Open() then File_TryMap(), allowing reading from and seeking in the mapped file. */
+/* Falls back to Stream_FromFile() when the file can't be mapped. (e.g. file is empty) */
+/* NOTE: Only use for short reads. Truncating a mapped file crashes on POSIX, and Windows locks the file while mapped. */
+CC_API cc_result Stream_OpenMapped(struct Stream* s, const cc_string* path);
 /* Wrapper for File_Create() then Stream_FromFile() */
 CC_API cc_result Stream_CreateFile(struct Stream* s, const cc_string* path);
 /* Wrapper for File_OpenOrCreate, then File_Seek(END), then Stream_FromFile() */
@@ -215,7 +215,7 @@ static cc_bool OpenCachedData(const cc_string* url, struct Stream* stream) {
 
 	String_InitArray(path, pathBuffer);
 	MakeCachePath(&path, url);
-	res = Stream_OpenFile(stream, &path);
+	res = Stream_OpenMapped(stream, &path);
 
 	if (res == ReturnCode_FileNotFound) return false;
 	if (res) { Logger_SysWarn2(res, "opening cache for", url); return false; }
@@ -301,7 +301,7 @@ static cc_result ExtractZip(struct Stream* stream) {
 	struct ZipState state;
 	Zip_Init(&state, stream);
 	state.ProcessEntry = ProcessZipEntry;
-	return Zip_Extract(&state);
+	return Zip_ExtractParallel(&state);
 }
 
 static cc_result ExtractPng(struct Stream* stream) {
@@ -340,7 +340,7 @@ static void ExtractFromFile(const cc_string* filename) {
 	String_InitArray(path, pathBuffer);
 	String_Format1(&path, TEXPACKS_DIR "/%s", filename);
 
-	res = Stream_OpenFile(&stream, &path);
+	res = Stream_OpenMapped(&stream, &path);
 	if (res) {
 		/* Game shows a dialog if default.zip is missing */
 		Game_DefaultZipMissing |= res == ReturnCode_FileNotFound
@@ -361,7 +361,86 @@ static void ExtractDefault(void) {
 	if (!String_CaselessEquals(&texPack, &defaultZip)) ExtractFromFile(&texPack);
 }
 
+/* Cached central directories of the texture packs that single files were recently extracted from */
+#define PACK_INDEX_CACHE_SIZE 3
+static struct PackIndex {
+	struct ZipIndex index;
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+} packIndices[PACK_INDEX_CACHE_SIZE];
+static int packIndexNext;
+
+static struct ZipIndex* GetPackIndex(const cc_string* path) {
+	struct PackIndex* pack;
+	int i;
+
+	for (i = 0; i < PACK_INDEX_CACHE_SIZE; i++) {
+		pack = &packIndices[i];
+		if (pack->path.buffer && String_Equals(&pack->path, path)) return &pack->index;
+	}
+
+	pack = &packIndices[packIndexNext];
+	packIndexNext = (packIndexNext + 1) % PACK_INDEX_CACHE_SIZE;
+	ZipIndex_Free(&pack->index);
+
+	String_InitArray(pack->path, pack->pathBuffer);
+	String_Copy(&pack->path, path);
+	return &pack->index;
+}
+
+/* Returns whether the given file exists in the texture pack (even if it failed to be extracted) */
+static cc_bool ExtractFileFrom(const cc_string* path, const cc_string* filename) {
+	struct InflateState inflate;
+	struct Stream stream, portion, data;
+	struct ZipIndex* index;
+	struct ZipIndexEntry* e = NULL;
+	cc_string name;
+	cc_result res;
+
+	res = Stream_OpenMapped(&stream, path);
+	if (res == ReturnCode_FileNotFound) return false;
+	if (res) { Logger_SysWarn2(res, "opening", path); return false; }
+
+	index = GetPackIndex(path);
+	if ((res = ZipIndex_Load(index, &stream))) {
+		Logger_SysWarn2(res, "inspecting", path);
+	} else if ((e = ZipIndex_Find(index, filename))) {
+		name = ZipIndex_UNSAFE_GetPath(index, e);
+		Utils_UNSAFE_GetFilename(&name);
+
+		res = ZipIndex_Open(e, &stream, &data, &portion, &inflate);
+		if (res) Logger_SysWarn2(res, "extracting", &name);
+		else Event_RaiseEntry(&TextureEvents.FileChanged, &data, &name);
+	}
+
+	res = stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "closing", path); }
+	return e != NULL;
+}
+
 static cc_bool usingDefault;
+cc_bool TexturePack_ExtractFile(const cc_string* filename) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string texPack = Game_ClassicMode ? defaultZip : defTexPack;
+	if (Gfx.LostContext) return false;
+	String_InitArray(path, pathBuffer);
+
+	/* Search in reverse order of how texture packs are extracted in TexturePack_ExtractCurrent */
+	if (!usingDefault && String_ContainsConst(&TexturePack_Url, ".zip")) {
+		MakeCachePath(&path, &TexturePack_Url);
+		if (ExtractFileFrom(&path, filename)) return true;
+	}
+
+	if (!String_CaselessEquals(&texPack, &defaultZip) && String_ContainsConst(&texPack, ".zip")) {
+		path.length = 0;
+		String_Format1(&path, TEXPACKS_DIR "/%s", &texPack);
+		if (ExtractFileFrom(&path, filename)) return true;
+	}
+
+	path.length = 0;
+	String_Format1(&path, TEXPACKS_DIR "/%s", &defaultZip);
+	return ExtractFileFrom(&path, filename);
+}
+
 void TexturePack_ExtractCurrent(cc_bool forceReload) {
 	cc_string url = TexturePack_Url;
 	struct Stream stream;
@@ -484,9 +563,11 @@ static void OnReset(void) {
 }
 
 static void OnFree(void) {
+	int i;
 	OnContextLost(NULL);
 	Atlas2D_Free();
 	TexturePack_Url.length = 0;
+	for (i = 0; i < PACK_INDEX_CACHE_SIZE; i++) { ZipIndex_Free(&packIndices[i].index); }
 }
 
 struct IGameComponent Textures_Component = {
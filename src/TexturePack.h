@@ -94,6 +94,10 @@ void TexturePack_SetDefault(const cc_string* texPack);
 /* If TexturePack_Url is empty, extracts user's default texture pack. */
 /* Otherwise extracts the cached texture pack for that URL. */
 void TexturePack_ExtractCurrent(cc_bool forceReload);
+/* Extracts only the given file (e.g. "terrain.png") from the current texture pack. */
+/* Only the central directory and that file's data are read, and the directory is cached. */
+/* Returns false if the file is not in the current texture pack (or the default texture pack). */
+cc_bool TexturePack_ExtractFile(const cc_string* filename);
 /* Checks if the texture pack currently being downloaded has completed. */
 /* If completed, then applies the downloaded texture pack and updates cache */
 void TexturePack_CheckPending(void);
@@ -39,7 +39,15 @@ int Utils_AccumulateWheelDelta(float* accumulator, float delta);
 #define Utils_AdjViewDist(value) ((int)(1.4142135f * (value)))
 
 cc_uint8 Utils_CalcSkinType(const struct Bitmap* bmp);
+/* Calculates CRC32 of the given data. */
 cc_uint32 Utils_CRC32(const cc_uint8* data, cc_uint32 length);
+/* Updates a running CRC32 with the given data, returning the new running CRC32. */
+/* NOTE: Running CRC32 starts as 0xFFFFFFFFUL, and must be xor-ed with 0xFFFFFFFFUL to get the final CRC32. */
+cc_uint32 Utils_CRC32Update(cc_uint32 crc, const cc_uint8* data, cc_uint32 length);
+/* Whether Utils_CRC32Update uses CPU instructions (e.g. PCLMULQDQ or ARMv8 CRC32) for most of the data. */
+cc_bool Utils_HasHardwareCRC32(void);
+/* Returns CRC32 of A followed by B, given CRC32 of data A, and CRC32 and length of data B. */
+cc_uint32 Utils_CRC32Combine(cc_uint32 crcA, cc_uint32 crcB, cc_uint32 lengthB);
 /* CRC32 lookup table, for faster CRC32 calculations. */
 /* NOTE: This cannot be just indexed by byte value - see Utils_CRC32 implementation. */
 extern const cc_uint32 Utils_Crc32Table[256];
@@ -10,8 +10,12 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Funcs.h"
 
 struct _WorldData World;
+static void FreeSections(void);
+static void ResetChanges(cc_bool hasMap);
+static void RecordChange(int x, int y, int z, BlockID old, BlockID now);
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -36,14 +40,80 @@ static void GenerateNewUuid(void) {
 	World.Uuid[8] |= 0x80; /* variant 2*/
 }
 
+/* Maps with at least this volume use blocks arrays backed by a temporary file */
+#define WORLD_MAPPED_VOLUME (256 * 1024 * 1024)
+static struct MappedBlocks { BlockRaw* ptr; cc_uint32 size; } mapped_blocks[4];
+/* Map decoding threads can allocate/free blocks arrays at the same time as the main thread */
+static void* mapped_mutex;
+
+BlockRaw* World_TryAllocBlocks(cc_uint32 volume) {
+	BlockRaw* blocks = NULL;
+	int i;
+	if (volume < WORLD_MAPPED_VOLUME) return (BlockRaw*)Mem_TryAllocCleared(volume, 1);
+
+	Mutex_Lock(mapped_mutex);
+	for (i = 0; i < Array_Elems(mapped_blocks); i++) {
+		if (mapped_blocks[i].ptr) continue;
+
+		blocks = (BlockRaw*)Mem_TryAllocMapped(volume);
+		if (!blocks) break;
+		mapped_blocks[i].ptr  = blocks;
+		mapped_blocks[i].size = volume;
+		break;
+	}
+	Mutex_Unlock(mapped_mutex);
+	if (!blocks) return (BlockRaw*)Mem_TryAllocCleared(volume, 1);
+
+	/* Blocks arrays are filled in from start to end when generating/loading */
+	Mem_AdviseMapped(blocks, volume, MEM_ACCESS_SEQUENTIAL);
+	return blocks;
+}
+
+void World_FreeBlocks(BlockRaw* blocks) {
+	cc_uint32 size = 0;
+	int i;
+	if (!blocks) return;
+
+	Mutex_Lock(mapped_mutex);
+	for (i = 0; i < Array_Elems(mapped_blocks); i++) {
+		if (mapped_blocks[i].ptr != blocks) continue;
+
+		size = mapped_blocks[i].size;
+		mapped_blocks[i].ptr = NULL;
+		break;
+	}
+	Mutex_Unlock(mapped_mutex);
+
+	if (size) {
+		Mem_FreeMapped(blocks, size);
+	} else {
+		Mem_Free(blocks);
+	}
+}
+
+/* Once loaded, blocks are accessed in no particular order by rendering and gameplay */
+static void AdviseRandomAccess(BlockRaw* blocks) {
+	cc_uint32 size = 0;
+	int i;
+
+	Mutex_Lock(mapped_mutex);
+	for (i = 0; i < Array_Elems(mapped_blocks); i++) {
+		if (mapped_blocks[i].ptr == blocks) size = mapped_blocks[i].size;
+	}
+	Mutex_Unlock(mapped_mutex);
+	if (size) Mem_AdviseMapped(blocks, size, MEM_ACCESS_RANDOM);
+}
+
 void World_Reset(void) {
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
+	if (World.Blocks != World.Blocks2) World_FreeBlocks(World.Blocks2);
 	World.Blocks2 = NULL;
 	World.IDMask  = 0xFF;
 #endif
-	Mem_Free(World.Blocks);
+	World_FreeBlocks(World.Blocks);
 	World.Blocks = NULL;
+	FreeSections();
+	ResetChanges(false);
 
 	World_SetDimensions(0, 0, 0);
 	World.Loaded   = false;
@@ -56,9 +126,59 @@ void World_NewMap(void) {
 	Event_RaiseVoid(&WorldEvents.NewMap);
 }
 
+#ifdef CC_BUILD_TILEDWORLD
+/* Rearranges blocks from map file order into 16x16x16 tiles, then frees the original array */
+static BlockRaw* TileBlocks(BlockRaw* blocks) {
+	BlockRaw* tiled;
+	int x, y, z, count;
+	if (!blocks) return NULL;
+
+	tiled = World_TryAllocBlocks(World.TiledVolume);
+	if (tiled) {
+		for (y = 0; y < World.Height; y++) {
+			for (z = 0; z < World.Length; z++) {
+				for (x = 0; x < World.Width; x += CHUNK_SIZE) {
+					count = min(World.Width - x, CHUNK_SIZE);
+					Mem_Copy(tiled + World_Pack(x, y, z), blocks + World_PackLinear(x, y, z), count);
+				}
+			}
+		}
+	}
+
+	World_FreeBlocks(blocks);
+	return tiled;
+}
+
+static BlockRaw* TileMap(void) {
+	BlockRaw* blocks = World.Blocks;
+	World.Blocks = TileBlocks(blocks);
+
+#ifdef EXTENDED_BLOCKS
+	/* .cw maps may have set a separate array for the upper 8 bits */
+	if (World.Blocks2 == blocks) {
+		World.Blocks2 = NULL;
+	} else if (!World.Blocks) {
+		World_FreeBlocks(World.Blocks2);
+		World.Blocks2 = NULL;
+	} else if (World.Blocks2) {
+		World.Blocks2 = TileBlocks(World.Blocks2);
+		if (!World.Blocks2) { World_FreeBlocks(World.Blocks); World.Blocks = NULL; }
+	}
+#endif
+
+	if (!World.Blocks) World_OutOfMemory();
+	return World.Blocks;
+}
+#endif
+
 void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
+#ifdef CC_BUILD_TILEDWORLD
+	World_SetDimensions(width, height, length);
+	World.Blocks = blocks;
+	if (blocks) blocks = TileMap();
+#endif
 	/* TODO: TEMP HACK */
-	if (!blocks) { width = 0; height = 0; length = 0; }
+	if (!blocks && !World.Sections) { width = 0; height = 0; length = 0; }
 
 	World_SetDimensions(width, height, length);
 	World.Blocks = blocks;
@@ -66,16 +186,22 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	if (!World.Volume) World.Blocks = NULL;
 #ifdef EXTENDED_BLOCKS
 	/* .cw maps may have set this to a non-NULL when importing */
-	if (!World.Blocks2) {
+	if (!World.Blocks2 && !World.Sections) {
 		World.Blocks2 = World.Blocks;
 		World.IDMask  = 0xFF;
 	}
 #endif
 
+	AdviseRandomAccess(World.Blocks);
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks2 != World.Blocks) AdviseRandomAccess(World.Blocks2);
+#endif
+
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
 	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
 
 	GenerateNewUuid();
+	ResetChanges(World.Volume != 0);
 	World.Loaded = true;
 	Event_RaiseVoid(&WorldEvents.MapLoaded);
 }
@@ -88,6 +214,12 @@ CC_NOINLINE void World_SetDimensions(int width, int height, int length) {
 	World.MaxX = width  - 1;
 	World.MaxY = height - 1;
 	World.MaxZ = length - 1;
+
+#ifdef CC_BUILD_TILEDWORLD
+	World.TilesX = (width  + 15) >> 4;
+	World.TilesZ = (length + 15) >> 4;
+	World.TiledVolume = World.TilesX * World.TilesZ * ((height + 15) >> 4) * 4096;
+#endif
 }
 
 #ifdef EXTENDED_BLOCKS
@@ -104,29 +236,54 @@ void World_OutOfMemory(void) {
 
 
 #ifdef EXTENDED_BLOCKS
-static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
-	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
-	if (!data) { World_OutOfMemory(); return; }
+static CC_NOINLINE cc_bool LazyInitUpper(int i, BlockID block) {
+#ifdef CC_BUILD_TILEDWORLD
+	BlockRaw* data = World_TryAllocBlocks(World.TiledVolume);
+#else
+	BlockRaw* data = World_TryAllocBlocks(World.Volume);
+#endif
+	if (!data) { World_OutOfMemory(); return false; }
 
 	World_SetMapUpper(data);
+	AdviseRandomAccess(data);
 	World.Blocks2[i] = (BlockRaw)(block >> 8);
+	return true;
 }
 
 void World_SetBlock(int x, int y, int z, BlockID block) {
-	int i = World_Pack(x, y, z);
+	BlockID old = World_GetBlock(x, y, z);
+	int i;
+
+	if (World.Sections) {
+		World_SetSectionsRow(x, y, z, &block, 1);
+		/* Sections are all freed when out of memory */
+		if (World.Sections) RecordChange(x, y, z, old, block);
+		return;
+	}
+
+	i = World_Pack(x, y, z);
 	World.Blocks[i] = (BlockRaw)block;
 
 	/* defer allocation of second map array if possible */
 	if (World.Blocks == World.Blocks2) {
-		if (block < 256) return;
-		LazyInitUpper(i, block);
-		return;
+		if (block >= 256 && !LazyInitUpper(i, block)) return;
+	} else {
+		World.Blocks2[i] = (BlockRaw)(block >> 8);
 	}
-	World.Blocks2[i] = (BlockRaw)(block >> 8);
+	RecordChange(x, y, z, old, block);
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
-	World.Blocks[World_Pack(x, y, z)] = block; 
+	BlockID old = World_GetBlock(x, y, z);
+
+	if (World.Sections) {
+		World_SetSectionsRow(x, y, z, &block, 1);
+		/* Sections are all freed when out of memory */
+		if (World.Sections) RecordChange(x, y, z, old, block);
+		return;
+	}
+	World.Blocks[World_Pack(x, y, z)] = block;
+	RecordChange(x, y, z, old, block);
 }
 #endif
 
@@ -142,6 +299,234 @@ BlockID World_SafeGetBlock(int x, int y, int z) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------------Sections---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Each section stores indices into a palette of the distinct blocks in it, packed into 1/2/4/8/16 bits per block. */
+/* Sections with only one block (e.g. all air above terrain, or all stone below it) don't allocate any memory. */
+struct WorldSection {
+	cc_uint8* data;   /* Bit-packed palette indices, NULL when every block in the section is the same */
+	BlockID* palette; /* Blocks that the palette indices refer to */
+	BlockID block;    /* Block at every position in the section, when data is NULL */
+	cc_uint16 count;  /* Number of palette entries used */
+	cc_uint8 bits;    /* Number of bits per palette index */
+};
+static int sections_x, sections_z, sections_count;
+
+#define Section_Get(x, y, z) &World.Sections[(((y) >> CHUNK_SHIFT) * sections_z + ((z) >> CHUNK_SHIFT)) * sections_x + ((x) >> CHUNK_SHIFT)]
+#define Section_Pack(x, y, z) ((((y) & CHUNK_MASK) << 8) | (((z) & CHUNK_MASK) << 4) | ((x) & CHUNK_MASK))
+#define Section_Capacity(bits) ((bits) == 16 ? BLOCK_COUNT : (1 << (bits)))
+
+static int Section_ReadIndex(const struct WorldSection* s, int i) {
+	if (s->bits == 16) return ((cc_uint16*)s->data)[i];
+
+	i *= s->bits;
+	return (s->data[i >> 3] >> (i & 7)) & ((1 << s->bits) - 1);
+}
+
+static void Section_WriteIndex(struct WorldSection* s, int i, int value) {
+	int mask;
+	if (s->bits == 16) { ((cc_uint16*)s->data)[i] = (cc_uint16)value; return; }
+
+	i   *= s->bits;
+	mask = ((1 << s->bits) - 1) << (i & 7);
+	s->data[i >> 3] = (cc_uint8)((s->data[i >> 3] & ~mask) | (value << (i & 7)));
+}
+
+/* Doubles the number of bits per palette index (uniform sections become 1 bit) */
+static cc_bool Section_Grow(struct WorldSection* s) {
+	struct WorldSection tmp;
+	int dataSize, i;
+
+	tmp.bits  = s->data ? s->bits * 2 : 1;
+	dataSize  = CHUNK_SIZE_3 * tmp.bits / 8;
+	tmp.data  = (cc_uint8*)Mem_TryAllocCleared(dataSize + Section_Capacity(tmp.bits) * sizeof(BlockID), 1);
+	if (!tmp.data) return false;
+
+	/* palette is stored directly after the indices */
+	tmp.palette = (BlockID*)(tmp.data + dataSize);
+	tmp.block   = s->block;
+
+	if (s->data) {
+		Mem_Copy(tmp.palette, s->palette, s->count * sizeof(BlockID));
+		tmp.count = s->count;
+
+		for (i = 0; i < CHUNK_SIZE_3; i++) {
+			Section_WriteIndex(&tmp, i, Section_ReadIndex(s, i));
+		}
+		Mem_Free(s->data);
+	} else {
+		/* indices are all 0 already */
+		tmp.palette[0] = s->block;
+		tmp.count      = 1;
+	}
+
+	*s = tmp;
+	return true;
+}
+
+static cc_bool Section_SetBlock(struct WorldSection* s, int i, BlockID block) {
+	int idx;
+	if (!s->data) {
+		if (s->block == block) return true;
+		if (!Section_Grow(s))  return false;
+	}
+
+	for (idx = 0; idx < s->count; idx++) {
+		if (s->palette[idx] == block) break;
+	}
+
+	if (idx == s->count) {
+		if (s->count == Section_Capacity(s->bits) && !Section_Grow(s)) return false;
+		s->palette[s->count++] = block;
+	}
+	Section_WriteIndex(s, i, idx);
+	return true;
+}
+
+static void FreeSections(void) {
+	int i;
+	if (!World.Sections) return;
+
+	for (i = 0; i < sections_count; i++) {
+		Mem_Free(World.Sections[i].data);
+	}
+	Mem_Free(World.Sections);
+	World.Sections = NULL;
+}
+
+cc_bool World_InitSections(int width, int height, int length) {
+	int sections_y;
+	sections_x = (width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	sections_y = (height + CHUNK_MAX) >> CHUNK_SHIFT;
+	sections_z = (length + CHUNK_MAX) >> CHUNK_SHIFT;
+
+	/* sections are uniform air when zeroed */
+	sections_count = sections_x * sections_y * sections_z;
+	World.Sections = (struct WorldSection*)Mem_TryAllocCleared(sections_count, sizeof(struct WorldSection));
+	if (!World.Sections) return false;
+
+	World_SetDimensions(width, height, length);
+	return true;
+}
+
+BlockID World_GetSectionsBlock(int x, int y, int z) {
+	struct WorldSection* s = Section_Get(x, y, z);
+	if (!s->data) return s->block;
+	return s->palette[Section_ReadIndex(s, Section_Pack(x, y, z))];
+}
+
+void World_GetSectionsRow(int x, int y, int z, BlockID* blocks, int count) {
+	struct WorldSection* s;
+	int i, j, n;
+
+	for (; count > 0; x += n, blocks += n, count -= n) {
+		s = Section_Get(x, y, z);
+		i = Section_Pack(x, y, z);
+		n = min(count, CHUNK_SIZE - (x & CHUNK_MASK));
+
+		if (!s->data) {
+			for (j = 0; j < n; j++) { blocks[j] = s->block; }
+		} else {
+			for (j = 0; j < n; j++) { blocks[j] = s->palette[Section_ReadIndex(s, i + j)]; }
+		}
+	}
+}
+
+void World_SetSectionsRow(int x, int y, int z, const BlockID* blocks, int count) {
+	struct WorldSection* s;
+	int i, j, n;
+
+	for (; count > 0; x += n, blocks += n, count -= n) {
+		s = Section_Get(x, y, z);
+		i = Section_Pack(x, y, z);
+		n = min(count, CHUNK_SIZE - (x & CHUNK_MASK));
+
+		for (j = 0; j < n; j++) {
+			if (!Section_SetBlock(s, i + j, blocks[j])) { World_OutOfMemory(); return; }
+#ifdef EXTENDED_BLOCKS
+			if (blocks[j] > 0xFF) World.IDMask = 0x3FF;
+#endif
+		}
+	}
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Change tracking-----------------------------------------------------*
+*#########################################################################################################################*/
+static struct WorldChange changes_journal[WORLD_MAX_CHANGES];
+static cc_uint32 changes_generation;
+/* Generation when the current map was loaded (generation is never reset) */
+static cc_uint32 changes_mapBegin;
+/* Bitset of which 16x16x16 chunks have changed */
+static cc_uint8* dirty_chunks;
+static int dirty_chunksX, dirty_chunksZ, dirty_count;
+
+#define Dirty_Index(cx, cy, cz) (((cy) * dirty_chunksZ + (cz)) * dirty_chunksX + (cx))
+
+static void ResetChanges(cc_bool hasMap) {
+	int chunksY;
+	changes_mapBegin = changes_generation;
+	Mem_Free(dirty_chunks);
+	dirty_chunks = NULL;
+	if (!hasMap) return;
+
+	dirty_chunksX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunksY       = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	dirty_chunksZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	dirty_count   = dirty_chunksX * chunksY * dirty_chunksZ;
+
+	/* Not worth failing to load the map over, World_IsChunkDirty just always returns true */
+	dirty_chunks = (cc_uint8*)Mem_TryAllocCleared((dirty_count + 7) >> 3, 1);
+}
+
+/* Called after the block has been successfully changed */
+static void RecordChange(int x, int y, int z, BlockID old, BlockID now) {
+	struct WorldChange* change;
+	int i;
+	if (old == now) return;
+
+	change = &changes_journal[changes_generation & (WORLD_MAX_CHANGES - 1)];
+	change->index    = World_Pack(x, y, z);
+	change->oldBlock = old;
+	change->newBlock = now;
+	changes_generation++;
+
+	if (!dirty_chunks) return;
+	i = Dirty_Index(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+	dirty_chunks[i >> 3] |= (cc_uint8)(1 << (i & 7));
+}
+
+cc_uint32 World_GetGeneration(void) { return changes_generation; }
+
+int World_GetChanges(cc_uint32 generation, struct WorldChange* changes, int max) {
+	cc_uint32 available = changes_generation - generation;
+	int i, count;
+	/* Generation is from before the current map was loaded */
+	if (available > changes_generation - changes_mapBegin) return -1;
+	if (available > WORLD_MAX_CHANGES) return -1;
+
+	count = min((cc_uint32)max, available);
+	for (i = 0; i < count; i++, generation++) {
+		changes[i] = changes_journal[generation & (WORLD_MAX_CHANGES - 1)];
+	}
+	return count;
+}
+
+cc_bool World_IsChunkDirty(int cx, int cy, int cz) {
+	int i;
+	if (!dirty_chunks) return true;
+
+	i = Dirty_Index(cx, cy, cz);
+	return (dirty_chunks[i >> 3] & (1 << (i & 7))) != 0;
+}
+
+void World_ClearDirtyChunks(void) {
+	if (dirty_chunks) Mem_Set(dirty_chunks, 0, (dirty_count + 7) >> 3);
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Environment-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -303,7 +688,18 @@ Vec3 Respawn_FindSpawnPosition(float x, float z, Vec3 modelSize) {
 	return spawn;
 }
 
+static void OnInit(void) {
+	mapped_mutex = Mutex_Create();
+	World_Reset();
+}
+
+static void OnFree(void) {
+	World_Reset();
+	Mutex_Free(mapped_mutex);
+	mapped_mutex = NULL;
+}
+
 struct IGameComponent World_Component = {
-	World_Reset, /* Init  */
-	World_Reset  /* Free  */
+	OnInit, /* Init  */
+	OnFree  /* Free  */
 };
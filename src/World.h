@@ -7,12 +7,33 @@
    Copyright 2014-2021 ClassiCube | Licensed under BSD-3
 */
 struct AABB;
+struct WorldSection;
 extern struct IGameComponent World_Component;
 
+/* Unpacks an index in map file order (i.e. X, then Z, then Y) into x,y,z (slow!) */
+#define World_UnpackLinear(idx, x, y, z) x = idx % World.Width; z = (idx / World.Width) % World.Length; y = (idx / World.Width) / World.Length;
+/* Packs an x,y,z into a single index in map file order (i.e. X, then Z, then Y) */
+#define World_PackLinear(x, y, z) (((y) * World.Length + (z)) * World.Width + (x))
+
+#ifdef CC_BUILD_TILEDWORLD
+/* Unpacka an index into x,y,z (slow!) */
+#define World_Unpack(idx, x, y, z) x = (((idx) >> 12) % World.TilesX) << 4 | ((idx) & 0x0F);\
+z = ((((idx) >> 12) / World.TilesX) % World.TilesZ) << 4 | (((idx) >> 4) & 0x0F);\
+y = ((((idx) >> 12) / World.TilesX) / World.TilesZ) << 4 | (((idx) >> 8) & 0x0F);
+/* Packs an x,y,z into a single index */
+/* NOTE: Blocks are stored in 16x16x16 tiles, so only blocks within a tile are laid out in X/Z/Y order */
+#define World_Pack(x, y, z) ((((((y) >> 4) * World.TilesZ + ((z) >> 4)) * World.TilesX + ((x) >> 4)) << 12)\
+| (((y) & 0x0F) << 8) | (((z) & 0x0F) << 4) | ((x) & 0x0F))
+/* Moves a packed index at the given Y coordinate to the block just below it */
+#define World_PackBelow(idx, y) (((y) & 0x0F) ? (idx) - 0x100 : (idx) - ((World.TilesX * World.TilesZ) << 12) + 0xF00)
+#else
 /* Unpacka an index into x,y,z (slow!) */
-#define World_Unpack(idx, x, y, z) x = idx % World.Width; z = (idx / World.Width) % World.Length; y = (idx / World.Width) / World.Length;
+#define World_Unpack(idx, x, y, z) World_UnpackLinear(idx, x, y, z)
 /* Packs an x,y,z into a single index */
-#define World_Pack(x, y, z) (((y) * World.Length + (z)) * World.Width + (x))
+#define World_Pack(x, y, z) World_PackLinear(x, y, z)
+/* Moves a packed index at the given Y coordinate to the block just below it */
+#define World_PackBelow(idx, y) ((idx) - World.OneY)
+#endif
 #define WORLD_UUID_LEN 16
 
 CC_VAR extern struct _WorldData {
@@ -46,8 +67,26 @@ CC_VAR extern struct _WorldData {
 	cc_bool Loaded;
 	/* Point in time the current world was last saved at */
 	double LastSave;
+	/* Palette compressed 16x16x16 sections of blocks, used instead of the flat */
+	/*  Blocks/Blocks2 arrays for maps that are too large to fit in memory. */
+	/* NOTE: When this is non-NULL, Blocks and Blocks2 are both NULL. */
+	struct WorldSection* Sections;
+#ifdef CC_BUILD_TILEDWORLD
+	/* Number of 16x16x16 tiles along the X and Z axes. */
+	int TilesX, TilesZ;
+	/* Number of elements in Blocks/Blocks2, including padding in partial tiles. */
+	int TiledVolume;
+#endif
 } World;
 
+/* Allocates a blocks array for a map of the given volume, with contents of all 0. */
+/* Very large arrays are backed by a temporary file when possible, so that only the */
+/*  parts of the map being accessed need to be resident in memory. */
+/* Returns NULL if there is not enough memory to allocate the array. */
+CC_API BlockRaw* World_TryAllocBlocks(cc_uint32 volume);
+/* Frees an array allocated by World_TryAllocBlocks. Does nothing when passed NULL. */
+CC_API void World_FreeBlocks(BlockRaw* blocks);
+
 /* Frees the blocks array, sets dimensions to 0, resets environment to default. */
 void World_Reset(void);
 /* Sets up state and raises WorldEvents.NewMap event */
@@ -55,12 +94,26 @@ void World_Reset(void);
 CC_API void World_NewMap(void);
 /* Sets blocks array/dimensions of the map and raises WorldEvents.MapLoaded event */
 /* May also sets some environment settings like border/clouds height, if they are -1 */
+/* NOTE: blocks must be in map file order. (see World_PackLinear) */
 CC_API void World_SetNewMap(BlockRaw* blocks, int width, int height, int length);
 /* Sets the various dimension and max coordinate related variables. */
 /* NOTE: This is an internal API. Use World_SetNewMap instead. */
 CC_NOINLINE void World_SetDimensions(int width, int height, int length);
 void World_OutOfMemory(void);
 
+/* Switches to storing blocks in palette compressed sections, with every block initially air. */
+/* Returns false if there is not enough memory to allocate the sections table. */
+/* NOTE: This is an internal API. Call World_SetNewMap with NULL blocks afterwards. */
+cc_bool World_InitSections(int width, int height, int length);
+/* Gets the blocks in the row from (x, y, z) to (x + count - 1, y, z) from the sections. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+void World_GetSectionsRow(int x, int y, int z, BlockID* blocks, int count);
+/* Sets the blocks in the row from (x, y, z) to (x + count - 1, y, z) in the sections. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+void World_SetSectionsRow(int x, int y, int z, const BlockID* blocks, int count);
+/* Gets the block at the given coordinates from the sections. */
+BlockID World_GetSectionsBlock(int x, int y, int z);
+
 #ifdef EXTENDED_BLOCKS
 /* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
 void World_SetMapUpper(BlockRaw* blocks);
@@ -68,13 +121,35 @@ void World_SetMapUpper(BlockRaw* blocks);
 /* Gets the block at the given coordinates. */
 /* NOTE: Does NOT check that the coordinates are inside the map. */
 static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
-	int i = World_Pack(x, y, z);
+	int i;
+	if (World.Sections) return World_GetSectionsBlock(x, y, z);
+
+	i = World_Pack(x, y, z);
 	return (BlockID)((World.Blocks[i] | (World.Blocks2[i] << 8)) & World.IDMask);
 }
 #else
-#define World_GetBlock(x, y, z) World_Blocks[World_Pack(x, y, z)]
+#define World_GetBlock(x, y, z) (World.Sections ? World_GetSectionsBlock(x, y, z) : World.Blocks[World_Pack(x, y, z)])
 #endif
 
+/* Maximum number of block changes kept in the change journal. */
+#define WORLD_MAX_CHANGES 4096
+/* A block change recorded in the change journal. */
+struct WorldChange { int index; BlockID oldBlock, newBlock; };
+
+/* Returns number of blocks changed by World_SetBlock. */
+/* NOTE: Keeps increasing across maps, so generations from an older map are never reused. */
+/* A change made at generation N is the change that made the generation become N + 1. */
+CC_API cc_uint32 World_GetGeneration(void);
+/* Copies up to max changes made from the given generation onwards into changes. */
+/* Returns number of changes copied, or -1 if changes from that generation onwards */
+/*  are no longer all in the journal, or the generation is from before the current map */
+/*  was loaded. (in either case everything should be treated as changed) */
+CC_API int World_GetChanges(cc_uint32 generation, struct WorldChange* changes, int max);
+/* Whether any blocks in the given 16x16x16 chunk have changed since World_ClearDirtyChunks. */
+CC_API cc_bool World_IsChunkDirty(int cx, int cy, int cz);
+/* Resets every chunk to not being dirty. */
+CC_API void World_ClearDirtyChunks(void);
+
 /* If Y is above the map, returns BLOCK_AIR. */
 /* If coordinates are outside the map, returns BLOCK_AIR. */
 /* Otherwise returns the block at the given coordinates. */